@@ -0,0 +1,139 @@
+#include <memory>
+#include <vector>
+#include <dirent.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <cstring>
+
+#include <rlottie.h>
+
+static bool isJsonFile(const char *filename) {
+  const char *dot = strrchr(filename, '.');
+  if(!dot || dot == filename) return false;
+  return !strcmp(dot + 1, "json");
+}
+
+static std::vector<std::string>
+jsonFiles(const std::string &dirName)
+{
+    DIR *d;
+    struct dirent *dir;
+    std::vector<std::string> result;
+    d = opendir(dirName.c_str());
+    if (d) {
+      while ((dir = readdir(d)) != NULL) {
+        if (isJsonFile(dir->d_name))
+          result.push_back(dir->d_name);
+      }
+      closedir(d);
+    }
+
+    std::sort(result.begin(), result.end(), [](auto & a, auto &b){return a < b;});
+
+    return result;
+}
+
+template <typename Func>
+static double measure(size_t iterations, Func &&func)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (auto i = 0u; i < iterations; i++) func();
+    std::chrono::duration<double, std::milli> millisecs =
+        std::chrono::high_resolution_clock::now() - start;
+    return millisecs.count() / iterations;
+}
+
+class LoadTest
+{
+public:
+    LoadTest(std::string resourceDir, std::string outputDir, size_t iterations):
+        _resourceDir(std::move(resourceDir)), _outputDir(std::move(outputDir)),
+        _iterations(iterations)
+    {
+        _resourceList = jsonFiles(_resourceDir);
+    }
+    void test()
+    {
+        double jsonTotal = 0;
+        double binaryTotal = 0;
+        size_t count = 0;
+
+        std::cout<<" Test Started : .... \n\n";
+        for (const auto &name : _resourceList) {
+            auto jsonPath = _resourceDir + name;
+            auto binaryPath = _outputDir + name + ".bin";
+
+            auto animation = rlottie::Animation::loadFromFile(jsonPath, false);
+            if (!animation || !animation->saveBinary(binaryPath)) continue;
+
+            auto json = measure(_iterations, [&]() {
+                rlottie::Animation::loadFromFile(jsonPath, false);
+            });
+            auto binary = measure(_iterations, [&]() {
+                rlottie::Animation::loadFromBinary(binaryPath, false);
+            });
+            jsonTotal += json;
+            binaryTotal += binary;
+            count++;
+
+            std::cout<< " \t "<< name << " : json "<< json <<"ms, binary "
+                     << binary <<"ms, speedup "<< json / binary <<"x\n";
+        }
+        if (!count) {
+            std::cout<< " No resource found in "<< _resourceDir <<"\n";
+            return;
+        }
+        std::cout<< " Test Finished.\n";
+        std::cout<< " \nPerformance Report: \n\n";
+        std::cout<< " \t Resources Loaded            : "<< count <<"\n";
+        std::cout<< " \t Iterations per Resource     : "<< _iterations <<"\n";
+        std::cout<< " \t Avrage Json Load Time       : "<< jsonTotal / count <<"ms\n";
+        std::cout<< " \t Avrage Binary Load Time     : "<< binaryTotal / count <<"ms\n";
+        std::cout<< " \t Speedup                     : "<< jsonTotal / binaryTotal <<"x\n\n";
+    }
+
+private:
+    std::string              _resourceDir;
+    std::string              _outputDir;
+    size_t                   _iterations;
+    std::vector<std::string> _resourceList;
+};
+
+static int help()
+{
+    std::cout<<"\nUsage : ./binaryperf [-d] [resource dir] [-o] [output dir] [-i] [iteration count] \n";
+    std::cout<<"\nExample : ./binaryperf -i 50 \n";
+    std::cout<<"\n\t compares json and binary model load time of every resource, 50 loads each\n\n";
+    return 0;
+}
+
+int
+main(int argc, char ** argv)
+{
+    std::string resourceDir = DEMO_DIR;
+    std::string outputDir = "/tmp/";
+    size_t iterations = 20;
+    auto index = 0;
+
+    while (index < argc) {
+      const char* option = argv[index];
+      index++;
+      if (!strcmp(option,"--help") || !strcmp(option,"-h")) {
+          return help();
+      } else if (!strcmp(option,"-d")) {
+         resourceDir = (index < argc) ? std::string(argv[index]) + "/" : resourceDir;
+         index++;
+      } else if (!strcmp(option,"-o")) {
+         outputDir = (index < argc) ? std::string(argv[index]) + "/" : outputDir;
+         index++;
+      } else if (!strcmp(option,"-i")) {
+         iterations = (index < argc) ? atoi(argv[index]) : iterations;
+         index++;
+      }
+   }
+
+    LoadTest obj(resourceDir, outputDir, iterations ? iterations : 1);
+    obj.test();
+    return 0;
+}
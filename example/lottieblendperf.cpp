@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Measures the throughput of the span blend functions for every
+ * instruction set the cpu supports, with the scalar version as the
+ * baseline. Spans have the given length and a source mixing transparent,
+ * opaque and translucent pixels like a typical layer.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "vdrawhelper.h"
+
+struct Target {
+    const char *    name;
+    RenderFuncTable table;
+};
+
+static uint32_t pixel(std::mt19937 &rng)
+{
+    uint32_t r = rng();
+    if (r % 4 == 0) return 0;
+    if (r % 4 == 1) return r | 0xff000000;
+    uint32_t a = r >> 24;
+    return (a << 24) | BYTE_MUL(r & 0x00ffffff, a);
+}
+
+// megapixels per second
+template <typename Func>
+static double measure(Func func, size_t length, size_t pixels)
+{
+    size_t spans = pixels / length + 1;
+    auto   start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < spans; i++) func(i);
+    std::chrono::duration<double, std::micro> microsecs =
+        std::chrono::high_resolution_clock::now() - start;
+    return double(spans * length) / microsecs.count();
+}
+
+static int help()
+{
+    std::cout<<"\nUsage : ./blendperf [-l] [span length] [-a] [const alpha] [-m] [megapixels]\n";
+    std::cout<<"\nExample : ./blendperf -l 64 -a 255 -m 200 \n";
+    std::cout<<"\n\t blends 200 megapixels in spans of 64 pixels with each function and reports the throughput\n\n";
+    return 0;
+}
+
+int
+main(int argc, char ** argv)
+{
+    size_t length = 64;
+    uint32_t alpha = 255;
+    size_t pixels = 200;
+    auto index = 0;
+
+    while (index < argc) {
+      const char* option = argv[index];
+      index++;
+      if (!strcmp(option,"--help") || !strcmp(option,"-h")) {
+          return help();
+      } else if (!strcmp(option,"-l")) {
+         length = (index < argc) ? atoi(argv[index]) : length;
+         index++;
+      } else if (!strcmp(option,"-a")) {
+         alpha = (index < argc) ? atoi(argv[index]) : alpha;
+         index++;
+      } else if (!strcmp(option,"-m")) {
+         pixels = (index < argc) ? atoi(argv[index]) : pixels;
+         index++;
+      }
+   }
+   if (!length) length = 1;
+   if (alpha > 255) alpha = 255;
+   pixels *= 1000000;
+
+    std::vector<Target> targets;
+    uint32_t cpu = vCpuFeatures();
+    targets.push_back({"scalar", RenderFuncTable(0)});
+    if (cpu & CpuFeature::SSE2)
+        targets.push_back({"sse2", RenderFuncTable(CpuFeature::SSE2)});
+    if (cpu & CpuFeature::NEON)
+        targets.push_back({"neon", RenderFuncTable(CpuFeature::NEON)});
+    if (cpu & CpuFeature::AVX2)
+        targets.push_back({"avx2", RenderFuncTable(cpu)});
+
+    // a few buffers so the spans start at different alignments
+    const size_t count = 64;
+    std::mt19937 rng(1234);
+    std::vector<uint32_t> src((length + 8) * count), dest((length + 8) * count);
+    for (auto &e : src) e = pixel(rng);
+    for (auto &e : dest) e = pixel(rng);
+    auto offset = [&](size_t i) { return (i % count) * (length + 8) + i % 8; };
+
+    const struct {
+        const char *name;
+        BlendMode   mode;
+    } modes[] = {{"Src", BlendMode::Src},
+                 {"SrcOver", BlendMode::SrcOver},
+                 {"DestIn", BlendMode::DestIn},
+                 {"DestOut", BlendMode::DestOut}};
+
+    std::cout<< " \nPerformance Report: spans of "<< length
+             <<" pixels, const alpha "<< alpha <<", Mpixels/s\n\n";
+    printf("\t %-16s", "function");
+    for (auto &t : targets) printf("%10s", t.name);
+    printf("\n");
+
+    for (auto &m : modes) {
+        printf("\t color_%-10s", m.name);
+        for (auto &t : targets) {
+            auto func = t.table.color(m.mode);
+            printf("%10.0f", measure([&](size_t i) {
+                func(&dest[offset(i)], int(length), src[i % src.size()], alpha);
+            }, length, pixels));
+        }
+        printf("\n\t src_%-12s", m.name);
+        for (auto &t : targets) {
+            auto func = t.table.src(m.mode);
+            printf("%10.0f", measure([&](size_t i) {
+                func(&dest[offset(i)], int(length), &src[offset(i + 3)], alpha);
+            }, length, pixels));
+        }
+        printf("\n");
+    }
+
+    // a gradient spanning 256 pixels, radial ones around the span start
+    std::vector<uint32_t> table(VGradient::colorTableSize);
+    for (auto &e : table) e = pixel(rng);
+    VGradientData        gradient;
+    RadialGradientValues radial;
+    gradient.mSpread = VGradient::Spread::Pad;
+    gradient.mColorTable = table.data();
+    gradient.radial.fradius = 0;
+    radial.dr = 1;
+    radial.extended = false;
+
+    printf("\t %-16s", "linear gradient");
+    for (auto &t : targets) {
+        auto func = t.table.linear();
+        printf("%10.0f", measure([&](size_t i) {
+            func(&dest[offset(i)], int(length), &gradient, int(i % 64) * 64, 1024);
+        }, length, pixels));
+    }
+    printf("\n\t %-16s", "radial gradient");
+    for (auto &t : targets) {
+        auto func = t.table.radial();
+        printf("%10.0f", measure([&](size_t i) {
+            func(&dest[offset(i)], int(length), &gradient, &radial,
+                 float(i % 64) / 4096, 0.0001f, 0.00001f, 0, 0);
+        }, length, pixels));
+    }
+    printf("\n");
+
+    // memfill32 picks its implementation itself, compare with std::fill_n.
+    printf("\n\t %-16s%10.0f\n", "std::fill_n", measure([&](size_t i) {
+        std::fill_n(&dest[offset(i)], length, src[i % src.size()]);
+    }, length, pixels));
+    printf("\t %-16s%10.0f", "memfill32", measure([&](size_t i) {
+        memfill32(&dest[offset(i)], src[i % src.size()], int(length));
+    }, length, pixels));
+    printf("\n\n");
+    return 0;
+}
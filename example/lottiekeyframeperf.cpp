@@ -0,0 +1,109 @@
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <cstring>
+
+#include <rlottie.h>
+
+/*
+ * Measures the cost of keyframe lookup against the number of keyframes.
+ * The generated animation has a shape layer with many groups whose rotation
+ * is animated with the given number of keyframes, so updating a frame is
+ * dominated by finding the current keyframe of each group.
+ */
+static std::string
+animationJson(size_t keyFrames, size_t groups)
+{
+    std::ostringstream rotation;
+    rotation<<"[";
+    for (size_t i = 0; i < keyFrames; i++) {
+        rotation<<"{\"i\":{\"x\":[0.833],\"y\":[0.833]},\"o\":{\"x\":[0.167],\"y\":[0.167]},"
+                <<"\"t\":"<< i <<",\"s\":["<< (i % 2) * 90 <<"]},";
+    }
+    rotation<<"{\"t\":"<< keyFrames <<"}]";
+
+    std::ostringstream group;
+    group<<"{\"ty\":\"gr\",\"it\":["
+         <<"{\"ty\":\"rc\",\"d\":1,\"s\":{\"a\":0,\"k\":[10,10]},\"p\":{\"a\":0,\"k\":[0,0]},\"r\":{\"a\":0,\"k\":0}},"
+         <<"{\"ty\":\"fl\",\"c\":{\"a\":0,\"k\":[1,0,0,1]},\"o\":{\"a\":0,\"k\":100}},"
+         <<"{\"ty\":\"tr\",\"p\":{\"a\":0,\"k\":[50,50]},\"a\":{\"a\":0,\"k\":[0,0]},\"s\":{\"a\":0,\"k\":[100,100]},"
+         <<"\"r\":{\"a\":1,\"k\":"<< rotation.str() <<"},\"o\":{\"a\":0,\"k\":100}}]}";
+
+    std::ostringstream json;
+    json<<"{\"v\":\"5.5.2\",\"fr\":60,\"ip\":0,\"op\":"<< keyFrames <<",\"w\":100,\"h\":100,"
+        <<"\"layers\":[{\"ddd\":0,\"ind\":1,\"ty\":4,\"nm\":\"shape\",\"sr\":1,"
+        <<"\"ks\":{\"o\":{\"a\":0,\"k\":100},\"r\":{\"a\":0,\"k\":0},\"p\":{\"a\":0,\"k\":[0,0]},"
+        <<"\"a\":{\"a\":0,\"k\":[0,0]},\"s\":{\"a\":0,\"k\":[100,100]}},"
+        <<"\"ip\":0,\"op\":"<< keyFrames <<",\"st\":0,\"shapes\":[";
+    for (size_t i = 0; i < groups; i++) {
+        json<<(i ? "," : "")<<group.str();
+    }
+    json<<"]}]}";
+    return json.str();
+}
+
+static double
+measure(rlottie::Animation &animation, const std::vector<size_t> &frames, size_t iterations)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (auto i = 0u; i < iterations; i++) {
+        for (auto frame : frames) animation.renderTree(frame, 100, 100);
+    }
+    std::chrono::duration<double, std::micro> microsecs =
+        std::chrono::high_resolution_clock::now() - start;
+    return microsecs.count() / (iterations * frames.size());
+}
+
+static int help()
+{
+    std::cout<<"\nUsage : ./keyframeperf [-g] [group count] [-i] [iteration count] \n";
+    std::cout<<"\nExample : ./keyframeperf -g 100 -i 5 \n";
+    std::cout<<"\n\t updates every frame 5 times, for an animation with 100 groups\n\n";
+    return 0;
+}
+
+int
+main(int argc, char ** argv)
+{
+    size_t groups = 50;
+    size_t iterations = 3;
+    auto index = 0;
+
+    while (index < argc) {
+      const char* option = argv[index];
+      index++;
+      if (!strcmp(option,"--help") || !strcmp(option,"-h")) {
+          return help();
+      } else if (!strcmp(option,"-g")) {
+         groups = (index < argc) ? atoi(argv[index]) : groups;
+         index++;
+      } else if (!strcmp(option,"-i")) {
+         iterations = (index < argc) ? atoi(argv[index]) : iterations;
+         index++;
+      }
+   }
+    if (!groups || !iterations) return help();
+
+    std::cout<<" \nKeyframe Lookup Report ("<< groups <<" properties, time per frame update): \n\n";
+    std::cout<<" \t Keyframes \t Sequential \t Random\n";
+    for (size_t keyFrames = 2; keyFrames <= 4096; keyFrames *= 4) {
+        auto animation = rlottie::Animation::loadFromData(animationJson(keyFrames, groups),
+                                                          "keyframeperf", "", false);
+        if (!animation) continue;
+
+        std::vector<size_t> frames(animation->totalFrame());
+        for (size_t i = 0; i < frames.size(); i++) frames[i] = i;
+        auto sequential = measure(*animation, frames, iterations);
+
+        std::shuffle(frames.begin(), frames.end(), std::mt19937(keyFrames));
+        auto random = measure(*animation, frames, iterations);
+
+        std::cout<<" \t "<< keyFrames <<" \t\t "<< sequential <<"us \t "<< random <<"us\n";
+    }
+    std::cout<<"\n";
+    return 0;
+}
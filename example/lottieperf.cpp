@@ -1,13 +1,39 @@
 #include <memory>
 #include <vector>
 #include <dirent.h>
+#include <sys/resource.h>
 #include <algorithm>
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <sstream>
 #include <cstring>
 
 #include <rlottie.h>
 
+/*
+ * Benchmark suite of the library. For every resource it measures the parse
+ * time, the latency of the first frame and the p50/p99 latency of the
+ * following frames at several surface sizes. It then renders a number of
+ * animations together, synchronously and asynchronously, and reports the
+ * latency of a whole round and the peak RSS of the process.
+ *
+ * Results are written as JSON with one metric per line so two runs can be
+ * diffed. Given a baseline, the metrics that got slower by more than the
+ * tolerance are reported and the exit code is 1, which lets a CI job catch
+ * regressions against a saved run.
+ */
+using Clock = std::chrono::steady_clock;
+
+static double elapsedMs(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start)
+        .count();
+}
+
 static bool isJsonFile(const char *filename) {
   const char *dot = strrchr(filename, '.');
   if(!dot || dot == filename) return false;
@@ -24,7 +50,7 @@ jsonFiles(const std::string &dirName)
     if (d) {
       while ((dir = readdir(d)) != NULL) {
         if (isJsonFile(dir->d_name))
-          result.push_back(dirName + dir->d_name);
+          result.push_back(dir->d_name);
       }
       closedir(d);
     }
@@ -34,127 +60,307 @@ jsonFiles(const std::string &dirName)
     return result;
 }
 
-class Renderer
+static std::string readFile(const std::string &path)
+{
+    std::ifstream     f(path);
+    std::stringstream buf;
+    buf << f.rdbuf();
+    return buf.str();
+}
+
+// peak resident set size of the process in KiB.
+static long peakRss()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+static double percentile(std::vector<double> samples, double p)
 {
+    if (samples.empty()) return 0;
+    std::sort(samples.begin(), samples.end());
+    size_t rank = size_t(p / 100.0 * double(samples.size() - 1) + 0.5);
+    return samples[std::min(rank, samples.size() - 1)];
+}
+
+struct Size {
+    const char *name;
+    size_t      width;
+    size_t      height;
+};
+
+static const Size sizes[] = {
+    {"100", 100, 100}, {"512", 512, 512}, {"1080p", 1920, 1080}};
+
+class Buffer {
 public:
-    explicit Renderer(const std::string& filename)
-    {
-        _animation = rlottie::Animation::loadFromFile(filename);
-        _frames = _animation->totalFrame();
-        _buffer = std::make_unique<uint32_t[]>(100 * 100);
-        _surface = rlottie::Surface(_buffer.get(), 100, 100, 100 * 4);
-    }
-    void render()
-    {
-        if (_cur >= _frames) _cur = 0;
-        _animation->renderSync(_cur++, _surface);
-    }
-    void renderAsync()
-    {
-        if (_cur >= _frames) _cur = 0;
-        _future = _animation->render(_cur++, _surface);
-    }
-    void get()
+    explicit Buffer(const Size &size)
+        : _data(std::make_unique<uint32_t[]>(size.width * size.height)),
+          _surface(_data.get(), size.width, size.height, size.width * 4)
     {
-        if (_future.valid()) _future.get();
     }
+    rlottie::Surface &surface() { return _surface; }
+
 private:
-    std::unique_ptr<uint32_t[]>         _buffer;
-    std::unique_ptr<rlottie::Animation> _animation;
-    size_t                              _frames{0};
-    size_t                              _cur{0};
-    rlottie::Surface                   _surface;
-    std::future<rlottie::Surface>      _future;
+    std::unique_ptr<uint32_t[]> _data;
+    rlottie::Surface            _surface;
 };
 
-class PerfTest
+class PerfSuite
 {
 public:
-    explicit PerfTest(size_t resourceCount, size_t iterations):
-        _resourceCount(resourceCount), _iterations(iterations)
+    PerfSuite(std::string dir, size_t frames, size_t concurrent,
+              std::string filter)
+        : _dir(std::move(dir)), _frames(frames), _concurrent(concurrent)
+    {
+        for (const auto &name : jsonFiles(_dir)) {
+            if (filter.empty() || name.find(filter) != std::string::npos)
+                _resources.push_back(name);
+        }
+    }
+
+    void run()
     {
-        _resourceList = jsonFiles(std::string(DEMO_DIR));
+        for (const auto &name : _resources) {
+            std::cerr << " " << name << "\n";
+            resource(name);
+        }
+        for (const auto &size : sizes) {
+            std::cerr << " concurrent " << size.name << "\n";
+            concurrent(size, false);
+            concurrent(size, true);
+        }
+        _peakRss = peakRss();
     }
-    void test(bool async)
+
+    void write(std::ostream &out) const
     {
-        setup();
-        std::cout<<" Test Started : .... \n";
-        auto start = std::chrono::high_resolution_clock::now();
-        benchmark(async);
-        std::chrono::duration<double> secs = std::chrono::high_resolution_clock::now() - start;
-        std::chrono::duration<double, std::milli> millisecs = secs;
-        std::cout<< " Test Finished.\n";
-        std::cout<< " \nPerformance Report: \n\n";
-        std::cout<< " \t Resource Rendered per Frame : "<< _resourceCount <<"\n";
-        std::cout<< " \t Render Buffer Size          : (100 X 100) \n";
-        std::cout<< " \t Render Mode                 : "<< (async ? "Async" : "Sync")<<"\n";
-        std::cout<< " \t Total Frames Rendered       : "<< _iterations<<"\n";
-        std::cout<< " \t Total Render Time           : "<< secs.count()<<"sec\n";
-        std::cout<< " \t Avrage Time per Resource    : "<< millisecs.count() / (_iterations * _resourceCount)<<"ms\n";
-        std::cout<< " \t Avrage Time Per Frame       : "<< millisecs.count() / _iterations <<"ms\n";
-        std::cout<< " \t FPS                         : "<< _iterations / secs.count() <<"fps\n\n";
+        out << "{\n";
+        out << "  \"config\": {\"frames\": " << _frames
+            << ", \"concurrent\": " << _concurrent
+            << ", \"resources\": " << _resources.size() << "},\n";
+        out << "  \"peak_rss_kb\": " << _peakRss << ",\n";
+        out << "  \"metrics\": {\n";
+        const char *sep = "";
+        for (const auto &m : _metrics) {
+            char value[32];
+            snprintf(value, sizeof(value), "%.4f", m.second);
+            out << sep << "    \"" << m.first << "\": " << value;
+            sep = ",\n";
+        }
+        out << "\n  }\n}\n";
     }
+
+    const std::map<std::string, double> &metrics() const { return _metrics; }
+
 private:
-    void setup()
+    void resource(const std::string &name)
     {
-        for (auto i = 0u; i < _resourceCount; i++) {
-            auto index = i % _resourceList.size();
-            _renderers.push_back(std::make_unique<Renderer>(_resourceList[index]));
+        std::string json = readFile(_dir + name);
+
+        // best of a few runs, the model cache is bypassed.
+        double parse = 0;
+        for (int i = 0; i < 3; i++) {
+            auto start = Clock::now();
+            auto animation =
+                rlottie::Animation::loadFromData(json, name, _dir, false);
+            double ms = elapsedMs(start);
+            if (!animation) return;
+            parse = i ? std::min(parse, ms) : ms;
+        }
+        _metrics["parse_ms/" + name] = parse;
+
+        for (const auto &size : sizes) {
+            auto animation =
+                rlottie::Animation::loadFromData(json, name, _dir, false);
+            Buffer buffer(size);
+            size_t total = std::max<size_t>(1, animation->totalFrame());
+
+            auto start = Clock::now();
+            animation->renderSync(0, buffer.surface());
+            _metrics["first_frame_ms/" + name + "/" + size.name] =
+                elapsedMs(start);
+
+            std::vector<double> samples;
+            for (size_t i = 1; i <= _frames; i++) {
+                start = Clock::now();
+                animation->renderSync(i % total, buffer.surface());
+                samples.push_back(elapsedMs(start));
+            }
+            std::string key = name + "/" + size.name;
+            _metrics["frame_p50_ms/" + key] = percentile(samples, 50);
+            _metrics["frame_p99_ms/" + key] = percentile(samples, 99);
         }
     }
 
-    void benchmark(bool async)
+    // renders _concurrent animations per round, one after the other or
+    // all at once on the render threads.
+    void concurrent(const Size &size, bool async)
     {
-        for (auto i = 0u; i < _iterations; i++) {
+        if (_resources.empty()) return;
+
+        std::vector<std::unique_ptr<rlottie::Animation>> animations;
+        std::vector<std::unique_ptr<Buffer>>             buffers;
+        for (size_t i = 0; i < _concurrent; i++) {
+            auto name = _resources[i % _resources.size()];
+            auto animation = rlottie::Animation::loadFromFile(_dir + name);
+            if (!animation) continue;
+            animations.push_back(std::move(animation));
+            buffers.push_back(std::make_unique<Buffer>(size));
+        }
+
+        std::vector<double>                        samples;
+        std::vector<std::future<rlottie::Surface>> futures(animations.size());
+        auto                                       begin = Clock::now();
+        for (size_t frame = 0; frame < _frames; frame++) {
+            auto start = Clock::now();
+            for (size_t i = 0; i < animations.size(); i++) {
+                size_t no =
+                    frame % std::max<size_t>(1, animations[i]->totalFrame());
+                if (async) {
+                    futures[i] = animations[i]->render(
+                        no, std::move(buffers[i]->surface()));
+                } else {
+                    animations[i]->renderSync(no, buffers[i]->surface());
+                }
+            }
             if (async) {
-                for (const auto &e : _renderers) e->renderAsync();
-                for (const auto &e : _renderers) e->get();
-            } else {
-                for (const auto &e : _renderers) e->render();
+                for (size_t i = 0; i < animations.size(); i++)
+                    buffers[i]->surface() = futures[i].get();
             }
+            samples.push_back(elapsedMs(start));
         }
-    }
+        double seconds = elapsedMs(begin) / 1000.0;
 
-private:
-    size_t  _resourceCount;
-    size_t  _iterations;
+        std::string key = std::string(async ? "async/" : "sync/") + size.name;
+        _metrics["round_p50_ms/" + key] = percentile(samples, 50);
+        _metrics["round_p99_ms/" + key] = percentile(samples, 99);
+        _metrics["fps/" + key] =
+            double(_frames * animations.size()) / seconds;
+    }
 
-    std::vector<std::string>                 _resourceList;
-    std::vector<std::unique_ptr<Renderer>>   _renderers;
+    std::string                   _dir;
+    size_t                        _frames;
+    size_t                        _concurrent;
+    std::vector<std::string>      _resources;
+    std::map<std::string, double> _metrics;
+    long                          _peakRss{0};
 };
 
+// reads the metrics back from a file written by PerfSuite::write().
+static std::map<std::string, double> readMetrics(const std::string &path)
+{
+    std::map<std::string, double> result;
+    std::string                   json = readFile(path);
+    auto                          pos = json.find("\"metrics\"");
+    if (pos == std::string::npos) return result;
+
+    std::istringstream in(json.substr(pos + 9));
+    std::string        line;
+    while (std::getline(in, line)) {
+        auto open = line.find('"');
+        if (open == std::string::npos) continue;
+        auto close = line.find('"', open + 1);
+        auto colon = line.find(':', close);
+        if (close == std::string::npos || colon == std::string::npos)
+            continue;
+        result[line.substr(open + 1, close - open - 1)] =
+            atof(line.c_str() + colon + 1);
+    }
+    return result;
+}
+
+// a metric regressed if it got worse by more than tolerance percent,
+// fps is the only metric where higher is better.
+static int compare(const std::map<std::string, double> &baseline,
+                   const std::map<std::string, double> &current,
+                   double                               tolerance)
+{
+    int regressions = 0;
+    for (const auto &m : current) {
+        auto base = baseline.find(m.first);
+        if (base == baseline.end() || base->second <= 0) continue;
+
+        bool   higherIsBetter = m.first.compare(0, 4, "fps/") == 0;
+        double change = (m.second - base->second) / base->second * 100.0;
+        if (higherIsBetter) change = -change;
+        if (change > tolerance) {
+            std::cerr << " regression " << m.first << " : " << base->second
+                      << " -> " << m.second << " (+" << change << "%)\n";
+            regressions++;
+        }
+    }
+    std::cerr << " " << regressions << " regressions over " << tolerance
+              << "%\n";
+    return regressions ? 1 : 0;
+}
+
 static int help()
 {
-    std::cout<<"\nUsage : ./perf [--sync] [-c] [resource count] [-i] [iteration count] \n";
-    std::cout<<"\nExample : ./perf -c 50 -i 100 \n";
-    std::cout<<"\n\t runs perf test for 100 iterations. renders 50 resource per iteration\n\n";
+    std::cout<<"\nUsage : ./perf [-d dir] [-r filter] [-f frames] [-c concurrent] [-o out.json] [-b baseline.json] [-t tolerance%] \n";
+    std::cout<<"\nExample : ./perf -f 60 -o run.json -b baseline.json -t 10 \n";
+    std::cout<<"\n\t measures every resource of the directory over 60 frames, writes the\n";
+    std::cout<<"\t results to run.json and fails if a metric is 10% worse than in baseline.json\n\n";
     return 0;
 }
+
 int
 main(int argc, char ** argv)
 {
-    bool async = true;
-    size_t resourceCount = 250;
-    size_t iterations = 500;
-    auto index = 0;
+    std::string dir = DEMO_DIR;
+    std::string filter;
+    std::string output;
+    std::string baseline;
+    size_t frames = 30;
+    size_t concurrent = 8;
+    double tolerance = 10;
+    auto index = 1;
 
     while (index < argc) {
       const char* option = argv[index];
+      const char* value = (index + 1 < argc) ? argv[index + 1] : nullptr;
       index++;
       if (!strcmp(option,"--help") || !strcmp(option,"-h")) {
           return help();
-      } else if (!strcmp(option,"--sync")) {
-          async = false;
+      } else if (!value) {
+          return help();
+      } else if (!strcmp(option,"-d")) {
+          dir = value;
+          if (dir.back() != '/') dir += '/';
+      } else if (!strcmp(option,"-r")) {
+          filter = value;
+      } else if (!strcmp(option,"-f")) {
+          frames = std::max(1, atoi(value));
       } else if (!strcmp(option,"-c")) {
-         resourceCount = (index < argc) ? atoi(argv[index]) : resourceCount;
-         index++;
-      } else if (!strcmp(option,"-i")) {
-         iterations = (index < argc) ? atoi(argv[index]) : iterations;
-         index++;
+          concurrent = std::max(1, atoi(value));
+      } else if (!strcmp(option,"-o")) {
+          output = value;
+      } else if (!strcmp(option,"-b")) {
+          baseline = value;
+      } else if (!strcmp(option,"-t")) {
+          tolerance = atof(value);
+      } else {
+          return help();
       }
+      index++;
    }
 
-    PerfTest obj(resourceCount, iterations);
-    obj.test(async);
+    PerfSuite suite(dir, frames, concurrent, filter);
+    suite.run();
+
+    if (output.empty()) {
+        suite.write(std::cout);
+    } else {
+        std::ofstream out(output);
+        suite.write(out);
+    }
+
+    if (!baseline.empty())
+        return compare(readMetrics(baseline), suite.metrics(), tolerance);
     return 0;
 }
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Compares the scheduling cost of the rle task scheduler with the mutex
+ * based TaskQueue scheduler it replaced. Every frame submits a batch of
+ * small tasks from the calling thread and then waits for them in order,
+ * like the renderer does with the rle of its drawables.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "vtaskqueue.h"
+#include "vtaskscheduler.h"
+
+struct Worker {
+};
+
+struct Task {
+    Task *                  mNext{nullptr};
+    size_t                  mWork{0};
+    float                   mResult{0};
+    std::mutex              mMutex;
+    std::condition_variable mCv;
+    bool                    mReady{true};
+
+    void reset()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mReady = false;
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while (!mReady) mCv.wait(lock);
+    }
+
+    void run()
+    {
+        // stand-in for the rasterization of a small path.
+        float v = 0;
+        for (size_t i = 0; i < mWork; i++) v = v * 0.5f + float(i);
+        mResult = v;
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mReady = true;
+        mCv.notify_one();
+    }
+
+    void operator()(Worker &) { run(); }
+};
+
+/*
+ * the previous RleTaskScheduler, one TaskQueue per thread and a
+ * shared_ptr handle for every submitted task.
+ */
+class QueueScheduler {
+    using Handle = std::shared_ptr<Task>;
+
+    const unsigned                 _count;
+    std::vector<std::thread>       _threads;
+    std::vector<TaskQueue<Handle>> _q;
+    std::atomic<unsigned>          _index{0};
+
+    void run(unsigned i)
+    {
+        Handle task;
+        while (true) {
+            bool success = false;
+
+            for (unsigned n = 0; n != _count * 2; ++n) {
+                if (_q[(i + n) % _count].try_pop(task)) {
+                    success = true;
+                    break;
+                }
+            }
+
+            if (!success && !_q[i].pop(task)) break;
+
+            task->run();
+        }
+    }
+
+public:
+    explicit QueueScheduler(unsigned count) : _count(count), _q(count)
+    {
+        for (unsigned n = 0; n != _count; ++n) {
+            _threads.emplace_back([&, n] { run(n); });
+        }
+    }
+
+    ~QueueScheduler()
+    {
+        for (auto &e : _q) e.done();
+        for (auto &e : _threads) e.join();
+    }
+
+    void submit(const std::shared_ptr<std::vector<Task>> &owner, Task *task)
+    {
+        Handle handle(owner, task);
+        auto   i = _index++;
+
+        for (unsigned n = 0; n != _count; ++n) {
+            if (_q[(i + n) % _count].try_push(std::move(handle))) return;
+        }
+
+        _q[i % _count].push(std::move(handle));
+    }
+};
+
+using StealingScheduler = VTaskScheduler<Task, Worker>;
+
+static void submit(QueueScheduler &                          scheduler,
+                   const std::shared_ptr<std::vector<Task>> &tasks, Task *task)
+{
+    scheduler.submit(tasks, task);
+}
+
+static void submit(StealingScheduler &scheduler,
+                   const std::shared_ptr<std::vector<Task>> &, Task *task)
+{
+    scheduler.submit(task);
+}
+
+template <typename Scheduler>
+static double measure(Scheduler &scheduler, size_t tasks, size_t work,
+                      size_t frames)
+{
+    auto list = std::make_shared<std::vector<Task>>(tasks);
+    for (auto &e : *list) e.mWork = work;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t frame = 0; frame < frames; frame++) {
+        for (auto &e : *list) {
+            e.reset();
+            submit(scheduler, list, &e);
+        }
+        for (auto &e : *list) e.wait();
+    }
+    std::chrono::duration<double, std::milli> millisecs =
+        std::chrono::high_resolution_clock::now() - start;
+    return millisecs.count() / frames;
+}
+
+static int help()
+{
+    std::cout<<"\nUsage : ./taskperf [-t] [tasks per frame] [-w] [work per task] [-f] [frame count] [-j] [threads]\n";
+    std::cout<<"\nExample : ./taskperf -t 300 -w 2000 -f 200 \n";
+    std::cout<<"\n\t submits 300 small tasks per frame to both schedulers and reports the time per frame\n\n";
+    return 0;
+}
+
+int
+main(int argc, char ** argv)
+{
+    size_t tasks = 300;
+    size_t work = 2000;
+    size_t frames = 200;
+    unsigned threads = std::max(std::thread::hardware_concurrency(), 1u);
+    auto index = 0;
+
+    while (index < argc) {
+      const char* option = argv[index];
+      index++;
+      if (!strcmp(option,"--help") || !strcmp(option,"-h")) {
+          return help();
+      } else if (!strcmp(option,"-t")) {
+         tasks = (index < argc) ? atoi(argv[index]) : tasks;
+         index++;
+      } else if (!strcmp(option,"-w")) {
+         work = (index < argc) ? atoi(argv[index]) : work;
+         index++;
+      } else if (!strcmp(option,"-f")) {
+         frames = (index < argc) ? atoi(argv[index]) : frames;
+         index++;
+      } else if (!strcmp(option,"-j")) {
+         threads = (index < argc) ? atoi(argv[index]) : threads;
+         index++;
+      }
+   }
+   if (!frames) frames = 1;
+   if (!threads) threads = 1;
+
+    double queue, stealing;
+    {
+        QueueScheduler scheduler(threads);
+        queue = measure(scheduler, tasks, work, frames);
+    }
+    {
+        StealingScheduler scheduler(threads, "taskperf");
+        stealing = measure(scheduler, tasks, work, frames);
+    }
+
+    std::cout<< " \nPerformance Report: "<< tasks <<" tasks of "<< work
+             <<" iterations per frame, "<< threads <<" thread(s)\n\n";
+    std::cout<< " \t task queue    : "<< queue <<"ms per frame\n";
+    std::cout<< " \t work stealing : "<< stealing <<"ms per frame, speedup "
+             << queue / stealing <<"x\n\n";
+    return 0;
+}
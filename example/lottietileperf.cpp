@@ -0,0 +1,124 @@
+#include <memory>
+#include <vector>
+#include <dirent.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <cstring>
+
+#include <rlottie.h>
+
+/*
+ * Measures how blending a frame scales with the number of render threads.
+ * Every resource is rendered with 1, 2, 4 and 8 threads into a surface of
+ * the requested size and the average frame time is reported.
+ */
+static bool isJsonFile(const char *filename) {
+  const char *dot = strrchr(filename, '.');
+  if(!dot || dot == filename) return false;
+  return !strcmp(dot + 1, "json");
+}
+
+static std::vector<std::string>
+jsonFiles(const std::string &dirName)
+{
+    DIR *d;
+    struct dirent *dir;
+    std::vector<std::string> result;
+    d = opendir(dirName.c_str());
+    if (d) {
+      while ((dir = readdir(d)) != NULL) {
+        if (isJsonFile(dir->d_name))
+          result.push_back(dir->d_name);
+      }
+      closedir(d);
+    }
+
+    std::sort(result.begin(), result.end(), [](auto & a, auto &b){return a < b;});
+
+    return result;
+}
+
+static double
+measure(rlottie::Animation &animation, rlottie::Surface &surface, size_t iterations)
+{
+    auto frames = animation.totalFrame();
+    auto start = std::chrono::high_resolution_clock::now();
+    for (auto i = 0u; i < iterations; i++) {
+        for (size_t frame = 0; frame < frames; frame++)
+            animation.renderSync(frame, surface);
+    }
+    std::chrono::duration<double, std::milli> millisecs =
+        std::chrono::high_resolution_clock::now() - start;
+    return millisecs.count() / (iterations * frames);
+}
+
+static int help()
+{
+    std::cout<<"\nUsage : ./tileperf [-d] [resource dir] [-s] [width]x[height] [-i] [iteration count] \n";
+    std::cout<<"\nExample : ./tileperf -s 1920x1080 -i 2 \n";
+    std::cout<<"\n\t renders every frame of every resource twice at 1920x1080 with 1, 2, 4 and 8 threads\n\n";
+    return 0;
+}
+
+int
+main(int argc, char ** argv)
+{
+    std::string resourceDir = DEMO_DIR "UXSample_1920x1080/";
+    size_t width = 1920;
+    size_t height = 1080;
+    size_t iterations = 1;
+    auto index = 0;
+
+    while (index < argc) {
+      const char* option = argv[index];
+      index++;
+      if (!strcmp(option,"--help") || !strcmp(option,"-h")) {
+          return help();
+      } else if (!strcmp(option,"-d")) {
+         resourceDir = (index < argc) ? std::string(argv[index]) + "/" : resourceDir;
+         index++;
+      } else if (!strcmp(option,"-s")) {
+         if (index < argc) sscanf(argv[index], "%zux%zu", &width, &height);
+         index++;
+      } else if (!strcmp(option,"-i")) {
+         iterations = (index < argc) ? atoi(argv[index]) : iterations;
+         index++;
+      }
+   }
+   if (!iterations) iterations = 1;
+
+    const size_t threads[] = {1, 2, 4, 8};
+    double total[4] = {};
+    size_t count = 0;
+    std::vector<uint32_t> buffer(width * height);
+    rlottie::Surface surface(buffer.data(), width, height, width * 4);
+
+    std::cout<<" Test Started : .... \n\n";
+    for (const auto &name : jsonFiles(resourceDir)) {
+        auto animation = rlottie::Animation::loadFromFile(resourceDir + name, false);
+        if (!animation) continue;
+
+        std::cout<<" \t "<< name <<" :";
+        for (size_t i = 0; i < 4; i++) {
+            animation->setRenderThreads(threads[i]);
+            auto time = measure(*animation, surface, iterations);
+            total[i] += time;
+            std::cout<<" "<< threads[i] <<"T "<< time <<"ms";
+        }
+        std::cout<<"\n";
+        count++;
+    }
+    if (!count) {
+        std::cout<< " No resource found in "<< resourceDir <<"\n";
+        return 0;
+    }
+    std::cout<< " Test Finished.\n";
+    std::cout<< " \nPerformance Report: "<< width <<"x"<< height <<"\n\n";
+    for (size_t i = 0; i < 4; i++) {
+        std::cout<< " \t "<< threads[i] <<" thread(s) : "<< total[i] / count
+                 <<"ms per frame, speedup "<< total[0] / total[i] <<"x\n";
+    }
+    std::cout<<"\n";
+    return 0;
+}
@@ -0,0 +1,445 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Microbenchmarks of the vector backend primitives, so a change to one of
+ * them can be measured without going through the lottie model. Every
+ * benchmark works on a path of the given shape and size: the rle boolean
+ * operations combine the rle of the shape with a shifted copy of itself,
+ * the rasterizer fills and strokes it, the dasher, the path mesure and the
+ * matrix work on its outline and the blend functions paint its spans.
+ *
+ * Each row reports the time of one operation and the throughput in
+ * millions of the unit the operation works on.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "vbezier.h"
+#include "vdasher.h"
+#include "vdrawhelper.h"
+#include "vmatrix.h"
+#include "vpath.h"
+#include "vpathmesure.h"
+#include "vraster.h"
+#include "vrle.h"
+
+using Clock = std::chrono::steady_clock;
+
+static volatile size_t sink;
+
+class Bench {
+public:
+    Bench(std::string filter, double budget)
+        : _filter(std::move(filter)), _budget(budget)
+    {
+    }
+
+    // runs func for the time budget, count is the amount of work of one
+    // call in the given unit.
+    template <typename Func>
+    void run(const char *name, double count, const char *unit, Func func)
+    {
+        if (!_filter.empty() && !strstr(name, _filter.c_str())) return;
+
+        func();  // warm up caches and scratch buffers
+        size_t iterations = 0;
+        double elapsed = 0;
+        auto   start = Clock::now();
+        do {
+            func();
+            iterations++;
+            elapsed = std::chrono::duration<double, std::micro>(Clock::now() -
+                                                                 start)
+                          .count();
+        } while (elapsed < _budget * 1000);
+
+        double us = elapsed / double(iterations);
+        printf("\t %-26s %12.2f us %12.1f M%s/s\n", name, us, count / us, unit);
+    }
+
+private:
+    std::string _filter;
+    double      _budget;
+};
+
+static VPath shape(const std::string &name, float size, size_t complexity)
+{
+    VPath path;
+    float c = size / 2;
+    float r = size / 2 - 1;
+    if (name == "rect") {
+        path.addRect({1, 1, size - 2, size - 2});
+    } else if (name == "rrect") {
+        path.addRoundRect({1, 1, size - 2, size - 2}, r / 4, r / 4);
+    } else if (name == "star") {
+        path.addPolystar(float(complexity), r / 2, r, 0, 0, 0, c, c);
+    } else if (name == "wave") {
+        // a closed band of cubics crossing itself, lots of edges per row.
+        float step = (size - 2) / float(complexity);
+        path.moveTo(1, c);
+        for (size_t i = 0; i < complexity; i++) {
+            float x = 1 + step * float(i);
+            path.cubicTo(x + step / 3, 1, x + 2 * step / 3, size - 1,
+                         x + step, c);
+        }
+        for (size_t i = complexity; i > 0; i--) {
+            float x = 1 + step * float(i);
+            path.cubicTo(x - step / 3, 1, x - 2 * step / 3, size - 1,
+                         x - step, c);
+        }
+        path.close();
+    } else {
+        path.addCircle(c, c, r);
+    }
+    return path;
+}
+
+static VRle rasterize(const VPath &path)
+{
+    VRasterizer rasterizer;
+    rasterizer.rasterize(path);
+    return rasterizer.rle();
+}
+
+static void collect(size_t count, const VRle::Span *spans, void *data)
+{
+    auto *v = static_cast<std::vector<VRle::Span> *>(data);
+    v->insert(v->end(), spans, spans + count);
+}
+
+static void count(size_t count, const VRle::Span *, void *data)
+{
+    *static_cast<size_t *>(data) += count;
+}
+
+static std::vector<VRle::Span> spans(const VRle &rle)
+{
+    std::vector<VRle::Span> result;
+    rle.intersect(rle.boundingRect(), collect, &result);
+    return result;
+}
+
+static uint32_t pixel(std::mt19937 &rng)
+{
+    uint32_t r = rng();
+    uint32_t a = r >> 24;
+    return (a << 24) | BYTE_MUL(r & 0x00ffffff, a);
+}
+
+static void rleOps(Bench &bench, const VPath &path, float size)
+{
+    VPath other = path;
+    other.transform(VMatrix().translate(size / 4, size / 4));
+    VRle   a = rasterize(path);
+    VRle   b = rasterize(other);
+    double n = double(spans(a).size() + spans(b).size());
+    VRect  clip(int(size / 4), int(size / 4), int(size / 2), int(size / 2));
+
+    printf("\n rle (%zu + %zu spans)\n", spans(a).size(), spans(b).size());
+    bench.run("rle a & b", n, "spans", [&] { sink += (a & b).empty(); });
+    bench.run("rle a - b", n, "spans", [&] { sink += (a - b).empty(); });
+    bench.run("rle a + b", n, "spans", [&] { sink += (a + b).empty(); });
+    bench.run("rle a ^ b", n, "spans", [&] { sink += (a ^ b).empty(); });
+    bench.run("rle rect - a", n / 2, "spans",
+              [&] { sink += (clip - a).empty(); });
+    bench.run("rle rect & a", n / 2, "spans",
+              [&] { sink += (clip & a).empty(); });
+    bench.run("rle intersect rle", n, "spans", [&] {
+        size_t result = 0;
+        a.intersect(b, count, &result);
+        sink += result;
+    });
+    bench.run("rle intersect rect", n / 2, "spans", [&] {
+        size_t result = 0;
+        a.intersect(clip, count, &result);
+        sink += result;
+    });
+}
+
+static void raster(Bench &bench, const VPath &path, float size)
+{
+    double     pixels = double(size) * double(size);
+    float      width = std::max(1.0f, size / 50);
+    VRect      clip(0, 0, int(size / 2), int(size / 2));
+    VRasterizer rasterizer;
+
+    printf("\n raster (%zu points)\n", path.points().size());
+    bench.run("fill winding", pixels, "pixels", [&] {
+        rasterizer.rasterize(path, FillRule::Winding);
+        sink += rasterizer.rle().empty();
+    });
+    bench.run("fill evenodd", pixels, "pixels", [&] {
+        rasterizer.rasterize(path, FillRule::EvenOdd);
+        sink += rasterizer.rle().empty();
+    });
+    bench.run("fill clipped", pixels / 4, "pixels", [&] {
+        rasterizer.rasterize(path, FillRule::Winding, clip);
+        sink += rasterizer.rle().empty();
+    });
+
+    const struct {
+        const char *name;
+        CapStyle    cap;
+        JoinStyle   join;
+    } strokes[] = {{"stroke butt miter", CapStyle::Flat, JoinStyle::Miter},
+                   {"stroke round round", CapStyle::Round, JoinStyle::Round},
+                   {"stroke square bevel", CapStyle::Square, JoinStyle::Bevel}};
+    for (auto &s : strokes) {
+        bench.run(s.name, pixels, "pixels", [&] {
+            rasterizer.rasterize(path, s.cap, s.join, width, 4);
+            sink += rasterizer.rle().empty();
+        });
+    }
+}
+
+static void outline(Bench &bench, const VPath &path, float size)
+{
+    double points = double(path.points().size());
+    float  dashes[] = {size / 20, size / 40, size / 10, size / 30, size / 7};
+    VPath  result;
+
+    printf("\n outline (%zu points, length %.0f)\n", path.points().size(),
+           double(path.length()));
+    bench.run("dash", points, "points", [&] {
+        VDasher dasher(dashes, 4);
+        dasher.dashed(path, result);
+        sink += result.points().size();
+    });
+    bench.run("dash offset", points, "points", [&] {
+        VDasher dasher(dashes, 5);
+        dasher.dashed(path, result);
+        sink += result.points().size();
+    });
+
+    VPathMesure mesure;
+    bench.run("mesure trim", points, "points", [&] {
+        mesure.setRange(0.1f, 0.7f);
+        sink += mesure.trim(path).points().size();
+    });
+    bench.run("mesure trim wrap", points, "points", [&] {
+        mesure.setRange(0.7f, 0.3f);
+        sink += mesure.trim(path).points().size();
+    });
+    bench.run("path length", points, "points", [&] {
+        VPath copy;
+        copy.clone(path);
+        sink += size_t(copy.length());
+    });
+
+    const struct {
+        const char *name;
+        VMatrix     m;
+    } matrices[] = {
+        {"transform translate", VMatrix().translate(3, 5)},
+        {"transform scale", VMatrix().translate(3, 5).scale(1.5f, 0.5f)},
+        {"transform rotate", VMatrix().translate(3, 5).rotate(30)},
+        {"transform shear", VMatrix().shear(0.2f, 0.1f).rotate(30)},
+    };
+    for (auto &m : matrices) {
+        bench.run(m.name, points, "points", [&] {
+            result.reset();
+            result.addPath(path, m.m);
+            sink += result.points().size();
+        });
+    }
+}
+
+// random cubics of the given size, flattened the way the dasher and the
+// mesure do it.
+static void bezier(Bench &bench, float size, size_t complexity)
+{
+    std::mt19937                          rng(1234);
+    std::uniform_real_distribution<float> coord(0, size);
+    std::vector<VBezier>                  curves;
+    for (size_t i = 0; i < std::max<size_t>(complexity, 16); i++) {
+        curves.push_back(VBezier::fromPoints({coord(rng), coord(rng)},
+                                             {coord(rng), coord(rng)},
+                                             {coord(rng), coord(rng)},
+                                             {coord(rng), coord(rng)}));
+    }
+    double n = double(curves.size());
+
+    printf("\n bezier (%zu curves)\n", curves.size());
+    bench.run("bezier length", n, "curves", [&] {
+        float l = 0;
+        for (auto &b : curves) l += b.length();
+        sink += size_t(l);
+    });
+    bench.run("bezier split at length", n, "curves", [&] {
+        VBezier left, right;
+        for (auto &b : curves) {
+            VBezier copy = b;
+            copy.splitAtLength(copy.length() / 3, &left, &right);
+            sink += size_t(left.pt4().x());
+        }
+    });
+    bench.run("bezier flatten 16", n, "curves", [&] {
+        float s = 0;
+        for (auto &b : curves) {
+            for (int i = 1; i <= 16; i++) s += b.pointAt(float(i) / 16).x();
+        }
+        sink += size_t(s);
+    });
+    bench.run("bezier angle", n, "curves", [&] {
+        float s = 0;
+        for (auto &b : curves) s += b.angleAt(0.5f);
+        sink += size_t(s);
+    });
+}
+
+// paints the spans of the shape the way VPainter does, with the coverage
+// as the const alpha.
+static void blend(Bench &bench, const VPath &path, float size)
+{
+    auto spanList = spans(rasterize(path));
+    auto stride = size_t(size);
+    double pixels = 0;
+    for (auto &s : spanList) pixels += s.len;
+
+    std::mt19937          rng(1234);
+    std::vector<uint32_t> dest(stride * stride), src(stride * stride);
+    for (auto &e : dest) e = pixel(rng);
+    for (auto &e : src) e = pixel(rng);
+    uint32_t color = pixel(rng);
+
+    RenderFuncTable table;
+    printf("\n blend (%zu spans, %.0f pixels)\n", spanList.size(), pixels);
+
+    const struct {
+        const char *color;
+        const char *src;
+        BlendMode   mode;
+    } modes[] = {{"color Src", "src Src", BlendMode::Src},
+                 {"color SrcOver", "src SrcOver", BlendMode::SrcOver},
+                 {"color DestIn", "src DestIn", BlendMode::DestIn},
+                 {"color DestOut", "src DestOut", BlendMode::DestOut}};
+    for (auto &m : modes) {
+        auto func = table.color(m.mode);
+        bench.run(m.color, pixels, "pixels", [&] {
+            for (auto &s : spanList)
+                func(&dest[s.y * stride + s.x], s.len, color, s.coverage);
+        });
+    }
+    for (auto &m : modes) {
+        auto func = table.src(m.mode);
+        bench.run(m.src, pixels, "pixels", [&] {
+            for (auto &s : spanList) {
+                size_t offset = s.y * stride + s.x;
+                func(&dest[offset], s.len, &src[offset], s.coverage);
+            }
+        });
+    }
+
+    std::vector<uint32_t> table256(VGradient::colorTableSize);
+    for (auto &e : table256) e = pixel(rng);
+    VGradientData        gradient;
+    RadialGradientValues radial;
+    gradient.mSpread = VGradient::Spread::Pad;
+    gradient.mColorTable = table256.data();
+    gradient.radial.fradius = 0;
+    radial.dr = 1;
+    radial.extended = false;
+
+    auto linear = table.linear();
+    bench.run("linear gradient", pixels, "pixels", [&] {
+        for (auto &s : spanList)
+            linear(&dest[s.y * stride + s.x], s.len, &gradient, s.x * 64, 64);
+    });
+    auto radialFunc = table.radial();
+    bench.run("radial gradient", pixels, "pixels", [&] {
+        for (auto &s : spanList)
+            radialFunc(&dest[s.y * stride + s.x], s.len, &gradient, &radial,
+                       float(s.x) / size, 1.0f / size, 0.0001f, 0, 0);
+    });
+}
+
+static int help()
+{
+    std::cout<<"\nUsage : ./vectorperf [-s circle|rect|rrect|star|wave] [-w size] [-c complexity] [-t ms] [-b filter]\n";
+    std::cout<<"\nExample : ./vectorperf -s star -w 512 -c 32 -t 200 -b rle\n";
+    std::cout<<"\n\t runs every benchmark whose name contains rle on a 32 point star of 512x512 pixels\n";
+    std::cout<<"\t for 200 ms each and reports the time of one operation and the throughput\n\n";
+    return 0;
+}
+
+int
+main(int argc, char ** argv)
+{
+    std::string name = "circle";
+    std::string filter;
+    size_t size = 512;
+    size_t complexity = 16;
+    double budget = 200;
+    auto index = 1;
+
+    while (index < argc) {
+      const char* option = argv[index];
+      index++;
+      if (!strcmp(option,"--help") || !strcmp(option,"-h")) {
+          return help();
+      } else if (!strcmp(option,"-s")) {
+         name = (index < argc) ? argv[index] : name;
+         index++;
+      } else if (!strcmp(option,"-w")) {
+         size = (index < argc) ? atoi(argv[index]) : size;
+         index++;
+      } else if (!strcmp(option,"-c")) {
+         complexity = (index < argc) ? atoi(argv[index]) : complexity;
+         index++;
+      } else if (!strcmp(option,"-t")) {
+         budget = (index < argc) ? atof(argv[index]) : budget;
+         index++;
+      } else if (!strcmp(option,"-b")) {
+         filter = (index < argc) ? argv[index] : filter;
+         index++;
+      } else {
+         return help();
+      }
+   }
+   size = std::min<size_t>(std::max<size_t>(size, 8), 8192);
+   complexity = std::max<size_t>(complexity, 3);
+
+    Bench bench(filter, budget);
+    VPath path = shape(name, float(size), complexity);
+
+    std::cout<< " \nPerformance Report: "<< name <<" of "<< size <<"x"<< size
+             <<", complexity "<< complexity <<"\n";
+
+    rleOps(bench, path, float(size));
+    raster(bench, path, float(size));
+    outline(bench, path, float(size));
+    bezier(bench, float(size), complexity);
+    blend(bench, path, float(size));
+
+    printf("\n");
+    return 0;
+}
@@ -64,6 +64,137 @@ namespace rlottie {
  */
 RLOTTIE_API void configureModelCacheSize(size_t cacheSize);
 
+/**
+ *  @brief Configures the memory budget of the rlottie model cache.
+ *
+ *  Cached models are evicted in least recently used order once the
+ *  approximate memory held by them exceeds the budget. A model that
+ *  doesn't fit in the budget alone is not cached at all.
+ *
+ *  @param[in] bytes  Maximum memory of the cached models in bytes.
+ *
+ *  @note configure with 0 to remove the memory limit (default), the
+ *        cache is still bounded by configureModelCacheSize().
+ *
+ *  @internal
+ */
+RLOTTIE_API void configureModelCacheBudget(size_t bytes);
+
+/**
+ *  @brief Model cache statistics since the library is loaded.
+ *
+ *  @internal
+ */
+struct ModelCacheStats {
+    size_t hits{0};       /* lookups served from the cache */
+    size_t misses{0};     /* lookups that had to parse the resource */
+    size_t evictions{0};  /* models dropped to respect size or budget */
+    size_t entries{0};    /* models currently cached */
+    size_t bytes{0};      /* approximate memory of the cached models */
+};
+
+/**
+ *  @brief Returns the model cache statistics.
+ *
+ *  @internal
+ */
+RLOTTIE_API ModelCacheStats modelCacheStats();
+
+/**
+ *  @brief What trimMemory() releases, every level includes the
+ *         previous ones.
+ *
+ *  @internal
+ */
+enum class TrimLevel {
+    Scratch, /* buffers reused between frames (offscreen surfaces,
+                rasterizer buffers, gradient tables) */
+    Caches,  /* cached results (models, static layer bitmaps, frames) */
+    All      /* also the render trees, rebuilt by the next render */
+};
+
+/**
+ *  @brief Releases memory held by the caches of all the animations and
+ *         of the library.
+ *
+ *  Everything released is rebuilt on demand, so the only cost is the time
+ *  it takes to rebuild it. Can be called from any thread, an animation
+ *  that is rendering releases its memory when the render finishes.
+ *
+ *  @param[in] level  what to release.
+ *
+ *  @note TrimLevel::All invalidates the pointers returned by
+ *        Animation::renderTree().
+ *
+ *  @internal
+ */
+RLOTTIE_API void trimMemory(TrimLevel level);
+
+/**
+ *  @brief Configures a process wide memory budget of the library.
+ *
+ *  When a render call leaves the caches past the budget, the library
+ *  trims at the lowest level that brings the memory back within the
+ *  budget, see trimMemory(). The render trees are never released to
+ *  respect the budget, that takes an explicit TrimLevel::All.
+ *
+ *  @param[in] bytes  budget in bytes, 0 removes the budget (default).
+ *
+ *  @internal
+ */
+RLOTTIE_API void configureMemoryBudget(size_t bytes);
+
+/**
+ *  @brief Approximate memory held by the library, in bytes.
+ *
+ *  @internal
+ */
+struct MemoryStats {
+    size_t models{0};        /* parsed models in the model cache */
+    size_t gradients{0};     /* gradient color tables */
+    size_t rasterizer{0};    /* outline and stroker buffers */
+    size_t surfaces{0};      /* pooled offscreen surfaces */
+    size_t rasterCaches{0};  /* bitmaps of static layers */
+    size_t frameCaches{0};   /* frames in the frame caches */
+    size_t rles{0};          /* span storage of the rasterized shapes */
+    size_t total{0};         /* sum of the above */
+    size_t budget{0};        /* see configureMemoryBudget() */
+};
+
+/**
+ *  @brief Returns the memory held by the library.
+ *
+ *  @internal
+ */
+RLOTTIE_API MemoryStats memoryStats();
+
+/**
+ *  @brief Starts recording a timeline of the rendering.
+ *
+ *  Parsing, update, preprocess, the raster tasks, the waits for them,
+ *  matte compositing and blending are recorded per thread and written to
+ *  @p path as Chrome trace event JSON (chrome://tracing, ui.perfetto.dev)
+ *  by stopTrace(). Setting the RLOTTIE_TRACE environment variable to a
+ *  file name traces the whole process instead.
+ *
+ *  @param[in] path  file the trace is written to.
+ *
+ *  @return false if a trace is already running or the library is built
+ *          without the profile option (LOTTIE_PROFILE).
+ *
+ *  @internal
+ */
+RLOTTIE_API bool startTrace(const std::string &path);
+
+/**
+ *  @brief Stops the trace started by startTrace() and writes it.
+ *
+ *  @return false if no trace was running or the file can't be written.
+ *
+ *  @internal
+ */
+RLOTTIE_API bool stopTrace();
+
 struct Color {
     Color() = default;
     Color(float r, float g , float b):_r(r), _g(g), _b(b){}
@@ -270,6 +401,136 @@ using LayerInfoList = std::vector<std::tuple<std::string, int , int>>;
 
 using ColorFilter = std::function<void(float &r , float &g, float &b)>;
 
+/**
+ *  @brief Frame cache statistics of an Animation.
+ *
+ *  @see Animation::setFrameCacheBudget()
+ *  @internal
+ */
+struct FrameCacheStats {
+    size_t hits{0};    /* frames decoded from the cache */
+    size_t misses{0};  /* frames that had to be rendered */
+    size_t frames{0};  /* frames currently cached */
+    size_t bytes{0};   /* memory used by the cached frames */
+};
+
+/**
+ *  @brief Work done to render the last frame of an Animation.
+ *
+ *  Times are in microseconds. Rasterization runs on the raster threads,
+ *  its time is summed over the threads and can exceed the frame time.
+ *  A stage nested in another one (e.g. path building during the update)
+ *  is only counted in the inner stage.
+ *
+ *  @note the counters are only collected when the library is built with
+ *        the profile option (LOTTIE_PROFILE), they stay 0 otherwise.
+ *
+ *  @see Animation::frameStats()
+ *  @internal
+ */
+struct FrameStats {
+    double frameTime{0};       /* wall time of the render call */
+    double updateTime{0};      /* evaluating the layer properties */
+    double pathTime{0};        /* building the shape paths */
+    double rasterTime{0};      /* generating the rles of the paths */
+    double blendTime{0};       /* blending into the surface and offscreens */
+    size_t drawables{0};       /* drawables rasterized */
+    size_t spans{0};           /* rle spans produced by the rasterizer */
+    size_t pixels{0};          /* pixels blended */
+    size_t surfaces{0};        /* offscreen surfaces used */
+    size_t surfaceAllocs{0};   /* offscreen surfaces newly allocated */
+    size_t surfaceHits{0};     /* offscreen surfaces reused from the cache */
+    size_t surfaceReleases{0}; /* cached surfaces freed, idle or over budget */
+    size_t culledLayers{0};    /* layers with nothing inside the draw region */
+    size_t culledDrawables{0}; /* drawables outside the draw region */
+    size_t rleMattes{0};       /* track mattes applied without offscreen surfaces */
+};
+
+/**
+ *  @brief Area of the surface changed by a render call.
+ *
+ *  @see Animation::renderSync()
+ *  @internal
+ */
+struct DamageRect {
+    size_t x{0};
+    size_t y{0};
+    size_t w{0};  /* 0 if nothing changed */
+    size_t h{0};
+};
+
+/**
+ *  @brief Keypath resolved by Animation::resolveKeyPath().
+ *
+ *  Holds the contents the keypath matched so setting a value through it
+ *  doesn't need to search the layer tree again. A handle is only valid
+ *  for the Animation that created it and for the clones of it created
+ *  afterwards.
+ *
+ *  @see Animation::resolveKeyPath()
+ *  @internal
+ */
+class KeyPathHandle {
+public:
+    KeyPathHandle() = default;
+    bool valid() const { return mId != 0; }
+
+private:
+    friend class Animation;
+    friend class ValueBatch;
+    explicit KeyPathHandle(size_t id) : mId(id) {}
+    size_t mId{0};
+};
+
+/**
+ *  @brief List of property values applied at once by Animation::setValues().
+ *
+ *  @usage
+ *     rlottie::ValueBatch batch;
+ *     batch.setValue<rlottie::Property::FillColor>(fill, rlottie::Color(1, 0, 0))
+ *          .setValue<rlottie::Property::StrokeWidth>(stroke, 2.0f);
+ *     player->setValues(batch);
+ *
+ *  @internal
+ */
+class ValueBatch {
+public:
+    template<Property prop, typename AnyValue>
+    ValueBatch &setValue(const KeyPathHandle &keyPath, AnyValue value)
+    {
+        add(MapType<std::integral_constant<Property, prop>>{}, prop, keyPath, value);
+        return *this;
+    }
+
+    size_t size() const { return mValues.size(); }
+    void   clear() { mValues.clear(); }
+
+private:
+    friend class Animation;
+    struct Value {
+        size_t   keyPath;
+        Property property;
+        float    data[3];
+    };
+    void add(Color_Type, Property prop, const KeyPathHandle &keyPath, Color value)
+    {
+        mValues.push_back({keyPath.mId, prop, {value.r(), value.g(), value.b()}});
+    }
+    void add(Float_Type, Property prop, const KeyPathHandle &keyPath, float value)
+    {
+        mValues.push_back({keyPath.mId, prop, {value, 0, 0}});
+    }
+    void add(Size_Type, Property prop, const KeyPathHandle &keyPath, Size value)
+    {
+        mValues.push_back({keyPath.mId, prop, {value.w(), value.h(), 0}});
+    }
+    void add(Point_Type, Property prop, const KeyPathHandle &keyPath, Point value)
+    {
+        mValues.push_back({keyPath.mId, prop, {value.x(), value.y(), 0}});
+    }
+    std::vector<Value> mValues;
+};
+
 class RLOTTIE_API Animation {
 public:
 
@@ -327,6 +588,89 @@ public:
     static std::unique_ptr<Animation>
     loadFromData(std::string jsonData, std::string resourcePath, ColorFilter filter);
 
+    /**
+     *  @brief Constructs an animation object from JSON data in a caller
+     *  allocated buffer without copying it.
+     *
+     *  The buffer is handed over to the library and used as scratch memory
+     *  by the parser, so it is released as soon as the parsing is done.
+     *  To avoid an internal copy the JSON data should be terminated by a
+     *  '\0' inside the buffer (data[size - 1] == '\0').
+     *
+     *  @param[in] data buffer holding the JSON data.
+     *  @param[in] size size of the buffer in bytes.
+     *  @param[in] key the string that will be used to cache the JSON data.
+     *  @param[in] resourcePath the path will be used to search for external resource.
+     *  @param[in] cachePolicy whether to cache or not the model data.
+     *
+     *  @return Animation object that can render the contents of the
+     *          Lottie resource represented by JSON data.
+     *
+     *  @internal
+     */
+    static std::unique_ptr<Animation>
+    loadFromData(std::unique_ptr<char[]> data, size_t size, const std::string &key,
+                 const std::string &resourcePath="", bool cachePolicy=true);
+
+    /**
+     *  @brief Constructs an animation object from a precompiled binary model
+     *  file created by saveBinary().
+     *
+     *  Loading a binary model skips json parsing and image decoding. The
+     *  binary format is tied to the rlottie version and architecture that
+     *  produced it, in case of a mismatch nullptr is returned and the caller
+     *  should fall back to the original Lottie resource.
+     *
+     *  @param[in] path binary model file path
+     *  @param[in] cachePolicy whether to cache or not the model data.
+     *
+     *  @return Animation object that can render the contents of the
+     *          binary model file or nullptr on failure.
+     *
+     *  @see saveBinary()
+     *  @internal
+     */
+    static std::unique_ptr<Animation>
+    loadFromBinary(const std::string &path, bool cachePolicy=true);
+
+    /**
+     *  @brief Saves the parsed model of this animation as a precompiled
+     *  binary file that can be loaded with loadFromBinary().
+     *
+     *  @param[in] path binary model file path
+     *
+     *  @return true if the file is written successfully.
+     *
+     *  @see loadFromBinary()
+     *  @internal
+     */
+    bool saveBinary(const std::string &path) const;
+
+    /**
+     *  @brief Creates an animation object that shares the parsed model
+     *  of this animation but has its own render state.
+     *
+     *  The model is not parsed or copied again, so cloning is cheap. This
+     *  animation and its clones can render different frames at the same
+     *  time from different threads, e.g. to export all the frames of a
+     *  resource on every core.
+     *
+     *  Dynamic properties set with setValue() before the call are applied
+     *  to the clone as well. Frame cache and render thread settings are
+     *  not copied.
+     *
+     *  @return Animation object that renders the same resource.
+     *
+     *  @note Dynamic properties live in the render state of each animation,
+     *        a later setValue() only changes the animation it is called
+     *        on. A callback is copied to the clones along with whatever it
+     *        captured, so it may be called from several threads at the
+     *        same time when the clones render in parallel.
+     *
+     *  @internal
+     */
+    std::unique_ptr<Animation> clone() const;
+
     /**
      *  @brief Returns default framerate of the Lottie resource.
      *
@@ -423,6 +767,28 @@ public:
      */
     void              renderSync(size_t frameNo, Surface surface, bool keepAspectRatio=true);
 
+    /**
+     *  @brief Renders the content to surface synchronously and reports
+     *         the area of the surface that changed.
+     *
+     *  When the surface is the same one (buffer, size and draw region) that
+     *  the previous call of this function rendered into, only the area that
+     *  changed since that frame is cleared and drawn again, the rest of the
+     *  surface is left untouched. Otherwise the whole draw region is drawn.
+     *
+     *  @param[in] frameNo Content corresponds to the @p frameNo needs to be drawn
+     *  @param[in] surface Surface in which content will be drawn
+     *  @param[out] damage area of the surface that was updated.
+     *  @param[in] keepAspectRatio whether to keep the aspect ratio while scaling the content.
+     *
+     *  @note The surface content must not be modified between the calls,
+     *        otherwise the rendered frame will be incorrect.
+     *
+     *  @internal
+     */
+    void              renderSync(size_t frameNo, Surface surface, DamageRect &damage,
+                                 bool keepAspectRatio=true);
+
     /**
      *  @brief Returns root layer of the composition updated with
      *         content of the Lottie resource at frame number @p frameNo.
@@ -437,6 +803,74 @@ public:
      */
     const LOTLayerNode * renderTree(size_t frameNo, size_t width, size_t height) const;
 
+    /**
+     *  @brief Enables caching of the rendered frames.
+     *
+     *  Rendered frames are kept run length encoded so that playing them
+     *  again (e.g. a looping animation) only decodes the frame into the
+     *  surface instead of rendering it. The cache holds frames of one
+     *  view size, rendering with another size or calling setValue()
+     *  drops the cached frames. Once the budget is used up new frames are
+     *  not cached anymore. While a value is set by a callback the cache is
+     *  bypassed, the callback may change the frame on every render.
+     *
+     *  @param[in] bytes memory budget of the cache, 0 disables the cache
+     *             and frees the cached frames (default).
+     *
+     *  @internal
+     */
+    void setFrameCacheBudget(size_t bytes);
+
+    /**
+     *  @brief Returns the frame cache statistics.
+     *
+     *  @see setFrameCacheBudget()
+     *  @internal
+     */
+    FrameCacheStats frameCacheStats() const;
+
+    /**
+     *  @brief Returns the per stage timings and counters of the last
+     *         rendered frame.
+     *
+     *  @see FrameStats
+     *  @internal
+     */
+    FrameStats frameStats() const;
+
+    /**
+     *  @brief Limits the memory of the offscreen surfaces this animation
+     *         keeps for its next frames.
+     *
+     *  Offscreen surfaces are needed by mattes, masks and layers with
+     *  opacity. Once released, they are kept for reuse until the budget is
+     *  used up, the least recently used are freed first. Surfaces not
+     *  used for 30 frames are freed regardless of the budget.
+     *
+     *  @param[in] bytes memory budget of the kept surfaces, 0 removes the
+     *             limit (default).
+     *
+     *  @internal
+     */
+    void setSurfaceCacheBudget(size_t bytes);
+
+    /**
+     *  @brief Sets the number of threads that blend a frame.
+     *
+     *  The surface is split in horizontal bands and every band is blended
+     *  by its own thread, the calling thread being one of them. The
+     *  rendered frame is the same as with a single thread. Useful for
+     *  large surfaces, small ones are not worth splitting.
+     *
+     *  @param[in] count number of threads, 0 or 1 renders on the calling
+     *             thread only (default).
+     *
+     *  @note Has no effect if the library is built without thread support.
+     *
+     *  @internal
+     */
+    void setRenderThreads(size_t count);
+
     /**
      *  @brief Returns Composition Markers.
      *
@@ -482,6 +916,53 @@ public:
         setValue(MapType<std::integral_constant<Property, prop>>{}, prop, keypath, value);
     }
 
+    /**
+     *  @brief Resolves a keypath to the contents it matches, for setting
+     *  values on the same contents many times (e.g. every frame).
+     *
+     *  @param[in] keypath keypath in the format setValue() takes.
+     *
+     *  @return handle of the keypath, not valid if the keypath is empty.
+     *
+     *  @note The animation keeps the resolved contents as long as it lives.
+     *        Keypaths that match the same contents share them, so does
+     *        setValue() with a keypath string. A keypath string is only
+     *        resolved the first time it is seen. A value stays in effect,
+     *        and is kept, until another value is set for the same
+     *        contents and property.
+     *
+     *  @usage
+     *     auto fill = player->resolveKeyPath("layer1.group1.fill1");
+     *     player->setValue<rlottie::Property::FillColor>(fill, rlottie::Color(1, 0, 0));
+     *
+     *  @internal
+     */
+    KeyPathHandle resolveKeyPath(const std::string &keypath);
+
+    /**
+     *  @brief Sets property value for the contents of a resolved keypath,
+     *  the cost is linear to the number of matched contents.
+     *
+     *  @see resolveKeyPath()
+     *  @internal
+     */
+    template<Property prop, typename AnyValue>
+    void setValue(const KeyPathHandle &keyPath, AnyValue value)
+    {
+        setValue(MapType<std::integral_constant<Property, prop>>{}, prop, keyPath, value);
+    }
+
+    /**
+     *  @brief Applies all the values of the batch in one call.
+     *
+     *  Same as calling setValue() for each of them in order, except that
+     *  the cached frames are dropped once for the whole batch.
+     *
+     *  @see ValueBatch
+     *  @internal
+     */
+    void setValues(const ValueBatch &batch);
+
     /**
      *  @brief default destructor
      *
@@ -499,6 +980,16 @@ private:
     void setValue(Float_Type, Property, const std::string &, std::function<float(const FrameInfo &)> &&);
     void setValue(Size_Type, Property, const std::string &, std::function<Size(const FrameInfo &)> &&);
     void setValue(Point_Type, Property, const std::string &, std::function<Point(const FrameInfo &)> &&);
+
+    void setValue(Color_Type, Property, const KeyPathHandle &, Color);
+    void setValue(Float_Type, Property, const KeyPathHandle &, float);
+    void setValue(Size_Type, Property, const KeyPathHandle &, Size);
+    void setValue(Point_Type, Property, const KeyPathHandle &, Point);
+
+    void setValue(Color_Type, Property, const KeyPathHandle &, std::function<Color(const FrameInfo &)> &&);
+    void setValue(Float_Type, Property, const KeyPathHandle &, std::function<float(const FrameInfo &)> &&);
+    void setValue(Size_Type, Property, const KeyPathHandle &, std::function<Size(const FrameInfo &)> &&);
+    void setValue(Point_Type, Property, const KeyPathHandle &, std::function<Point(const FrameInfo &)> &&);
     /**
      *  @brief default constructor
      *
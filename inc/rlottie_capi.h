@@ -46,8 +46,32 @@ typedef enum {
     LOTTIE_ANIMATION_PROPERTY_TRIM_PATH_END    /*!< Trim Path End property of Shape object , value type is float [0 .. 100] */
 }Lottie_Animation_Property;
 
+typedef enum {
+    LOTTIE_TRIM_SCRATCH,  /*!< buffers reused between frames */
+    LOTTIE_TRIM_CACHES,   /*!< also the cached models, layer bitmaps and frames */
+    LOTTIE_TRIM_ALL       /*!< also the render trees, rebuilt by the next render */
+}Lottie_Trim_Level;
+
 typedef struct Lottie_Animation_S Lottie_Animation;
 
+typedef struct {
+    double frame_time;       /*!< wall time of the render call, in microseconds */
+    double update_time;      /*!< evaluating the layer properties */
+    double path_time;        /*!< building the shape paths */
+    double raster_time;      /*!< generating the rles, summed over the raster threads */
+    double blend_time;       /*!< blending into the surface and offscreens */
+    size_t drawables;        /*!< drawables rasterized */
+    size_t spans;            /*!< rle spans produced by the rasterizer */
+    size_t pixels;           /*!< pixels blended */
+    size_t surfaces;         /*!< offscreen surfaces used */
+    size_t surface_allocs;   /*!< offscreen surfaces newly allocated */
+    size_t surface_hits;     /*!< offscreen surfaces reused from the cache */
+    size_t surface_releases; /*!< cached surfaces freed, idle or over budget */
+    size_t culled_layers;    /*!< layers with nothing inside the draw region */
+    size_t culled_drawables; /*!< drawables outside the draw region, not rasterized */
+    size_t rle_mattes;       /*!< track mattes applied without offscreen surfaces */
+}Lottie_Frame_Stats;
+
 /**
  *  @brief Runs lottie initialization code when rlottie library is loaded
  * dynamically.
@@ -108,6 +132,48 @@ RLOTTIE_API Lottie_Animation *lottie_animation_from_file(const char *path);
  */
 RLOTTIE_API Lottie_Animation *lottie_animation_from_data(const char *data, const char *key, const char *resource_path);
 
+/**
+ *  @brief Constructs an animation object from a precompiled binary model file.
+ *
+ *  @param[in] path binary model file path created by lottie_animation_save_binary().
+ *
+ *  @return Animation object that can build the contents of the binary model
+ *          or NULL if the file is not a compatible binary model.
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+RLOTTIE_API Lottie_Animation *lottie_animation_from_binary(const char *path);
+
+/**
+ *  @brief Saves the parsed model of the animation as a precompiled binary file.
+ *
+ *  @param[in] animation Animation object.
+ *  @param[in] path binary model file path.
+ *
+ *  @return 1 if the file is written successfully, 0 otherwise.
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+RLOTTIE_API int lottie_animation_save_binary(const Lottie_Animation *animation, const char *path);
+
+/**
+ *  @brief Constructs an animation object that shares the parsed model of
+ *  the given one but has its own render state, so both can render frames
+ *  at the same time from different threads.
+ *
+ *  @param[in] animation Animation object to clone.
+ *
+ *  @return Animation object that renders the same resource.
+ *
+ *  @see lottie_animation_destroy()
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+RLOTTIE_API Lottie_Animation *lottie_animation_clone(const Lottie_Animation *animation);
+
 /**
  *  @brief Free given Animation object resource.
  *
@@ -115,6 +181,8 @@ RLOTTIE_API Lottie_Animation *lottie_animation_from_data(const char *data, const
  *
  *  @see lottie_animation_from_file()
  *  @see lottie_animation_from_data()
+ *  @see lottie_animation_from_binary()
+ *  @see lottie_animation_clone()
  *
  *  @ingroup Lottie_Animation
  *  @internal
@@ -233,6 +301,31 @@ RLOTTIE_API size_t lottie_animation_get_frame_at_pos(const Lottie_Animation *ani
  */
 RLOTTIE_API void lottie_animation_render(Lottie_Animation *animation, size_t frame_num, uint32_t *buffer, size_t width, size_t height, size_t bytes_per_line);
 
+/**
+ *  @brief Request to render the content of the frame @p frame_num to buffer @p buffer
+ *         and report the area of the buffer that changed.
+ *
+ *  When @p buffer is the one the previous call of this function rendered into
+ *  only the area that changed since that frame is redrawn.
+ *
+ *  @param[in] animation Animation object.
+ *  @param[in] frame_num the frame number needs to be rendered.
+ *  @param[in] buffer surface buffer use for rendering.
+ *  @param[in] width width of the surface
+ *  @param[in] height height of the surface
+ *  @param[in] bytes_per_line stride of the surface in bytes.
+ *  @param[out] x x position of the changed area.
+ *  @param[out] y y position of the changed area.
+ *  @param[out] w width of the changed area, 0 if nothing changed.
+ *  @param[out] h height of the changed area, 0 if nothing changed.
+ *
+ *  @note any of the output parameters can be NULL.
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+RLOTTIE_API void lottie_animation_render_damage(Lottie_Animation *animation, size_t frame_num, uint32_t *buffer, size_t width, size_t height, size_t bytes_per_line, size_t *x, size_t *y, size_t *w, size_t *h);
+
 /**
  *  @brief Request to render the content of the frame @p frame_num to buffer @p buffer asynchronously.
  *
@@ -267,6 +360,70 @@ RLOTTIE_API void lottie_animation_render_async(Lottie_Animation *animation, size
  */
 RLOTTIE_API uint32_t *lottie_animation_render_flush(Lottie_Animation *animation);
 
+/**
+ *  @brief Enables caching of the rendered frames of this animation object.
+ *
+ *  @param[in] animation Animation object.
+ *  @param[in] bytes memory budget of the frame cache, 0 disables the cache.
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+RLOTTIE_API void lottie_animation_set_frame_cache_budget(Lottie_Animation *animation, size_t bytes);
+
+/**
+ *  @brief Returns the frame cache statistics of this animation object.
+ *
+ *  @param[in] animation Animation object.
+ *  @param[out] hits frames decoded from the cache.
+ *  @param[out] misses frames that had to be rendered.
+ *  @param[out] bytes memory used by the cached frames.
+ *
+ *  @note any of the output parameters can be NULL.
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+RLOTTIE_API void lottie_animation_get_frame_cache_stats(const Lottie_Animation *animation, size_t *hits, size_t *misses, size_t *bytes);
+
+/**
+ *  @brief Sets the number of threads that blend a frame of this animation object.
+ *
+ *  @param[in] animation Animation object.
+ *  @param[in] count number of threads, 0 or 1 renders on the calling thread only.
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+RLOTTIE_API void lottie_animation_set_render_threads(Lottie_Animation *animation, size_t count);
+
+/**
+ *  @brief Limits the memory of the offscreen surfaces this animation object
+ *         keeps for its next frames.
+ *
+ *  @param[in] animation Animation object.
+ *  @param[in] bytes memory budget of the kept surfaces, 0 removes the limit.
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+RLOTTIE_API void lottie_animation_set_surface_cache_budget(Lottie_Animation *animation, size_t bytes);
+
+/**
+ *  @brief Returns the per stage timings and counters of the last frame
+ *         rendered by this animation object.
+ *
+ *  @param[in] animation Animation object.
+ *  @param[out] stats filled with the statistics of the last frame.
+ *
+ *  @note the statistics are only collected when rlottie is built with the
+ *        profile option, they are all 0 otherwise.
+ *
+ *  @ingroup Lottie_Animation
+ *  @internal
+ */
+RLOTTIE_API void lottie_animation_get_frame_stats(const Lottie_Animation *animation, Lottie_Frame_Stats *stats);
+
 
 /**
  *  @brief Request to change the properties of this animation object.
@@ -323,6 +480,90 @@ RLOTTIE_API const LOTMarkerList* lottie_animation_get_markerlist(Lottie_Animatio
  */
 RLOTTIE_API void lottie_configure_model_cache_size(size_t cacheSize);
 
+/**
+ *  @brief Configures the memory budget of the rlottie model cache.
+ *
+ *  @param[in] bytes  Maximum memory of the cached models in bytes,
+ *                    0 removes the memory limit.
+ *
+ *  @internal
+ */
+RLOTTIE_API void lottie_configure_model_cache_budget(size_t bytes);
+
+/**
+ *  @brief Returns the model cache statistics.
+ *
+ *  @param[out] hits lookups served from the cache.
+ *  @param[out] misses lookups that had to parse the resource.
+ *  @param[out] evictions models dropped to respect the size or budget.
+ *  @param[out] entries models currently cached.
+ *  @param[out] bytes approximate memory of the cached models.
+ *
+ *  @note any of the output parameters can be NULL.
+ *
+ *  @internal
+ */
+RLOTTIE_API void lottie_model_cache_stats(size_t *hits, size_t *misses, size_t *evictions, size_t *entries, size_t *bytes);
+
+/**
+ *  @brief Releases memory held by the caches of all the animations and
+ *         of the library, it is rebuilt on demand.
+ *
+ *  @param[in] level what to release, every level includes the previous ones.
+ *
+ *  @note LOTTIE_TRIM_ALL invalidates the trees returned by
+ *        lottie_animation_render_tree().
+ *
+ *  @internal
+ */
+RLOTTIE_API void lottie_trim_memory(Lottie_Trim_Level level);
+
+/**
+ *  @brief Configures a process wide memory budget of the library, the
+ *         caches are trimmed whenever they grow past it.
+ *
+ *  @param[in] bytes budget in bytes, 0 removes the budget.
+ *
+ *  @internal
+ */
+RLOTTIE_API void lottie_configure_memory_budget(size_t bytes);
+
+/**
+ *  @brief Returns the approximate memory held by the library.
+ *
+ *  @param[out] models parsed models in the model cache.
+ *  @param[out] caches layer bitmaps and cached frames.
+ *  @param[out] scratch gradient tables, rasterizer buffers and offscreen surfaces.
+ *  @param[out] total all the memory accounted, including the rles.
+ *
+ *  @note any of the output parameters can be NULL.
+ *
+ *  @internal
+ */
+RLOTTIE_API void lottie_memory_stats(size_t *models, size_t *caches, size_t *scratch, size_t *total);
+
+/**
+ *  @brief Starts recording a timeline of the rendering, written to @p path
+ *         as Chrome trace event JSON by lottie_trace_stop().
+ *
+ *  @param[in] path file the trace is written to.
+ *
+ *  @return 1 on success, 0 if a trace is already running or rlottie is
+ *          built without the profile option.
+ *
+ *  @internal
+ */
+RLOTTIE_API int lottie_trace_start(const char *path);
+
+/**
+ *  @brief Stops the trace started by lottie_trace_start() and writes it.
+ *
+ *  @return 1 on success, 0 if no trace was running or the file can't be written.
+ *
+ *  @internal
+ */
+RLOTTIE_API int lottie_trace_stop(void);
+
 #ifdef __cplusplus
 }
 #endif
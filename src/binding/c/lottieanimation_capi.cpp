@@ -91,6 +91,35 @@ RLOTTIE_API Lottie_Animation_S *lottie_animation_from_data(const char *data, con
     }
 }
 
+RLOTTIE_API Lottie_Animation_S *lottie_animation_from_binary(const char *path)
+{
+    if (!path) return nullptr;
+
+    if (auto animation = Animation::loadFromBinary(path) ) {
+        Lottie_Animation_S *handle = new Lottie_Animation_S();
+        handle->mAnimation = std::move(animation);
+        return handle;
+    } else {
+        return nullptr;
+    }
+}
+
+RLOTTIE_API int lottie_animation_save_binary(const Lottie_Animation_S *animation, const char *path)
+{
+    if (!animation || !path) return 0;
+
+    return animation->mAnimation->saveBinary(path) ? 1 : 0;
+}
+
+RLOTTIE_API Lottie_Animation_S *lottie_animation_clone(const Lottie_Animation_S *animation)
+{
+    if (!animation) return nullptr;
+
+    Lottie_Animation_S *handle = new Lottie_Animation_S();
+    handle->mAnimation = animation->mAnimation->clone();
+    return handle;
+}
+
 RLOTTIE_API void lottie_animation_destroy(Lottie_Animation_S *animation)
 {
     if (animation) {
@@ -168,6 +197,29 @@ lottie_animation_render(Lottie_Animation_S *animation,
     animation->mAnimation->renderSync(frame_number, surface);
 }
 
+RLOTTIE_API void
+lottie_animation_render_damage(Lottie_Animation_S *animation,
+                               size_t frame_number,
+                               uint32_t *buffer,
+                               size_t width,
+                               size_t height,
+                               size_t bytes_per_line,
+                               size_t *x,
+                               size_t *y,
+                               size_t *w,
+                               size_t *h)
+{
+    if (!animation) return;
+
+    rlottie::Surface surface(buffer, width, height, bytes_per_line);
+    rlottie::DamageRect damage;
+    animation->mAnimation->renderSync(frame_number, surface, damage);
+    if (x) *x = damage.x;
+    if (y) *y = damage.y;
+    if (w) *w = damage.w;
+    if (h) *h = damage.h;
+}
+
 RLOTTIE_API void
 lottie_animation_render_async(Lottie_Animation_S *animation,
                               size_t frame_number,
@@ -195,6 +247,113 @@ lottie_animation_render_flush(Lottie_Animation_S *animation)
     return animation->mBufferRef;
 }
 
+RLOTTIE_API void
+lottie_animation_set_frame_cache_budget(Lottie_Animation_S *animation, size_t bytes)
+{
+    if (!animation) return;
+
+    animation->mAnimation->setFrameCacheBudget(bytes);
+}
+
+RLOTTIE_API void
+lottie_animation_get_frame_cache_stats(const Lottie_Animation_S *animation,
+                                       size_t *hits,
+                                       size_t *misses,
+                                       size_t *bytes)
+{
+    if (!animation) return;
+
+    auto stats = animation->mAnimation->frameCacheStats();
+    if (hits) *hits = stats.hits;
+    if (misses) *misses = stats.misses;
+    if (bytes) *bytes = stats.bytes;
+}
+
+RLOTTIE_API void
+lottie_trim_memory(Lottie_Trim_Level level)
+{
+   switch (level) {
+   case LOTTIE_TRIM_SCRATCH:
+      rlottie::trimMemory(rlottie::TrimLevel::Scratch);
+      break;
+   case LOTTIE_TRIM_CACHES:
+      rlottie::trimMemory(rlottie::TrimLevel::Caches);
+      break;
+   case LOTTIE_TRIM_ALL:
+      rlottie::trimMemory(rlottie::TrimLevel::All);
+      break;
+   }
+}
+
+RLOTTIE_API void
+lottie_configure_memory_budget(size_t bytes)
+{
+   rlottie::configureMemoryBudget(bytes);
+}
+
+RLOTTIE_API void
+lottie_memory_stats(size_t *models, size_t *caches, size_t *scratch, size_t *total)
+{
+   auto stats = rlottie::memoryStats();
+   if (models) *models = stats.models;
+   if (caches) *caches = stats.rasterCaches + stats.frameCaches;
+   if (scratch) *scratch = stats.gradients + stats.rasterizer + stats.surfaces;
+   if (total) *total = stats.total;
+}
+
+RLOTTIE_API int
+lottie_trace_start(const char *path)
+{
+   if (!path) return 0;
+   return rlottie::startTrace(path) ? 1 : 0;
+}
+
+RLOTTIE_API int
+lottie_trace_stop(void)
+{
+   return rlottie::stopTrace() ? 1 : 0;
+}
+
+RLOTTIE_API void
+lottie_animation_set_render_threads(Lottie_Animation_S *animation, size_t count)
+{
+    if (!animation) return;
+
+    animation->mAnimation->setRenderThreads(count);
+}
+
+RLOTTIE_API void
+lottie_animation_set_surface_cache_budget(Lottie_Animation_S *animation, size_t bytes)
+{
+    if (!animation) return;
+
+    animation->mAnimation->setSurfaceCacheBudget(bytes);
+}
+
+RLOTTIE_API void
+lottie_animation_get_frame_stats(const Lottie_Animation_S *animation,
+                                 Lottie_Frame_Stats *      stats)
+{
+    if (!animation || !stats) return;
+
+    auto s = animation->mAnimation->frameStats();
+    stats->frame_time = s.frameTime;
+    stats->update_time = s.updateTime;
+    stats->path_time = s.pathTime;
+    stats->raster_time = s.rasterTime;
+    stats->blend_time = s.blendTime;
+    stats->drawables = s.drawables;
+    stats->spans = s.spans;
+    stats->pixels = s.pixels;
+    stats->surfaces = s.surfaces;
+    stats->surface_allocs = s.surfaceAllocs;
+    stats->surface_hits = s.surfaceHits;
+    stats->surface_releases = s.surfaceReleases;
+    stats->culled_layers = s.culledLayers;
+    stats->culled_drawables = s.culledDrawables;
+    stats->rle_mattes = s.rleMattes;
+}
+
 RLOTTIE_API void
 lottie_animation_property_override(Lottie_Animation_S *animation,
                                    const Lottie_Animation_Property type,
@@ -327,4 +486,21 @@ lottie_configure_model_cache_size(size_t cacheSize)
    rlottie::configureModelCacheSize(cacheSize);
 }
 
+RLOTTIE_API void
+lottie_configure_model_cache_budget(size_t bytes)
+{
+   rlottie::configureModelCacheBudget(bytes);
+}
+
+RLOTTIE_API void
+lottie_model_cache_stats(size_t *hits, size_t *misses, size_t *evictions, size_t *entries, size_t *bytes)
+{
+   auto stats = rlottie::modelCacheStats();
+   if (hits) *hits = stats.hits;
+   if (misses) *misses = stats.misses;
+   if (evictions) *evictions = stats.evictions;
+   if (entries) *entries = stats.entries;
+   if (bytes) *bytes = stats.bytes;
+}
+
 }
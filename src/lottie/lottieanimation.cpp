@@ -20,11 +20,18 @@
  * SOFTWARE.
  */
 #include "config.h"
+#include "lottieframecache.h"
 #include "lottieitem.h"
 #include "lottiemodel.h"
 #include "rlottie.h"
+#include "vmemory.h"
+#include "vprofile.h"
 
+#include <algorithm>
 #include <fstream>
+#include <mutex>
+#include <set>
+#include <unordered_map>
 
 using namespace rlottie;
 using namespace rlottie::internal;
@@ -34,6 +41,70 @@ RLOTTIE_API void rlottie::configureModelCacheSize(size_t cacheSize)
     internal::model::configureModelCacheSize(cacheSize);
 }
 
+RLOTTIE_API void rlottie::configureModelCacheBudget(size_t bytes)
+{
+    internal::model::configureModelCacheBudget(bytes);
+}
+
+RLOTTIE_API rlottie::ModelCacheStats rlottie::modelCacheStats()
+{
+    auto stats = internal::model::modelCacheStats();
+
+    ModelCacheStats result;
+    result.hits = stats.hits;
+    result.misses = stats.misses;
+    result.evictions = stats.evictions;
+    result.entries = stats.entries;
+    result.bytes = stats.bytes;
+    return result;
+}
+
+RLOTTIE_API void rlottie::trimMemory(TrimLevel level)
+{
+    VMemoryBudget::instance().trim(VTrimLevel(level));
+}
+
+RLOTTIE_API void rlottie::configureMemoryBudget(size_t bytes)
+{
+    VMemoryBudget::instance().setBudget(bytes);
+}
+
+RLOTTIE_API rlottie::MemoryStats rlottie::memoryStats()
+{
+    auto usage = VMemoryBudget::instance().usage();
+
+    MemoryStats result;
+    result.models = usage.model;
+    result.gradients = usage.gradient;
+    result.rasterizer = usage.rasterizer;
+    result.surfaces = usage.surface;
+    result.rasterCaches = usage.rasterCache;
+    result.frameCaches = usage.frameCache;
+    result.rles = usage.rle;
+    result.total = usage.total();
+    result.budget = VMemoryBudget::instance().budget();
+    return result;
+}
+
+RLOTTIE_API bool rlottie::startTrace(const std::string &path)
+{
+#ifdef LOTTIE_PROFILE_SUPPORT
+    return VTrace::start(path);
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+RLOTTIE_API bool rlottie::stopTrace()
+{
+#ifdef LOTTIE_PROFILE_SUPPORT
+    return VTrace::stop();
+#else
+    return false;
+#endif
+}
+
 struct RenderTask {
     RenderTask() { receiver = sender.get_future(); }
     std::promise<Surface> sender;
@@ -45,9 +116,24 @@ struct RenderTask {
 };
 using SharedRenderTask = std::shared_ptr<RenderTask>;
 
-class AnimationImpl {
+/*
+ * An animation is only used from one thread at a time but trim() comes in
+ * from any thread, mMutex serializes the two. A trim that finds the
+ * animation busy is kept in mPendingTrim and applied by the call that
+ * holds the lock. All releases the render tree, it is rebuilt from the
+ * model by the next call that needs it.
+ */
+class AnimationImpl : public VMemoryClient {
 public:
+    struct KeyPathValue {
+        size_t     mKeyPath;
+        LOTVariant mValue;
+    };
+
+    AnimationImpl() { VMemoryBudget::instance().add(this); }
+    ~AnimationImpl() override { VMemoryBudget::instance().remove(this); }
     void    init(std::shared_ptr<model::Composition> composition);
+    void    initFrom(const AnimationImpl &other);
     bool    update(size_t frameNo, const VSize &size, bool keepAspectRatio);
     VSize   size() const { return mModel->size(); }
     double  duration() const { return mModel->duration(); }
@@ -55,7 +141,7 @@ public:
     size_t  totalFrame() const { return mModel->totalFrame(); }
     size_t  frameAtPos(double pos) const { return mModel->frameAtPos(pos); }
     Surface render(size_t frameNo, const Surface &surface,
-                   bool keepAspectRatio);
+                   bool keepAspectRatio, VRect *damage = nullptr);
     std::future<Surface> renderAsync(size_t frameNo, Surface &&surface,
                                      bool keepAspectRatio);
     const LOTLayerNode * renderTree(size_t frameNo, const VSize &size);
@@ -68,25 +154,234 @@ public:
         return mLayerList;
     }
     const MarkerList &markers() const { return mModel->markers(); }
+    bool              saveBinary(const std::string &path) const
+    {
+        return model::saveBinary(*mModel, path);
+    }
+    size_t            resolveKeyPath(const std::string &keypath);
     void              setValue(const std::string &keypath, LOTVariant &&value);
+    void              setValue(size_t keyPath, LOTVariant &&value);
+    void              setValues(std::vector<KeyPathValue> &&values);
     void              removeFilter(const std::string &keypath, Property prop);
+    void              setFrameCacheBudget(size_t bytes);
+    void              setRenderThreads(size_t count);
+    void              setSurfaceCacheBudget(size_t bytes);
+    FrameCacheStats   frameCacheStats() const
+    {
+        return mFrameCache ? mFrameCache->stats() : FrameCacheStats{};
+    }
+    FrameStats frameStats() const;
+    void usage(VMemoryUsage &usage) const override;
+    void trim(VTrimLevel level) override;
+
+private:
+    renderer::Composition &renderer()
+    {
+        if (!mRenderer) buildRenderer();
+        return *mRenderer;
+    }
+    void buildRenderer();
+    size_t keyPathHandle(const std::string &keypath);
+    void applyValues(std::vector<KeyPathValue> &values);
+    void release(VTrimLevel level);
+    void applyPendingTrim();
+    bool publishUsage();
+
+    class Guard {
+    public:
+        explicit Guard(AnimationImpl &impl) : mImpl(impl)
+        {
+            mImpl.mMutex.lock();
+            mImpl.applyPendingTrim();
+        }
+        ~Guard()
+        {
+            bool grew = mImpl.publishUsage();
+            mImpl.mMutex.unlock();
+            if (grew) VMemoryBudget::instance().grew();
+        }
+
+    private:
+        AnimationImpl &mImpl;
+    };
+
+    size_t frameNumber(size_t frameNo) const
+    {
+        frameNo += mModel->startFrame();
+        if (frameNo > mModel->endFrame()) frameNo = mModel->endFrame();
+        if (frameNo < mModel->startFrame()) frameNo = mModel->startFrame();
+        return frameNo;
+    }
 
 private:
     mutable LayerInfoList                  mLayerList;
     model::Composition *                   mModel;
+    std::shared_ptr<model::Composition>    mComposition;
     SharedRenderTask                       mTask;
     std::atomic<bool>                      mRenderInProgress;
+#ifdef LOTTIE_PROFILE_SUPPORT
+    // raster tasks of the renderer write to it, so it has to outlive it.
+    VFrameProfile mProfile;
+#endif
     std::unique_ptr<renderer::Composition> mRenderer{nullptr};
+    std::unique_ptr<FrameCache>            mFrameCache{nullptr};
+    size_t                                 mRenderThreads{1};
+    size_t                                 mSurfaceBudget{0};
+
+    std::mutex          mMutex;
+    std::atomic<int>    mPendingTrim{-1};
+    std::atomic<size_t> mSurfaceBytes{0};
+    std::atomic<size_t> mRasterCacheBytes{0};
+    std::atomic<size_t> mFrameCacheBytes{0};
+
+    /*
+     * resolved keypaths, a KeyPathHandle is the index in the list plus one.
+     * Keypaths matching the same contents share an entry, so the list is
+     * bounded by the distinct contents matched rather than by the strings
+     * passed in. mHandles maps every keypath string seen to its entry so
+     * an alias doesn't search the layer tree again. Both live as long as
+     * the animation.
+     */
+    struct KeyPathEntry {
+        std::string              mKeyPath;
+        renderer::KeyPathTargets mTargets;
+    };
+    std::vector<KeyPathEntry>               mKeyPaths;
+    std::unordered_map<std::string, size_t> mHandles;
+
+    /*
+     * the values in effect, one per keypath and property, in the order
+     * they were set. Replayed on a clone and when the render tree is
+     * rebuilt.
+     */
+    std::vector<KeyPathValue> mValues;
 };
 
+size_t AnimationImpl::resolveKeyPath(const std::string &keypath)
+{
+    Guard guard(*this);
+    return keyPathHandle(keypath);
+}
+
 void AnimationImpl::setValue(const std::string &keypath, LOTVariant &&value)
 {
-    if (keypath.empty()) return;
-    mRenderer->setValue(keypath, value);
+    Guard guard(*this);
+    std::vector<KeyPathValue> values;
+    values.push_back({keyPathHandle(keypath), std::move(value)});
+    applyValues(values);
+}
+
+void AnimationImpl::setValue(size_t keyPath, LOTVariant &&value)
+{
+    std::vector<KeyPathValue> values;
+    values.push_back({keyPath, std::move(value)});
+    setValues(std::move(values));
+}
+
+void AnimationImpl::setValues(std::vector<KeyPathValue> &&values)
+{
+    Guard guard(*this);
+    applyValues(values);
+}
+
+// called with mMutex held.
+size_t AnimationImpl::keyPathHandle(const std::string &keypath)
+{
+    if (keypath.empty()) return 0;
+
+    auto alias = mHandles.find(keypath);
+    if (alias != mHandles.end()) return alias->second;
+
+    auto targets = renderer().resolveKeyPath(keypath);
+    auto same = [&targets](const KeyPathEntry &e) {
+        return e.mTargets.size() == targets.size() &&
+               std::equal(targets.begin(), targets.end(), e.mTargets.begin(),
+                          [](const auto &a, const auto &b) {
+                              return a.mLayer == b.mLayer &&
+                                     a.mContent == b.mContent;
+                          });
+    };
+    size_t handle;
+    auto   search = std::find_if(mKeyPaths.begin(), mKeyPaths.end(), same);
+    if (search != mKeyPaths.end()) {
+        handle = size_t(search - mKeyPaths.begin()) + 1;
+    } else {
+        mKeyPaths.push_back({keypath, std::move(targets)});
+        handle = mKeyPaths.size();
+    }
+    mHandles.emplace(keypath, handle);
+    return handle;
+}
+
+/*
+ * Applies the values in the given order and records them in mValues,
+ * called with mMutex held. Values without a valid handle are dropped.
+ */
+void AnimationImpl::applyValues(std::vector<KeyPathValue> &values)
+{
+    values.erase(std::remove_if(values.begin(), values.end(),
+                                [this](const KeyPathValue &v) {
+                                    return !v.mKeyPath ||
+                                           v.mKeyPath > mKeyPaths.size();
+                                }),
+                 values.end());
+    if (values.empty()) return;
+
+    auto &composition = renderer();
+    for (auto &v : values) {
+        composition.setValue(mKeyPaths[v.mKeyPath - 1].mTargets, v.mValue);
+    }
+    if (mFrameCache) mFrameCache->clear();
+
+    // one value per keypath and property, the last one set wins.
+    using Key = std::pair<size_t, rlottie::Property>;
+    auto key = [](const KeyPathValue &v) {
+        return Key(v.mKeyPath, v.mValue.property());
+    };
+    std::set<Key> keys;
+    for (const auto &v : values) keys.insert(key(v));
+    mValues.erase(std::remove_if(mValues.begin(), mValues.end(),
+                                 [&](const KeyPathValue &v) {
+                                     return keys.count(key(v)) != 0;
+                                 }),
+                  mValues.end());
+
+    std::vector<bool> last(values.size());
+    for (size_t i = values.size(); i-- > 0;) last[i] = keys.erase(key(values[i]));
+    for (size_t i = 0; i < values.size(); i++) {
+        if (last[i]) mValues.push_back(std::move(values[i]));
+    }
+}
+
+void AnimationImpl::setFrameCacheBudget(size_t bytes)
+{
+    Guard guard(*this);
+    if (!bytes) {
+        mFrameCache.reset();
+    } else if (mFrameCache) {
+        mFrameCache->setBudget(bytes);
+    } else {
+        mFrameCache = std::make_unique<FrameCache>(bytes);
+    }
+}
+
+void AnimationImpl::setRenderThreads(size_t count)
+{
+    Guard guard(*this);
+    mRenderThreads = count;
+    if (mRenderer) mRenderer->setThreadCount(count);
+}
+
+void AnimationImpl::setSurfaceCacheBudget(size_t bytes)
+{
+    Guard guard(*this);
+    mSurfaceBudget = bytes;
+    if (mRenderer) mRenderer->setSurfaceBudget(bytes);
 }
 
 const LOTLayerNode *AnimationImpl::renderTree(size_t frameNo, const VSize &size)
 {
+    Guard guard(*this);
     if (update(frameNo, size, true)) {
         mRenderer->buildRenderTree();
     }
@@ -96,17 +391,11 @@ const LOTLayerNode *AnimationImpl::renderTree(size_t frameNo, const VSize &size)
 bool AnimationImpl::update(size_t frameNo, const VSize &size,
                            bool keepAspectRatio)
 {
-    frameNo += mModel->startFrame();
-
-    if (frameNo > mModel->endFrame()) frameNo = mModel->endFrame();
-
-    if (frameNo < mModel->startFrame()) frameNo = mModel->startFrame();
-
-    return mRenderer->update(int(frameNo), size, keepAspectRatio);
+    return renderer().update(int(frameNumber(frameNo)), size, keepAspectRatio);
 }
 
 Surface AnimationImpl::render(size_t frameNo, const Surface &surface,
-                              bool keepAspectRatio)
+                              bool keepAspectRatio, VRect *damage)
 {
     bool renderInProgress = mRenderInProgress.load();
     if (renderInProgress) {
@@ -115,11 +404,44 @@ Surface AnimationImpl::render(size_t frameNo, const Surface &surface,
     }
 
     mRenderInProgress.store(true);
-    update(
-        frameNo,
-        VSize(int(surface.drawRegionWidth()), int(surface.drawRegionHeight())),
-        keepAspectRatio);
-    mRenderer->render(surface);
+#ifdef LOTTIE_PROFILE_SUPPORT
+    mProfile.reset();
+    uint64_t start = VFrameProfile::now();
+    VFrameProfile::Current profile(&mProfile);
+#endif
+    VTRACE_SCOPE("render");
+    {
+        Guard guard(*this);
+        // a callback may draw a different frame on every call.
+        FrameCache *frameCache =
+            mFrameCache && !renderer().hasDynamicValue() ? mFrameCache.get()
+                                                         : nullptr;
+        if (frameCache &&
+            frameCache->load(frameNumber(frameNo), surface, keepAspectRatio)) {
+            // the cached frame replaced the whole surface.
+            if (mRenderer) mRenderer->invalidateDamage();
+            if (damage)
+                *damage =
+                    VRect(0, 0, int(surface.width()), int(surface.height()));
+        } else {
+            update(frameNo,
+                   VSize(int(surface.drawRegionWidth()),
+                         int(surface.drawRegionHeight())),
+                   keepAspectRatio);
+            mRenderer->render(surface, damage);
+            if (frameCache)
+                frameCache->save(frameNumber(frameNo), surface,
+                                 keepAspectRatio);
+        }
+        // a trim that came in during the render doesn't wait for the next
+        // call.
+        applyPendingTrim();
+    }
+    // the budget is only enforced once a frame, outside of the lock.
+    VMemoryBudget::instance().enforce();
+#ifdef LOTTIE_PROFILE_SUPPORT
+    mProfile.mFrameTime = VFrameProfile::now() - start;
+#endif
     mRenderInProgress.store(false);
 
     return surface;
@@ -128,10 +450,117 @@ Surface AnimationImpl::render(size_t frameNo, const Surface &surface,
 void AnimationImpl::init(std::shared_ptr<model::Composition> composition)
 {
     mModel = composition.get();
-    mRenderer = std::make_unique<renderer::Composition>(composition);
+    mComposition = std::move(composition);
+    mRenderer = std::make_unique<renderer::Composition>(mComposition);
     mRenderInProgress = false;
 }
 
+void AnimationImpl::initFrom(const AnimationImpl &other)
+{
+    mModel = other.mModel;
+    mComposition = other.mComposition;
+    mRenderInProgress = false;
+
+    // keep the handles of the other animation valid for this one.
+    for (const auto &e : other.mKeyPaths) mKeyPaths.push_back({e.mKeyPath, {}});
+    mHandles = other.mHandles;
+    mValues = other.mValues;
+
+    buildRenderer();
+}
+
+/*
+ * (Re)creates the render tree, the keypaths are resolved again as the
+ * targets point into the tree.
+ */
+void AnimationImpl::buildRenderer()
+{
+    mRenderer = std::make_unique<renderer::Composition>(mComposition);
+    mRenderer->setThreadCount(mRenderThreads);
+    mRenderer->setSurfaceBudget(mSurfaceBudget);
+    for (auto &e : mKeyPaths) e.mTargets = mRenderer->resolveKeyPath(e.mKeyPath);
+
+    for (auto &v : mValues) {
+        mRenderer->setValue(mKeyPaths[v.mKeyPath - 1].mTargets, v.mValue);
+    }
+}
+
+FrameStats AnimationImpl::frameStats() const
+{
+    FrameStats stats;
+#ifdef LOTTIE_PROFILE_SUPPORT
+    auto us = [](uint64_t ns) { return double(ns) / 1000.0; };
+    stats.frameTime = us(mProfile.mFrameTime);
+    stats.updateTime = us(mProfile.mTime[VFrameProfile::Update]);
+    stats.pathTime = us(mProfile.mTime[VFrameProfile::Path]);
+    stats.rasterTime = us(mProfile.mTime[VFrameProfile::Raster]);
+    stats.blendTime = us(mProfile.mTime[VFrameProfile::Blend]);
+    stats.drawables = mProfile.mDrawables;
+    stats.spans = mProfile.mSpans;
+    stats.pixels = mProfile.mPixels;
+    stats.surfaces = mProfile.mSurfaces;
+    stats.surfaceAllocs = mProfile.mSurfaceAllocs;
+    stats.surfaceHits = mProfile.mSurfaceHits;
+    stats.surfaceReleases = mProfile.mSurfaceReleases;
+    stats.culledLayers = mProfile.mCulledLayers;
+    stats.culledDrawables = mProfile.mCulledDrawables;
+    stats.rleMattes = mProfile.mRleMattes;
+#endif
+    return stats;
+}
+
+void AnimationImpl::usage(VMemoryUsage &usage) const
+{
+    usage.surface += mSurfaceBytes.load(std::memory_order_relaxed);
+    usage.rasterCache += mRasterCacheBytes.load(std::memory_order_relaxed);
+    usage.frameCache += mFrameCacheBytes.load(std::memory_order_relaxed);
+}
+
+void AnimationImpl::trim(VTrimLevel level)
+{
+    if (mMutex.try_lock()) {
+        release(level);
+        publishUsage();
+        mMutex.unlock();
+        return;
+    }
+
+    // keep the strongest of the pending trims.
+    int pending = mPendingTrim.load();
+    while (pending < int(level) &&
+           !mPendingTrim.compare_exchange_weak(pending, int(level))) {
+    }
+}
+
+void AnimationImpl::release(VTrimLevel level)
+{
+    if (level == VTrimLevel::All) {
+        mRenderer.reset();
+    } else if (mRenderer) {
+        mRenderer->trim(level);
+    }
+    if (level != VTrimLevel::Scratch && mFrameCache) mFrameCache->clear();
+}
+
+void AnimationImpl::applyPendingTrim()
+{
+    int level = mPendingTrim.exchange(-1);
+    if (level >= 0) release(VTrimLevel(level));
+}
+
+// returns true if the animation holds more memory than it last reported.
+bool AnimationImpl::publishUsage()
+{
+    VMemoryUsage usage;
+    if (mRenderer) mRenderer->memoryUsage(usage);
+    usage.frameCache = mFrameCache ? mFrameCache->stats().bytes : 0;
+
+    size_t prev = mSurfaceBytes.exchange(usage.surface) +
+                  mRasterCacheBytes.exchange(usage.rasterCache) +
+                  mFrameCacheBytes.exchange(usage.frameCache);
+    return usage.total() > prev;
+}
+
 #ifdef LOTTIE_THREAD_SUPPORT
 
 #include <thread>
@@ -289,6 +718,26 @@ std::unique_ptr<Animation> Animation::loadFromData(
     return nullptr;
 }
 
+std::unique_ptr<Animation> Animation::loadFromData(
+    std::unique_ptr<char[]> data, size_t size, const std::string &key,
+    const std::string &resourcePath, bool cachePolicy)
+{
+    if (!data || !size) {
+        vWarning << "jason data is empty";
+        return nullptr;
+    }
+
+    auto composition = model::loadFromData(std::move(data), size, key,
+                                           resourcePath, cachePolicy);
+    if (composition) {
+        auto animation = std::unique_ptr<Animation>(new Animation);
+        animation->d->init(std::move(composition));
+        return animation;
+    }
+
+    return nullptr;
+}
+
 std::unique_ptr<Animation> Animation::loadFromData(std::string jsonData,
                                                    std::string resourcePath,
                                                    ColorFilter filter)
@@ -325,6 +774,30 @@ std::unique_ptr<Animation> Animation::loadFromFile(const std::string &path,
     return nullptr;
 }
 
+std::unique_ptr<Animation> Animation::loadFromBinary(const std::string &path,
+                                                     bool cachePolicy)
+{
+    if (path.empty()) {
+        vWarning << "File path is empty";
+        return nullptr;
+    }
+
+    auto composition = model::loadFromBinary(path, cachePolicy);
+    if (composition) {
+        auto animation = std::unique_ptr<Animation>(new Animation);
+        animation->d->init(std::move(composition));
+        return animation;
+    }
+    return nullptr;
+}
+
+bool Animation::saveBinary(const std::string &path) const
+{
+    if (path.empty()) return false;
+
+    return d->saveBinary(path);
+}
+
 void Animation::size(size_t &width, size_t &height) const
 {
     VSize sz = d->size();
@@ -371,6 +844,49 @@ void Animation::renderSync(size_t frameNo, Surface surface,
     d->render(frameNo, surface, keepAspectRatio);
 }
 
+void Animation::renderSync(size_t frameNo, Surface surface, DamageRect &damage,
+                           bool keepAspectRatio)
+{
+    VRect rect;
+    d->render(frameNo, surface, keepAspectRatio, &rect);
+    damage.x = size_t(rect.x());
+    damage.y = size_t(rect.y());
+    damage.w = size_t(rect.width());
+    damage.h = size_t(rect.height());
+}
+
+void Animation::setFrameCacheBudget(size_t bytes)
+{
+    d->setFrameCacheBudget(bytes);
+}
+
+FrameCacheStats Animation::frameCacheStats() const
+{
+    return d->frameCacheStats();
+}
+
+FrameStats Animation::frameStats() const
+{
+    return d->frameStats();
+}
+
+void Animation::setRenderThreads(size_t count)
+{
+    d->setRenderThreads(count);
+}
+
+void Animation::setSurfaceCacheBudget(size_t bytes)
+{
+    d->setSurfaceCacheBudget(bytes);
+}
+
+std::unique_ptr<Animation> Animation::clone() const
+{
+    auto animation = std::unique_ptr<Animation>(new Animation);
+    animation->d->initFrom(*d);
+    return animation;
+}
+
 const LayerInfoList &Animation::layers() const
 {
     return d->layerInfoList();
@@ -384,29 +900,33 @@ const MarkerList &Animation::markers() const
 void Animation::setValue(Color_Type, Property prop, const std::string &keypath,
                          Color value)
 {
-    d->setValue(keypath,
-                LOTVariant(prop, [value](const FrameInfo &) { return value; }));
+    LOTVariant variant(prop, [value](const FrameInfo &) { return value; });
+    variant.setConstant(true);
+    d->setValue(keypath, std::move(variant));
 }
 
 void Animation::setValue(Float_Type, Property prop, const std::string &keypath,
                          float value)
 {
-    d->setValue(keypath,
-                LOTVariant(prop, [value](const FrameInfo &) { return value; }));
+    LOTVariant variant(prop, [value](const FrameInfo &) { return value; });
+    variant.setConstant(true);
+    d->setValue(keypath, std::move(variant));
 }
 
 void Animation::setValue(Size_Type, Property prop, const std::string &keypath,
                          Size value)
 {
-    d->setValue(keypath,
-                LOTVariant(prop, [value](const FrameInfo &) { return value; }));
+    LOTVariant variant(prop, [value](const FrameInfo &) { return value; });
+    variant.setConstant(true);
+    d->setValue(keypath, std::move(variant));
 }
 
 void Animation::setValue(Point_Type, Property prop, const std::string &keypath,
                          Point value)
 {
-    d->setValue(keypath,
-                LOTVariant(prop, [value](const FrameInfo &) { return value; }));
+    LOTVariant variant(prop, [value](const FrameInfo &) { return value; });
+    variant.setConstant(true);
+    d->setValue(keypath, std::move(variant));
 }
 
 void Animation::setValue(Color_Type, Property prop, const std::string &keypath,
@@ -433,6 +953,105 @@ void Animation::setValue(Point_Type, Property prop, const std::string &keypath,
     d->setValue(keypath, LOTVariant(prop, value));
 }
 
+KeyPathHandle Animation::resolveKeyPath(const std::string &keypath)
+{
+    return KeyPathHandle(d->resolveKeyPath(keypath));
+}
+
+void Animation::setValue(Color_Type, Property prop, const KeyPathHandle &keyPath,
+                         Color value)
+{
+    LOTVariant variant(prop, [value](const FrameInfo &) { return value; });
+    variant.setConstant(true);
+    d->setValue(keyPath.mId, std::move(variant));
+}
+
+void Animation::setValue(Float_Type, Property prop, const KeyPathHandle &keyPath,
+                         float value)
+{
+    LOTVariant variant(prop, [value](const FrameInfo &) { return value; });
+    variant.setConstant(true);
+    d->setValue(keyPath.mId, std::move(variant));
+}
+
+void Animation::setValue(Size_Type, Property prop, const KeyPathHandle &keyPath,
+                         Size value)
+{
+    LOTVariant variant(prop, [value](const FrameInfo &) { return value; });
+    variant.setConstant(true);
+    d->setValue(keyPath.mId, std::move(variant));
+}
+
+void Animation::setValue(Point_Type, Property prop, const KeyPathHandle &keyPath,
+                         Point value)
+{
+    LOTVariant variant(prop, [value](const FrameInfo &) { return value; });
+    variant.setConstant(true);
+    d->setValue(keyPath.mId, std::move(variant));
+}
+
+void Animation::setValue(Color_Type, Property prop, const KeyPathHandle &keyPath,
+                         std::function<Color(const FrameInfo &)> &&value)
+{
+    d->setValue(keyPath.mId, LOTVariant(prop, value));
+}
+
+void Animation::setValue(Float_Type, Property prop, const KeyPathHandle &keyPath,
+                         std::function<float(const FrameInfo &)> &&value)
+{
+    d->setValue(keyPath.mId, LOTVariant(prop, value));
+}
+
+void Animation::setValue(Size_Type, Property prop, const KeyPathHandle &keyPath,
+                         std::function<Size(const FrameInfo &)> &&value)
+{
+    d->setValue(keyPath.mId, LOTVariant(prop, value));
+}
+
+void Animation::setValue(Point_Type, Property prop, const KeyPathHandle &keyPath,
+                         std::function<Point(const FrameInfo &)> &&value)
+{
+    d->setValue(keyPath.mId, LOTVariant(prop, value));
+}
+
+void Animation::setValues(const ValueBatch &batch)
+{
+    std::vector<AnimationImpl::KeyPathValue> values;
+    values.reserve(batch.mValues.size());
+    for (const auto &e : batch.mValues) {
+        LOTVariant variant = [&e]() {
+            switch (e.property) {
+            case Property::FillColor:
+            case Property::StrokeColor: {
+                Color value(e.data[0], e.data[1], e.data[2]);
+                return LOTVariant(e.property,
+                                  [value](const FrameInfo &) { return value; });
+            }
+            case Property::TrAnchor:
+            case Property::TrPosition:
+            case Property::TrimEnd: {
+                Point value(e.data[0], e.data[1]);
+                return LOTVariant(e.property,
+                                  [value](const FrameInfo &) { return value; });
+            }
+            case Property::TrScale: {
+                Size value(e.data[0], e.data[1]);
+                return LOTVariant(e.property,
+                                  [value](const FrameInfo &) { return value; });
+            }
+            default: {
+                float value = e.data[0];
+                return LOTVariant(e.property,
+                                  [value](const FrameInfo &) { return value; });
+            }
+            }
+        }();
+        variant.setConstant(true);
+        values.push_back({e.keyPath, std::move(variant)});
+    }
+    d->setValues(std::move(values));
+}
+
 Animation::~Animation() = default;
 Animation::Animation() : d(std::make_unique<AnimationImpl>()) {}
 
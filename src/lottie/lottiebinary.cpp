@@ -0,0 +1,1091 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+
+#include "lottiemodel.h"
+
+using namespace rlottie::internal;
+
+/*
+ * Binary model format.
+ *
+ * The binary format is a dump of the model::Composition tree as it looks
+ * after parsing (repeater objects processed, position keyframes cached and
+ * precomp references resolved). Loading it back is a single linear walk over
+ * the buffer without any json tokenizing, key comparison or image decoding.
+ *
+ * Plain data (float, VPointF, VMatrix, VInterpolator ...) is stored in host
+ * layout. The header records the format version, byte order and size of
+ * those types so that a file written by a different build or architecture
+ * is rejected and the caller can fall back to the json resource.
+ *
+ * Objects shared in the model (asset layers referenced by precomp layers,
+ * rounded corners referenced by rects, interpolators shared by keyframes)
+ * are written once and referenced by index afterwards. Index 0 is nullptr,
+ * index (number of objects seen so far + 1) means the object data follows.
+ */
+
+namespace {
+
+constexpr char     kMagic[4] = {'R', 'L', 'O', 'T'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kByteOrder = 0x01020304;
+constexpr int      kMaxObjectDepth = 64;
+
+struct TypeInfo {
+    uint16_t floatSize{sizeof(float)};
+    uint16_t pointSize{sizeof(VPointF)};
+    uint16_t matrixSize{sizeof(VMatrix)};
+    uint16_t interpolatorSize{sizeof(VInterpolator)};
+    bool     operator==(const TypeInfo &o) const
+    {
+        return floatSize == o.floatSize && pointSize == o.pointSize &&
+               matrixSize == o.matrixSize &&
+               interpolatorSize == o.interpolatorSize;
+    }
+};
+
+class BinaryWriter {
+public:
+    std::string save(const model::Composition &comp);
+
+private:
+    template <typename T>
+    void write(const T &value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "only plain data can be written as is");
+        mBuffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+    void write(const std::string &str) { write(str.c_str(), str.size()); }
+    void write(const char *str, size_t len)
+    {
+        write(uint32_t(len));
+        mBuffer.append(str, len);
+    }
+    void writeFlag(bool value) { write(uint8_t(value)); }
+
+    void write(const model::PathData &path);
+    void write(const model::Gradient::Data &grad);
+    void write(const VBitmap &bitmap);
+    void write(const model::Dash &dash);
+    void write(const model::Mask &mask);
+    void write(const model::Repeater::Transform &transform);
+    void writeInterpolator(const VInterpolator *interpolator);
+    void writeAsset(const model::Asset *asset);
+    void writeObject(const model::Object *obj);
+    void writeGroup(const model::Group *obj);
+    void writeLayer(const model::Layer *obj);
+    void writeTransform(const model::Transform *obj);
+    void writeGradient(const model::Gradient *obj);
+
+    template <typename T>
+    void writeValue(const model::Value<T> &value)
+    {
+        write(value.start_);
+        write(value.end_);
+    }
+
+    template <typename T>
+    void writeValue(const model::Value<T, model::Position> &value)
+    {
+        write(value.start_);
+        write(value.end_);
+        write(value.inTangent_);
+        write(value.outTangent_);
+        write(value.length_);
+        writeFlag(value.hasTangent_);
+    }
+
+    template <typename T, typename Tag>
+    void write(const model::Property<T, Tag> &prop)
+    {
+        writeFlag(prop.isStatic());
+        if (prop.isStatic()) {
+            write(prop.value());
+            return;
+        }
+        const auto &frames = prop.animation().frames_;
+        write(uint32_t(frames.size()));
+        for (const auto &frame : frames) {
+            write(frame.start_);
+            write(frame.end_);
+            writeInterpolator(frame.interpolator_);
+            writeValue(frame.value_);
+        }
+    }
+
+private:
+    std::string                                              mBuffer;
+    std::unordered_map<const model::Object *, uint32_t>      mObjects;
+    std::unordered_map<const VInterpolator *, uint32_t>      mInterpolators;
+    std::unordered_map<const model::Asset *, uint32_t>       mAssets;
+};
+
+std::string BinaryWriter::save(const model::Composition &comp)
+{
+    mBuffer.append(kMagic, sizeof(kMagic));
+    write(kVersion);
+    write(kByteOrder);
+    write(TypeInfo());
+
+    write(comp.mVersion);
+    write(comp.mSize);
+    write(int64_t(comp.mStartFrame));
+    write(int64_t(comp.mEndFrame));
+    write(comp.mFrameRate);
+    write(comp.mBlendMode);
+    writeFlag(comp.isStatic());
+
+    write(uint32_t(comp.mMarkers.size()));
+    for (const auto &marker : comp.mMarkers) {
+        write(std::get<0>(marker));
+        write(int32_t(std::get<1>(marker)));
+        write(int32_t(std::get<2>(marker)));
+    }
+
+    // assets are numbered first as image layers can refer to any of them.
+    write(uint32_t(comp.mAssets.size()));
+    for (const auto &e : comp.mAssets) {
+        mAssets[e.second] = uint32_t(mAssets.size() + 1);
+        write(e.first);
+        writeAsset(e.second);
+    }
+    for (const auto &e : comp.mAssets) {
+        write(uint32_t(e.second->mLayers.size()));
+        for (const auto &layer : e.second->mLayers) writeObject(layer);
+    }
+
+    writeObject(comp.mRootLayer);
+
+    return std::move(mBuffer);
+}
+
+void BinaryWriter::write(const model::PathData &path)
+{
+    writeFlag(path.mClosed);
+    write(uint32_t(path.mPoints.size()));
+    mBuffer.append(reinterpret_cast<const char *>(path.mPoints.data()),
+                   path.mPoints.size() * sizeof(VPointF));
+}
+
+void BinaryWriter::write(const model::Gradient::Data &grad)
+{
+    write(uint32_t(grad.mGradient.size()));
+    mBuffer.append(reinterpret_cast<const char *>(grad.mGradient.data()),
+                   grad.mGradient.size() * sizeof(float));
+}
+
+void BinaryWriter::write(const VBitmap &bitmap)
+{
+    write(uint32_t(bitmap.width()));
+    write(uint32_t(bitmap.height()));
+    write(bitmap.format());
+    if (!bitmap.valid()) return;
+
+    size_t lineSize = bitmap.width() * bitmap.depth() / 8;
+    for (size_t i = 0; i < bitmap.height(); i++) {
+        mBuffer.append(
+            reinterpret_cast<const char *>(bitmap.data() + i * bitmap.stride()),
+            lineSize);
+    }
+}
+
+void BinaryWriter::write(const model::Dash &dash)
+{
+    write(uint32_t(dash.mData.size()));
+    for (const auto &e : dash.mData) write(e);
+}
+
+void BinaryWriter::write(const model::Mask &mask)
+{
+    write(mask.mShape);
+    write(mask.mOpacity);
+    writeFlag(mask.mInv);
+    writeFlag(mask.mIsStatic);
+    write(mask.mMode);
+}
+
+void BinaryWriter::write(const model::Repeater::Transform &transform)
+{
+    write(transform.mRotation);
+    write(transform.mScale);
+    write(transform.mPosition);
+    write(transform.mAnchor);
+    write(transform.mStartOpacity);
+    write(transform.mEndOpacity);
+}
+
+void BinaryWriter::writeInterpolator(const VInterpolator *interpolator)
+{
+    static_assert(std::is_trivially_copyable<VInterpolator>::value,
+                  "VInterpolator is written as is");
+    if (!interpolator) {
+        write(uint32_t(0));
+        return;
+    }
+    auto search = mInterpolators.find(interpolator);
+    if (search != mInterpolators.end()) {
+        write(search->second);
+        return;
+    }
+    auto id = uint32_t(mInterpolators.size() + 1);
+    mInterpolators[interpolator] = id;
+    write(id);
+    write(*interpolator);
+}
+
+void BinaryWriter::writeAsset(const model::Asset *asset)
+{
+    write(asset->mAssetType);
+    writeFlag(asset->mStatic);
+    write(asset->mRefId);
+    write(int32_t(asset->mWidth));
+    write(int32_t(asset->mHeight));
+    write(asset->mBitmap);
+}
+
+void BinaryWriter::writeObject(const model::Object *obj)
+{
+    if (!obj) {
+        write(uint32_t(0));
+        return;
+    }
+    auto search = mObjects.find(obj);
+    if (search != mObjects.end()) {
+        write(search->second);
+        return;
+    }
+    auto id = uint32_t(mObjects.size() + 1);
+    mObjects[obj] = id;
+    write(id);
+
+    write(obj->type());
+    writeFlag(obj->isStatic());
+    writeFlag(obj->hidden());
+    auto name = obj->name();
+    write(name ? name : "", name ? strlen(name) : 0);
+
+    switch (obj->type()) {
+    case model::Object::Type::Layer: {
+        writeLayer(static_cast<const model::Layer *>(obj));
+        break;
+    }
+    case model::Object::Type::Group: {
+        writeGroup(static_cast<const model::Group *>(obj));
+        break;
+    }
+    case model::Object::Type::Transform: {
+        writeTransform(static_cast<const model::Transform *>(obj));
+        break;
+    }
+    case model::Object::Type::Fill: {
+        auto fill = static_cast<const model::Fill *>(obj);
+        write(fill->mFillRule);
+        writeFlag(fill->mEnabled);
+        write(fill->mColor);
+        write(fill->mOpacity);
+        break;
+    }
+    case model::Object::Type::Stroke: {
+        auto stroke = static_cast<const model::Stroke *>(obj);
+        write(stroke->mColor);
+        write(stroke->mOpacity);
+        write(stroke->mWidth);
+        write(stroke->mCapStyle);
+        write(stroke->mJoinStyle);
+        write(stroke->mMiterLimit);
+        write(stroke->mDash);
+        writeFlag(stroke->mEnabled);
+        break;
+    }
+    case model::Object::Type::GFill: {
+        auto fill = static_cast<const model::GradientFill *>(obj);
+        writeGradient(fill);
+        write(fill->mFillRule);
+        break;
+    }
+    case model::Object::Type::GStroke: {
+        auto stroke = static_cast<const model::GradientStroke *>(obj);
+        writeGradient(stroke);
+        write(stroke->mWidth);
+        write(stroke->mCapStyle);
+        write(stroke->mJoinStyle);
+        write(stroke->mMiterLimit);
+        write(stroke->mDash);
+        break;
+    }
+    case model::Object::Type::Rect: {
+        auto rect = static_cast<const model::Rect *>(obj);
+        write(int32_t(rect->mDirection));
+        writeObject(rect->mRoundedCorner);
+        write(rect->mPos);
+        write(rect->mSize);
+        write(rect->mRound);
+        break;
+    }
+    case model::Object::Type::Ellipse: {
+        auto ellipse = static_cast<const model::Ellipse *>(obj);
+        write(int32_t(ellipse->mDirection));
+        write(ellipse->mPos);
+        write(ellipse->mSize);
+        break;
+    }
+    case model::Object::Type::Path: {
+        auto path = static_cast<const model::Path *>(obj);
+        write(int32_t(path->mDirection));
+        write(path->mShape);
+        break;
+    }
+    case model::Object::Type::Polystar: {
+        auto star = static_cast<const model::Polystar *>(obj);
+        write(int32_t(star->mDirection));
+        write(star->mPolyType);
+        write(star->mPos);
+        write(star->mPointCount);
+        write(star->mInnerRadius);
+        write(star->mOuterRadius);
+        write(star->mInnerRoundness);
+        write(star->mOuterRoundness);
+        write(star->mRotation);
+        break;
+    }
+    case model::Object::Type::Trim: {
+        auto trim = static_cast<const model::Trim *>(obj);
+        write(trim->mStart);
+        write(trim->mEnd);
+        write(trim->mOffset);
+        write(trim->mTrimType);
+        break;
+    }
+    case model::Object::Type::Repeater: {
+        auto repeater = static_cast<const model::Repeater *>(obj);
+        writeObject(repeater->mContent);
+        write(repeater->mTransform);
+        write(repeater->mCopies);
+        write(repeater->mOffset);
+        write(repeater->mMaxCopies);
+        writeFlag(repeater->mProcessed);
+        break;
+    }
+    case model::Object::Type::RoundedCorner: {
+        write(static_cast<const model::RoundedCorner *>(obj)->mRadius);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void BinaryWriter::writeGroup(const model::Group *obj)
+{
+    write(uint32_t(obj->mChildren.size()));
+    for (const auto &child : obj->mChildren) writeObject(child);
+    writeObject(obj->mTransform);
+}
+
+void BinaryWriter::writeLayer(const model::Layer *obj)
+{
+    writeGroup(obj);
+    write(obj->mMatteType);
+    write(obj->mLayerType);
+    write(obj->mBlendMode);
+    writeFlag(obj->mHasRoundedCorner);
+    writeFlag(obj->mHasPathOperator);
+    writeFlag(obj->mHasMask);
+    writeFlag(obj->mHasRepeater);
+    writeFlag(obj->mHasGradient);
+    writeFlag(obj->mAutoOrient);
+    write(obj->mLayerSize);
+    write(int32_t(obj->mParentId));
+    write(int32_t(obj->mId));
+    write(obj->mTimeStreatch);
+    write(int32_t(obj->mInFrame));
+    write(int32_t(obj->mOutFrame));
+    write(int32_t(obj->mStartFrame));
+
+    auto extra = obj->mExtra.get();
+    writeFlag(extra != nullptr);
+    if (!extra) return;
+
+    write(extra->mSolidColor);
+    write(extra->mPreCompRefId);
+    write(extra->mTimeRemap);
+    auto asset = mAssets.find(extra->mAsset);
+    write(asset != mAssets.end() ? asset->second : uint32_t(0));
+    write(uint32_t(extra->mMasks.size()));
+    for (const auto &mask : extra->mMasks) write(*mask);
+}
+
+void BinaryWriter::writeTransform(const model::Transform *obj)
+{
+    auto data = obj->data();
+    writeFlag(data == nullptr);
+    if (!data) {
+        write(obj->matrix(0));
+        write(obj->opacity(0));
+        return;
+    }
+    write(data->mRotation);
+    write(data->mScale);
+    write(data->mPosition);
+    write(data->mAnchor);
+    write(data->mOpacity);
+
+    auto extra = data->mExtra.get();
+    writeFlag(extra != nullptr);
+    if (!extra) return;
+
+    write(extra->m3DRx);
+    write(extra->m3DRy);
+    write(extra->m3DRz);
+    write(extra->mSeparateX);
+    write(extra->mSeparateY);
+    writeFlag(extra->mSeparate);
+    writeFlag(extra->m3DData);
+}
+
+void BinaryWriter::writeGradient(const model::Gradient *obj)
+{
+    write(int32_t(obj->mGradientType));
+    write(obj->mStartPoint);
+    write(obj->mEndPoint);
+    write(obj->mHighlightLength);
+    write(obj->mHighlightAngle);
+    write(obj->mOpacity);
+    write(obj->mGradient);
+    write(int32_t(obj->mColorPoints));
+    writeFlag(obj->mEnabled);
+}
+
+/*
+ * The reader never trusts the input. Every read is bounds checked, list
+ * sizes are validated against the remaining bytes and object references
+ * are type checked. On the first error the reader stops and the partially
+ * built composition is dropped.
+ */
+class BinaryReader {
+public:
+    BinaryReader(const char *data, size_t length)
+        : mCur(data), mEnd(data + length)
+    {
+    }
+    std::shared_ptr<model::Composition> load();
+
+private:
+    VArenaAlloc &allocator() { return mComposition->mArenaAlloc; }
+    bool         valid() const { return !mError; }
+    void         error() { mError = true; }
+    size_t       remaining() const { return size_t(mEnd - mCur); }
+
+    template <typename T>
+    T read()
+    {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "only plain data can be read as is");
+        T value{};
+        read(&value, sizeof(T));
+        return value;
+    }
+    void read(void *dst, size_t size)
+    {
+        if (mError || size > remaining()) {
+            error();
+            return;
+        }
+        memcpy(dst, mCur, size);
+        mCur += size;
+    }
+    bool readFlag() { return read<uint8_t>() != 0; }
+    // returns a element count only if that many elements can be present
+    // in the remaining buffer.
+    uint32_t readCount(size_t elementSize)
+    {
+        auto count = read<uint32_t>();
+        if (elementSize && count > remaining() / elementSize) {
+            error();
+            return 0;
+        }
+        return count;
+    }
+    template <typename T>
+    T readEnum(T last)
+    {
+        using U = std::make_unsigned_t<std::underlying_type_t<T>>;
+        auto value = read<T>();
+        if (U(value) > U(last)) {
+            error();
+            return T{};
+        }
+        return value;
+    }
+    std::string readString()
+    {
+        auto        len = readCount(1);
+        std::string str(mCur, mError ? 0 : len);
+        mCur += str.size();
+        return str;
+    }
+
+    void readValue(float &value) { value = read<float>(); }
+    void readValue(VPointF &value) { value = read<VPointF>(); }
+    void readValue(model::Color &value) { value = read<model::Color>(); }
+    void readValue(model::PathData &path);
+    void readValue(model::Gradient::Data &grad);
+    void read(VBitmap &bitmap);
+    void read(model::Dash &dash);
+    void read(model::Mask &mask);
+    void read(model::Repeater::Transform &transform);
+    VInterpolator *readInterpolator();
+    void           readAsset(model::Asset *asset);
+    model::Object *readObject();
+    void           readObjectBody(model::Object *obj);
+    void           readGroup(model::Group *obj);
+    void           readLayer(model::Layer *obj);
+    void           readTransform(model::Transform *obj);
+    void           readGradient(model::Gradient *obj);
+
+    template <typename T>
+    T *readObject(model::Object::Type type)
+    {
+        auto obj = readObject();
+        if (obj && obj->type() != type) {
+            error();
+            return nullptr;
+        }
+        return static_cast<T *>(obj);
+    }
+
+    template <typename T>
+    void readFrameValue(model::Value<T> &value)
+    {
+        readValue(value.start_);
+        readValue(value.end_);
+    }
+
+    template <typename T>
+    void readFrameValue(model::Value<T, model::Position> &value)
+    {
+        readValue(value.start_);
+        readValue(value.end_);
+        readValue(value.inTangent_);
+        readValue(value.outTangent_);
+        value.length_ = read<float>();
+        value.hasTangent_ = readFlag();
+    }
+
+    template <typename T, typename Tag>
+    void read(model::Property<T, Tag> &prop)
+    {
+        if (readFlag()) {
+            readValue(prop.value());
+            return;
+        }
+        auto &frames = prop.animation().frames_;
+        // each frame is at least start, end, interpolator and a value.
+        auto count = readCount(3 * sizeof(float));
+        frames.reserve(count);
+        for (uint32_t i = 0; i < count && valid(); i++) {
+            frames.emplace_back();
+            auto &frame = frames.back();
+            frame.start_ = read<float>();
+            frame.end_ = read<float>();
+            frame.interpolator_ = readInterpolator();
+            readFrameValue(frame.value_);
+        }
+    }
+
+private:
+    const char *                        mCur;
+    const char *                        mEnd;
+    std::shared_ptr<model::Composition> mComposition;
+    std::vector<model::Object *>        mObjects;
+    std::vector<bool>                   mComplete;
+    std::vector<VInterpolator *>        mInterpolators;
+    std::vector<model::Asset *>         mAssets;
+    int                                 mDepth{0};
+    bool                                mError{false};
+};
+
+std::shared_ptr<model::Composition> BinaryReader::load()
+{
+    char magic[sizeof(kMagic)];
+    read(magic, sizeof(magic));
+    if (!valid() || memcmp(magic, kMagic, sizeof(kMagic)) ||
+        read<uint32_t>() != kVersion || read<uint32_t>() != kByteOrder ||
+        !(read<TypeInfo>() == TypeInfo())) {
+        vWarning << "Binary data is not a compatible rlottie model!";
+        return {};
+    }
+
+    mComposition = std::make_shared<model::Composition>();
+    auto comp = mComposition.get();
+
+    comp->mVersion = readString();
+    comp->mSize = read<VSize>();
+    comp->mStartFrame = long(read<int64_t>());
+    comp->mEndFrame = long(read<int64_t>());
+    comp->mFrameRate = read<float>();
+    comp->mBlendMode = readEnum(model::BlendMode::OverLay);
+    comp->setStatic(readFlag());
+
+    auto markerCount = readCount(3 * sizeof(uint32_t));
+    for (uint32_t i = 0; i < markerCount && valid(); i++) {
+        auto name = readString();
+        auto start = read<int32_t>();
+        auto end = read<int32_t>();
+        comp->mMarkers.emplace_back(std::move(name), start, end);
+    }
+
+    auto assetCount = readCount(sizeof(uint32_t));
+    mAssets.reserve(assetCount);
+    for (uint32_t i = 0; i < assetCount && valid(); i++) {
+        auto key = readString();
+        auto asset = allocator().make<model::Asset>();
+        readAsset(asset);
+        comp->mAssets[std::move(key)] = asset;
+        mAssets.push_back(asset);
+    }
+    for (auto asset : mAssets) {
+        auto count = readCount(sizeof(uint32_t));
+        for (uint32_t i = 0; i < count && valid(); i++) {
+            auto layer = readObject();
+            if (layer) asset->mLayers.push_back(layer);
+        }
+    }
+
+    comp->mRootLayer = readObject<model::Layer>(model::Object::Type::Layer);
+
+    if (!valid() || !comp->mRootLayer ||
+        comp->mStartFrame > comp->mEndFrame) {
+        vWarning << "Binary model data is corrupted!";
+        return {};
+    }
+
+    comp->updateStats();
+
+    return std::move(mComposition);
+}
+
+void BinaryReader::readValue(model::PathData &path)
+{
+    path.mClosed = readFlag();
+    auto count = readCount(sizeof(VPointF));
+    // points are stored as move + n * cubic.
+    if (count && (count % 3) != 1) error();
+    if (!valid()) return;
+    path.mPoints.resize(count);
+    read(path.mPoints.data(), count * sizeof(VPointF));
+}
+
+void BinaryReader::readValue(model::Gradient::Data &grad)
+{
+    auto count = readCount(sizeof(float));
+    if (!valid()) return;
+    grad.mGradient.resize(count);
+    read(grad.mGradient.data(), count * sizeof(float));
+}
+
+void BinaryReader::read(VBitmap &bitmap)
+{
+    auto width = read<uint32_t>();
+    auto height = read<uint32_t>();
+    auto format = readEnum(VBitmap::Format::ARGB32_Premultiplied);
+    if (!valid() || !width || !height || format == VBitmap::Format::Invalid)
+        return;
+
+    size_t depth = (format == VBitmap::Format::Alpha8) ? 1 : 4;
+    if (width > remaining() / depth / height) {
+        error();
+        return;
+    }
+    bitmap = VBitmap(width, height, format);
+    for (size_t i = 0; i < height; i++) {
+        read(bitmap.data() + i * bitmap.stride(), width * depth);
+    }
+}
+
+void BinaryReader::read(model::Dash &dash)
+{
+    auto count = readCount(sizeof(uint8_t));
+    for (uint32_t i = 0; i < count && valid(); i++) {
+        dash.mData.emplace_back();
+        read(dash.mData.back());
+    }
+}
+
+void BinaryReader::read(model::Mask &mask)
+{
+    read(mask.mShape);
+    read(mask.mOpacity);
+    mask.mInv = readFlag();
+    mask.mIsStatic = readFlag();
+    mask.mMode = readEnum(model::Mask::Mode::Difference);
+}
+
+void BinaryReader::read(model::Repeater::Transform &transform)
+{
+    read(transform.mRotation);
+    read(transform.mScale);
+    read(transform.mPosition);
+    read(transform.mAnchor);
+    read(transform.mStartOpacity);
+    read(transform.mEndOpacity);
+}
+
+VInterpolator *BinaryReader::readInterpolator()
+{
+    auto id = read<uint32_t>();
+    if (!valid() || id == 0) return nullptr;
+    if (id <= mInterpolators.size()) return mInterpolators[id - 1];
+    if (id != mInterpolators.size() + 1) {
+        error();
+        return nullptr;
+    }
+    auto obj = allocator().make<VInterpolator>();
+    read(obj, sizeof(VInterpolator));
+    mInterpolators.push_back(obj);
+    return obj;
+}
+
+void BinaryReader::readAsset(model::Asset *asset)
+{
+    asset->mAssetType = readEnum(model::Asset::Type::Char);
+    asset->mStatic = readFlag();
+    asset->mRefId = readString();
+    asset->mWidth = read<int32_t>();
+    asset->mHeight = read<int32_t>();
+    read(asset->mBitmap);
+}
+
+model::Object *BinaryReader::readObject()
+{
+    auto id = read<uint32_t>();
+    if (!valid() || id == 0) return nullptr;
+
+    if (id <= mObjects.size()) {
+        // a reference to an object that is still being read is a cycle.
+        if (!mComplete[id - 1]) {
+            error();
+            return nullptr;
+        }
+        return mObjects[id - 1];
+    }
+
+    if (id != mObjects.size() + 1 || mDepth >= kMaxObjectDepth) {
+        error();
+        return nullptr;
+    }
+
+    model::Object *obj = nullptr;
+    switch (readEnum(model::Object::Type::RoundedCorner)) {
+    case model::Object::Type::Layer:
+        obj = allocator().make<model::Layer>();
+        break;
+    case model::Object::Type::Group:
+        obj = allocator().make<model::Group>();
+        break;
+    case model::Object::Type::Transform:
+        obj = allocator().make<model::Transform>();
+        break;
+    case model::Object::Type::Fill:
+        obj = allocator().make<model::Fill>();
+        break;
+    case model::Object::Type::Stroke:
+        obj = allocator().make<model::Stroke>();
+        break;
+    case model::Object::Type::GFill:
+        obj = allocator().make<model::GradientFill>();
+        break;
+    case model::Object::Type::GStroke:
+        obj = allocator().make<model::GradientStroke>();
+        break;
+    case model::Object::Type::Rect:
+        obj = allocator().make<model::Rect>();
+        break;
+    case model::Object::Type::Ellipse:
+        obj = allocator().make<model::Ellipse>();
+        break;
+    case model::Object::Type::Path:
+        obj = allocator().make<model::Path>();
+        break;
+    case model::Object::Type::Polystar:
+        obj = allocator().make<model::Polystar>();
+        break;
+    case model::Object::Type::Trim:
+        obj = allocator().make<model::Trim>();
+        break;
+    case model::Object::Type::Repeater:
+        obj = allocator().make<model::Repeater>();
+        break;
+    case model::Object::Type::RoundedCorner:
+        obj = allocator().make<model::RoundedCorner>();
+        break;
+    default:
+        error();
+        return nullptr;
+    }
+
+    mObjects.push_back(obj);
+    mComplete.push_back(false);
+
+    ++mDepth;
+    readObjectBody(obj);
+    --mDepth;
+
+    mComplete[id - 1] = true;
+    return valid() ? obj : nullptr;
+}
+
+void BinaryReader::readObjectBody(model::Object *obj)
+{
+    obj->setStatic(readFlag());
+    obj->setHidden(readFlag());
+    auto name = readString();
+    if (!name.empty()) obj->setName(name.c_str());
+
+    switch (obj->type()) {
+    case model::Object::Type::Layer: {
+        readLayer(static_cast<model::Layer *>(obj));
+        break;
+    }
+    case model::Object::Type::Group: {
+        readGroup(static_cast<model::Group *>(obj));
+        break;
+    }
+    case model::Object::Type::Transform: {
+        readTransform(static_cast<model::Transform *>(obj));
+        break;
+    }
+    case model::Object::Type::Fill: {
+        auto fill = static_cast<model::Fill *>(obj);
+        fill->mFillRule = readEnum(FillRule::Winding);
+        fill->mEnabled = readFlag();
+        read(fill->mColor);
+        read(fill->mOpacity);
+        break;
+    }
+    case model::Object::Type::Stroke: {
+        auto stroke = static_cast<model::Stroke *>(obj);
+        read(stroke->mColor);
+        read(stroke->mOpacity);
+        read(stroke->mWidth);
+        stroke->mCapStyle = readEnum(CapStyle::Round);
+        stroke->mJoinStyle = readEnum(JoinStyle::Round);
+        stroke->mMiterLimit = read<float>();
+        read(stroke->mDash);
+        stroke->mEnabled = readFlag();
+        break;
+    }
+    case model::Object::Type::GFill: {
+        auto fill = static_cast<model::GradientFill *>(obj);
+        readGradient(fill);
+        fill->mFillRule = readEnum(FillRule::Winding);
+        break;
+    }
+    case model::Object::Type::GStroke: {
+        auto stroke = static_cast<model::GradientStroke *>(obj);
+        readGradient(stroke);
+        read(stroke->mWidth);
+        stroke->mCapStyle = readEnum(CapStyle::Round);
+        stroke->mJoinStyle = readEnum(JoinStyle::Round);
+        stroke->mMiterLimit = read<float>();
+        read(stroke->mDash);
+        break;
+    }
+    case model::Object::Type::Rect: {
+        auto rect = static_cast<model::Rect *>(obj);
+        rect->mDirection = read<int32_t>();
+        rect->mRoundedCorner = readObject<model::RoundedCorner>(
+            model::Object::Type::RoundedCorner);
+        read(rect->mPos);
+        read(rect->mSize);
+        read(rect->mRound);
+        break;
+    }
+    case model::Object::Type::Ellipse: {
+        auto ellipse = static_cast<model::Ellipse *>(obj);
+        ellipse->mDirection = read<int32_t>();
+        read(ellipse->mPos);
+        read(ellipse->mSize);
+        break;
+    }
+    case model::Object::Type::Path: {
+        auto path = static_cast<model::Path *>(obj);
+        path->mDirection = read<int32_t>();
+        read(path->mShape);
+        break;
+    }
+    case model::Object::Type::Polystar: {
+        auto star = static_cast<model::Polystar *>(obj);
+        star->mDirection = read<int32_t>();
+        star->mPolyType = read<model::Polystar::PolyType>();
+        read(star->mPos);
+        read(star->mPointCount);
+        read(star->mInnerRadius);
+        read(star->mOuterRadius);
+        read(star->mInnerRoundness);
+        read(star->mOuterRoundness);
+        read(star->mRotation);
+        break;
+    }
+    case model::Object::Type::Trim: {
+        auto trim = static_cast<model::Trim *>(obj);
+        read(trim->mStart);
+        read(trim->mEnd);
+        read(trim->mOffset);
+        trim->mTrimType = readEnum(model::Trim::TrimType::Individually);
+        break;
+    }
+    case model::Object::Type::Repeater: {
+        auto repeater = static_cast<model::Repeater *>(obj);
+        repeater->mContent =
+            readObject<model::Group>(model::Object::Type::Group);
+        // renderer expects every repeater to own a content group.
+        if (!repeater->mContent) error();
+        read(repeater->mTransform);
+        read(repeater->mCopies);
+        read(repeater->mOffset);
+        repeater->mMaxCopies = read<float>();
+        repeater->mProcessed = readFlag();
+        break;
+    }
+    case model::Object::Type::RoundedCorner: {
+        read(static_cast<model::RoundedCorner *>(obj)->mRadius);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void BinaryReader::readGroup(model::Group *obj)
+{
+    auto count = readCount(sizeof(uint32_t));
+    obj->mChildren.reserve(count);
+    for (uint32_t i = 0; i < count && valid(); i++) {
+        auto child = readObject();
+        if (child) obj->mChildren.push_back(child);
+    }
+    obj->mTransform =
+        readObject<model::Transform>(model::Object::Type::Transform);
+}
+
+void BinaryReader::readLayer(model::Layer *obj)
+{
+    readGroup(obj);
+    obj->mMatteType = readEnum(model::MatteType::LumaInv);
+    obj->mLayerType = readEnum(model::Layer::Type::Text);
+    obj->mBlendMode = readEnum(model::BlendMode::OverLay);
+    obj->mHasRoundedCorner = readFlag();
+    obj->mHasPathOperator = readFlag();
+    obj->mHasMask = readFlag();
+    obj->mHasRepeater = readFlag();
+    obj->mHasGradient = readFlag();
+    obj->mAutoOrient = readFlag();
+    obj->mLayerSize = read<VSize>();
+    obj->mParentId = read<int32_t>();
+    obj->mId = read<int32_t>();
+    obj->mTimeStreatch = read<float>();
+    obj->mInFrame = read<int32_t>();
+    obj->mOutFrame = read<int32_t>();
+    obj->mStartFrame = read<int32_t>();
+
+    if (!readFlag()) return;
+
+    auto extra = obj->extra();
+    extra->mCompRef = mComposition.get();
+    extra->mSolidColor = read<model::Color>();
+    extra->mPreCompRefId = readString();
+    read(extra->mTimeRemap);
+    auto asset = read<uint32_t>();
+    if (asset > mAssets.size()) {
+        error();
+        return;
+    }
+    extra->mAsset = asset ? mAssets[asset - 1] : nullptr;
+    auto count = readCount(sizeof(uint8_t));
+    for (uint32_t i = 0; i < count && valid(); i++) {
+        auto mask = allocator().make<model::Mask>();
+        read(*mask);
+        extra->mMasks.push_back(mask);
+    }
+}
+
+void BinaryReader::readTransform(model::Transform *obj)
+{
+    if (readFlag()) {
+        auto matrix = read<VMatrix>();
+        auto opacity = read<float>();
+        obj->set(matrix, opacity);
+        return;
+    }
+    auto data = allocator().make<model::Transform::Data>();
+    read(data->mRotation);
+    read(data->mScale);
+    read(data->mPosition);
+    read(data->mAnchor);
+    read(data->mOpacity);
+    if (readFlag()) {
+        data->createExtraData();
+        read(data->mExtra->m3DRx);
+        read(data->mExtra->m3DRy);
+        read(data->mExtra->m3DRz);
+        read(data->mExtra->mSeparateX);
+        read(data->mExtra->mSeparateY);
+        data->mExtra->mSeparate = readFlag();
+        data->mExtra->m3DData = readFlag();
+    }
+    obj->set(data, false);
+}
+
+void BinaryReader::readGradient(model::Gradient *obj)
+{
+    obj->mGradientType = read<int32_t>();
+    read(obj->mStartPoint);
+    read(obj->mEndPoint);
+    read(obj->mHighlightLength);
+    read(obj->mHighlightAngle);
+    read(obj->mOpacity);
+    read(obj->mGradient);
+    obj->mColorPoints = read<int32_t>();
+    obj->mEnabled = readFlag();
+}
+
+}  // namespace
+
+std::string model::serialize(const model::Composition &composition)
+{
+    return BinaryWriter().save(composition);
+}
+
+std::shared_ptr<model::Composition> model::deserialize(const char *data,
+                                                       size_t      length)
+{
+    if (!data || !length) return {};
+
+    return BinaryReader(data, length).load();
+}
@@ -91,6 +91,10 @@ public:
 
     rlottie::Property property() const { return mPropery; }
 
+    // true when the value doesn't change from frame to frame.
+    bool isConstant() const { return mConstant; }
+    void setConstant(bool constant) { mConstant = constant; }
+
     const ColorFunc& color() const
     {
         assert(mTag == Color);
@@ -165,6 +169,7 @@ private:
         }
         mTag = other.mTag;
         mPropery = other.mPropery;
+        mConstant = other.mConstant;
         other.mTag = MonoState;
     }
 
@@ -188,6 +193,7 @@ private:
         }
         mTag = other.mTag;
         mPropery = other.mPropery;
+        mConstant = other.mConstant;
     }
 
     void Destroy()
@@ -218,6 +224,7 @@ private:
     enum Type { MonoState, Value, Color, Point, Size };
     rlottie::Property mPropery;
     Type              mTag{MonoState};
+    bool              mConstant{false};
     union details {
         ColorFunc colorFunc;
         ValueFunc valueFunc;
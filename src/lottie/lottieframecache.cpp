@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "lottieframecache.h"
+#include <cstring>
+
+using namespace rlottie;
+using namespace rlottie::internal;
+
+/*
+ * Each scanline is encoded as a sequence of chunks, a chunk starts with a
+ * header word holding the pixel count. If kRunBit is set the chunk is a run
+ * and the header is followed by the single repeated pixel, otherwise the
+ * header is followed by that many literal pixels.
+ */
+static constexpr uint32_t kRunBit = 0x80000000;
+static constexpr size_t   kMinRun = 3;
+
+static void encodeLine(const uint32_t *src, size_t width,
+                       std::vector<uint32_t> &out)
+{
+    size_t x = 0;
+    while (x < width) {
+        auto   pixel = src[x];
+        size_t run = 1;
+        while (x + run < width && src[x + run] == pixel) run++;
+
+        if (run >= kMinRun) {
+            out.push_back(kRunBit | uint32_t(run));
+            out.push_back(pixel);
+            x += run;
+            continue;
+        }
+
+        // collect literals till the next run worth encoding.
+        size_t start = x;
+        x += run;
+        while (x < width) {
+            run = 1;
+            while (x + run < width && src[x + run] == src[x]) run++;
+            if (run >= kMinRun) break;
+            x += run;
+        }
+        out.push_back(uint32_t(x - start));
+        out.insert(out.end(), src + start, src + x);
+    }
+}
+
+static const uint32_t *decodeLine(const uint32_t *src, uint32_t *dst,
+                                  size_t width)
+{
+    size_t x = 0;
+    while (x < width) {
+        auto header = *src++;
+        auto count = header & ~kRunBit;
+        if (header & kRunBit) {
+            auto pixel = *src++;
+            // the surface is already cleared.
+            if (pixel) std::fill_n(dst + x, count, pixel);
+        } else {
+            memcpy(dst + x, src, count * sizeof(uint32_t));
+            src += count;
+        }
+        x += count;
+    }
+    return src;
+}
+
+static uint32_t *drawRegionLine(const rlottie::Surface &surface, size_t y)
+{
+    auto line = reinterpret_cast<uint8_t *>(surface.buffer()) +
+                (surface.drawRegionPosY() + y) * surface.bytesPerLine();
+    return reinterpret_cast<uint32_t *>(line) + surface.drawRegionPosX();
+}
+
+bool FrameCache::match(const rlottie::Surface &surface,
+                       bool                    keepAspectRatio) const
+{
+    return mSize == VSize(int(surface.drawRegionWidth()),
+                          int(surface.drawRegionHeight())) &&
+           mKeepAspectRatio == keepAspectRatio;
+}
+
+bool FrameCache::load(size_t frameNo, const rlottie::Surface &surface,
+                      bool keepAspectRatio)
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+
+    auto search = mFrames.end();
+    if (match(surface, keepAspectRatio)) search = mFrames.find(frameNo);
+
+    if (search == mFrames.end()) {
+        mStats.misses++;
+        return false;
+    }
+    mStats.hits++;
+
+    // same as the renderer, the whole surface is cleared before drawing.
+    memset(surface.buffer(), 0, surface.height() * surface.bytesPerLine());
+
+    const uint32_t *src = search->second.data();
+    for (size_t y = 0; y < surface.drawRegionHeight(); y++) {
+        src = decodeLine(src, drawRegionLine(surface, y),
+                         surface.drawRegionWidth());
+    }
+    return true;
+}
+
+void FrameCache::save(size_t frameNo, const rlottie::Surface &surface,
+                      bool keepAspectRatio)
+{
+    std::vector<uint32_t> data;
+    for (size_t y = 0; y < surface.drawRegionHeight(); y++) {
+        encodeLine(drawRegionLine(surface, y), surface.drawRegionWidth(),
+                   data);
+    }
+    data.shrink_to_fit();
+    auto bytes = data.size() * sizeof(uint32_t);
+
+    std::lock_guard<std::mutex> guard(mMutex);
+
+    if (!match(surface, keepAspectRatio)) {
+        mFrames.clear();
+        mStats.frames = 0;
+        mStats.bytes = 0;
+        mSize = VSize(int(surface.drawRegionWidth()),
+                      int(surface.drawRegionHeight()));
+        mKeepAspectRatio = keepAspectRatio;
+    }
+
+    if (mStats.bytes + bytes > mBudget) return;
+    if (!mFrames.emplace(frameNo, std::move(data)).second) return;
+
+    mStats.frames++;
+    mStats.bytes += bytes;
+}
+
+void FrameCache::clear()
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    mFrames.clear();
+    mStats.frames = 0;
+    mStats.bytes = 0;
+}
+
+void FrameCache::setBudget(size_t budget)
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    mBudget = budget;
+    if (mStats.bytes > mBudget) {
+        mFrames.clear();
+        mStats.frames = 0;
+        mStats.bytes = 0;
+    }
+}
+
+FrameCacheStats FrameCache::stats() const
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    return mStats;
+}
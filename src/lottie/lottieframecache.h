@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LOTTIEFRAMECACHE_H
+#define LOTTIEFRAMECACHE_H
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "rlottie.h"
+#include "vpoint.h"
+
+namespace rlottie {
+
+namespace internal {
+
+/*
+ * Keeps the rendered frames of an animation so that looping playback only
+ * has to decode them into the surface. Frames are stored run length encoded
+ * as most of the pixels of a typical frame are transparent or flat colored.
+ * All cached frames share one view size and aspect ratio policy, rendering
+ * with a different one drops the cache.
+ * Once the budget is reached new frames are not cached anymore, evicting
+ * older ones would only make a looping animation miss on every frame.
+ */
+class FrameCache {
+public:
+    explicit FrameCache(size_t budget) : mBudget(budget) {}
+    bool load(size_t frameNo, const rlottie::Surface &surface,
+              bool keepAspectRatio);
+    void save(size_t frameNo, const rlottie::Surface &surface,
+              bool keepAspectRatio);
+    void clear();
+    void setBudget(size_t budget);
+    FrameCacheStats stats() const;
+
+private:
+    bool match(const rlottie::Surface &surface, bool keepAspectRatio) const;
+    std::unordered_map<size_t, std::vector<uint32_t>> mFrames;
+    mutable std::mutex                                mMutex;
+    FrameCacheStats                                   mStats;
+    VSize                                             mSize;
+    bool                                              mKeepAspectRatio{true};
+    size_t                                            mBudget;
+};
+
+}  // namespace internal
+
+}  // namespace rlottie
+
+#endif  // LOTTIEFRAMECACHE_H
@@ -23,6 +23,7 @@
 #include "lottieitem.h"
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <iterator>
 #include "lottiekeypath.h"
 #include "vbitmap.h"
@@ -83,6 +84,71 @@ static bool trimProp(rlottie::Property prop)
     }
 }
 
+static inline uint64_t mixHash(uint64_t h, uint64_t v)
+{
+    h = (h ^ v) * 0x9e3779b97f4a7c15ull;
+    return h ^ (h >> 32);
+}
+
+static inline uint64_t mixHash(uint64_t h, float v)
+{
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return mixHash(h, uint64_t(bits));
+}
+
+static uint64_t mixHash(uint64_t h, const VMatrix &m)
+{
+    for (auto v : {m.m_11(), m.m_12(), m.m_13(), m.m_21(), m.m_22(), m.m_23(),
+                   m.m_tx(), m.m_ty(), m.m_33()})
+        h = mixHash(h, v);
+    return h;
+}
+
+static uint64_t mixHash(uint64_t h, const VBrush &brush)
+{
+    h = mixHash(h, uint64_t(brush.type()));
+    switch (brush.type()) {
+    case VBrush::Type::Solid: {
+        const auto &c = brush.mColor;
+        return mixHash(h, uint64_t(c.red()) | (uint64_t(c.green()) << 8) |
+                              (uint64_t(c.blue()) << 16) |
+                              (uint64_t(c.alpha()) << 24));
+    }
+    case VBrush::Type::LinearGradient:
+    case VBrush::Type::RadialGradient: {
+        const auto *g = brush.mGradient;
+        h = mixHash(h, uint64_t(g->mSpread));
+        h = mixHash(h, g->mAlpha);
+        for (const auto &stop : g->mStops) {
+            const auto &c = stop.second;
+            h = mixHash(h, stop.first);
+            h = mixHash(h, uint64_t(c.red()) | (uint64_t(c.green()) << 8) |
+                               (uint64_t(c.blue()) << 16) |
+                               (uint64_t(c.alpha()) << 24));
+        }
+        if (brush.type() == VBrush::Type::LinearGradient) {
+            for (auto v : {g->linear.x1, g->linear.y1, g->linear.x2,
+                           g->linear.y2})
+                h = mixHash(h, v);
+        } else {
+            for (auto v : {g->radial.cx, g->radial.cy, g->radial.fx,
+                           g->radial.fy, g->radial.cradius, g->radial.fradius})
+                h = mixHash(h, v);
+        }
+        return mixHash(h, g->mMatrix);
+    }
+    case VBrush::Type::Texture: {
+        const auto *t = brush.mTexture;
+        h = mixHash(h, uint64_t(reinterpret_cast<uintptr_t>(t->mBitmap.data())));
+        h = mixHash(h, uint64_t(t->mAlpha));
+        return mixHash(h, t->mMatrix);
+    }
+    default:
+        return h;
+    }
+}
+
 static constexpr int    kMaxLayerDepth = 32;      // precomp nesting-depth limit
 static constexpr size_t kMaxLayerNodes = 100000;  // global render-node budget
 
@@ -96,6 +162,9 @@ static constexpr size_t kMaxLayerNodes = 100000;  // global render-node budget
 // shared budget.
 static constexpr size_t kMaxShapeContentBudget = 15000;
 
+// frames a released offscreen surface is kept without being used.
+static constexpr uint32_t kSurfaceIdleFrames = 30;
+
 static renderer::Layer *createLayerItem(model::Layer *layerData,
                                         VArenaAlloc *allocator, int depth,
                                         size_t &nodeBudget,
@@ -148,22 +217,46 @@ renderer::Composition::Composition(std::shared_ptr<model::Composition> model)
     mViewSize = mModel->size();
 }
 
-void renderer::Composition::setValue(const std::string &keypath,
-                                     LOTVariant &       value)
+renderer::KeyPathTargets renderer::Composition::resolveKeyPath(
+    const std::string &keypath)
 {
-    mHasDynamicValue = true;
+    KeyPathTargets targets;
+    if (keypath.empty()) return targets;
+
     LOTKeyPath key(keypath);
-    mRootLayer->resolveKeyPath(key, 0, value);
+    mRootLayer->resolveKeyPath(key, 0, targets);
+    return targets;
+}
+
+void renderer::Composition::setValue(const KeyPathTargets &targets,
+                                     LOTVariant &          value)
+{
+    bool applied = false;
+    for (const auto &e : targets) {
+        if (e.mContent->setValue(value)) {
+            e.mLayer->valueChanged(value);
+            applied = true;
+        }
+    }
+    if (!applied) return;
+
+    mValueChanged = true;
+    // a callback may return a different value on every call.
+    if (!value.isConstant()) mHasDynamicValue = true;
 }
 
 bool renderer::Composition::update(int frameNo, const VSize &size,
                                    bool keepAspectRatio)
 {
     // check if cached frame is same as requested frame.
-    if (!mHasDynamicValue && (mViewSize == size) && (mCurFrameNo == frameNo) &&
-        (mKeepAspectRatio == keepAspectRatio))
+    if (!mHasDynamicValue && !mValueChanged && (mViewSize == size) &&
+        (mCurFrameNo == frameNo) && (mKeepAspectRatio == keepAspectRatio))
         return false;
 
+    VPROFILE_SCOPE(Update);
+    VTRACE_SCOPE("update");
+
+    mValueChanged = false;
     mViewSize = size;
     mCurFrameNo = frameNo;
     mKeepAspectRatio = keepAspectRatio;
@@ -190,7 +283,36 @@ bool renderer::Composition::update(int frameNo, const VSize &size,
     return true;
 }
 
-bool renderer::Composition::render(const rlottie::Surface &surface)
+static bool sameSurface(const rlottie::Surface &a, const rlottie::Surface &b)
+{
+    return a.buffer() == b.buffer() && a.width() == b.width() &&
+           a.height() == b.height() && a.bytesPerLine() == b.bytesPerLine() &&
+           a.drawRegionPosX() == b.drawRegionPosX() &&
+           a.drawRegionPosY() == b.drawRegionPosY() &&
+           a.drawRegionWidth() == b.drawRegionWidth() &&
+           a.drawRegionHeight() == b.drawRegionHeight();
+}
+
+/*
+ * Starts an offscreen buffer that only covers area of painter. Drawing into
+ * it uses the coordinates of painter, composite it back with
+ * painter->drawBitmap(VPoint(area.x(), area.y()), bitmap).
+ */
+static VBitmap beginOffscreen(
+    VPainter &offscreen, const VPainter *painter, const VRect &area,
+    renderer::SurfaceCache &cache,
+    VBitmap::Format         format = VBitmap::Format::ARGB32_Premultiplied)
+{
+    VBitmap bitmap =
+        cache.make_surface(size_t(area.width()), size_t(area.height()), format);
+    offscreen.begin(&bitmap);
+    offscreen.setOrigin(VPoint(area.x(), area.y()));
+    offscreen.setThreadCount(painter->threadCount());
+    return bitmap;
+}
+
+bool renderer::Composition::render(const rlottie::Surface &surface,
+                                   VRect *                 damage)
 {
     mSurface.reset(reinterpret_cast<uint8_t *>(surface.buffer()),
                    uint32_t(surface.width()), uint32_t(surface.height()),
@@ -201,18 +323,231 @@ bool renderer::Composition::render(const rlottie::Surface &surface)
      */
     VRect clip(0, 0, int(surface.drawRegionWidth()),
                int(surface.drawRegionHeight()));
-    mRootLayer->preprocess(clip);
+    {
+        VTRACE_SCOPE("preprocess");
+        mRootLayer->preprocess(clip);
+    }
+
+    mSurfaceCache.nextFrame();
+
+    VRect region(int(surface.drawRegionPosX()), int(surface.drawRegionPosY()),
+                 int(surface.drawRegionWidth()),
+                 int(surface.drawRegionHeight()));
+
+    if (!damage) {
+        invalidateDamage();
+
+        VPainter painter(&mSurface);
+        // set sub surface area for drawing.
+        painter.setDrawRegion(region);
+        painter.setThreadCount(mThreadCount);
+        mRootLayer->render(&painter, {}, {}, mSurfaceCache);
+        painter.end();
+        return true;
+    }
 
-    VPainter painter(&mSurface);
-    // set sub surface area for drawing.
-    painter.setDrawRegion(
-        VRect(int(surface.drawRegionPosX()), int(surface.drawRegionPosY()),
-              int(surface.drawRegionWidth()), int(surface.drawRegionHeight())));
+    mRootLayer->collectDamage(mDamageTracker, clip, {}, 0);
+    VRect dirty = mDamageTracker.damage() & clip;
+
+    // only the damaged area needs repaint if the surface still holds
+    // the last frame we rendered into it.
+    if (!mDamageValid || !sameSurface(mDamageSurface, surface)) dirty = clip;
+    mDamageSurface = surface;
+    mDamageValid = true;
+
+    *damage = dirty.translated(region.x(), region.y());
+    if (dirty.empty()) return true;
+
+    VPainter painter;
+    painter.begin(&mSurface, false);
+    painter.setDrawRegion(region);
+    painter.setThreadCount(mThreadCount);
+    painter.clear(dirty);
+    // clip all the drawing to the damaged area.
+    painter.setClipRect(dirty);
     mRootLayer->render(&painter, {}, {}, mSurfaceCache);
     painter.end();
     return true;
 }
 
+void renderer::Composition::invalidateDamage()
+{
+    if (!mDamageValid) return;
+
+    mDamageTracker.reset();
+    mDamageValid = false;
+}
+
+void renderer::Composition::memoryUsage(VMemoryUsage &usage) const
+{
+    usage.surface += mSurfaceCache.memoryUsage();
+    if (mRootLayer) usage.rasterCache += mRootLayer->rasterCacheUsage();
+}
+
+void renderer::Composition::trim(VTrimLevel level)
+{
+    mSurfaceCache.clear();
+    if (level != VTrimLevel::Scratch && mRootLayer)
+        mRootLayer->releaseRasterCache();
+}
+
+// size classes are a quarter of a power of two apart, so at most a fifth
+// of a surface is unused.
+size_t renderer::SurfaceCache::sizeClass(size_t bytes)
+{
+    size_t base = 4096;
+    if (bytes <= base) return base;
+    while (base * 2 < bytes) base *= 2;
+    size_t step = base / 4;
+    return (bytes + step - 1) / step * step;
+}
+
+VBitmap renderer::SurfaceCache::make_surface(size_t width, size_t height,
+                                             VBitmap::Format format)
+{
+    VPROFILE_COUNT(mSurfaces, 1);
+    size_t bytes = sizeClass(VBitmap::bytesPerLine(width, format) * height);
+
+    // the smallest released surface of the class or of the next ones.
+    size_t index = mCache.size();
+    for (size_t i = 0; i < mCache.size(); i++) {
+        size_t capacity = mCache[i].mSurface.capacity();
+        if (capacity < bytes || capacity > 2 * bytes) continue;
+        if (index == mCache.size() ||
+            capacity < mCache[index].mSurface.capacity())
+            index = i;
+    }
+
+    if (index == mCache.size()) {
+        VPROFILE_COUNT(mSurfaceAllocs, 1);
+        return {width, height, format, bytes};
+    }
+
+    VPROFILE_COUNT(mSurfaceHits, 1);
+    auto surface = mCache[index].mSurface;
+    remove(index);
+    surface.reset(width, height, format);
+    return surface;
+}
+
+void renderer::SurfaceCache::release_surface(VBitmap &surface)
+{
+    size_t bytes = surface.capacity();
+    if (!bytes) return;
+
+    if (mBudget && bytes > mBudget) {
+        VPROFILE_COUNT(mSurfaceReleases, 1);
+        return;
+    }
+    if (mBudget) evict(mBudget - bytes);
+
+    mCache.push_back({surface, mFrame});
+    mBytes += bytes;
+}
+
+void renderer::SurfaceCache::nextFrame()
+{
+    mFrame++;
+    for (size_t i = mCache.size(); i > 0; i--) {
+        if (mFrame - mCache[i - 1].mFrame > kSurfaceIdleFrames) {
+            VPROFILE_COUNT(mSurfaceReleases, 1);
+            remove(i - 1);
+        }
+    }
+}
+
+void renderer::SurfaceCache::setBudget(size_t bytes)
+{
+    mBudget = bytes;
+    if (mBudget) evict(mBudget);
+}
+
+void renderer::SurfaceCache::clear()
+{
+    mCache.clear();
+    mBytes = 0;
+}
+
+// frees the least recently used surfaces until at most bytes are kept.
+void renderer::SurfaceCache::evict(size_t bytes)
+{
+    while (mBytes > bytes) {
+        auto oldest = std::min_element(
+            mCache.begin(), mCache.end(),
+            [](const Entry &a, const Entry &b) { return a.mFrame < b.mFrame; });
+        VPROFILE_COUNT(mSurfaceReleases, 1);
+        remove(size_t(oldest - mCache.begin()));
+    }
+}
+
+void renderer::SurfaceCache::remove(size_t index)
+{
+    mBytes -= mCache[index].mSurface.capacity();
+    mCache[index] = std::move(mCache.back());
+    mCache.pop_back();
+}
+
+void renderer::DamageTracker::add(const void *key, const VRect &bounds,
+                                  uint64_t signature, bool whole)
+{
+    auto &e = mEntries[key];
+    if (e.mFrame == mFrame) {
+        // drawn more than once in this frame.
+        e.mBounds = e.mBounds | bounds;
+        e.mSignature = mixHash(e.mSignature, signature);
+        e.mWhole |= whole;
+        return;
+    }
+    e.mWhole = whole;
+    e.mPrevDrawn = (e.mFrame + 1 == mFrame);
+    e.mPrevBounds = e.mBounds;
+    e.mPrevSignature = e.mSignature;
+    e.mBounds = bounds;
+    e.mSignature = signature;
+    e.mFrame = mFrame;
+}
+
+VRect renderer::DamageTracker::damage()
+{
+    VRect result;
+    for (auto it = mEntries.begin(); it != mEntries.end();) {
+        auto &e = it->second;
+        if (e.mFrame != mFrame) {
+            // not drawn anymore, its last area needs repaint.
+            result = result | e.mBounds;
+            it = mEntries.erase(it);
+            continue;
+        }
+        if (!e.mPrevDrawn) {
+            result = result | e.mBounds;
+        } else if (e.mSignature != e.mPrevSignature ||
+                   e.mBounds != e.mPrevBounds) {
+            result = result | e.mBounds | e.mPrevBounds;
+        }
+        ++it;
+    }
+
+    for (bool grown = !result.empty(); grown;) {
+        grown = false;
+        for (auto &it : mEntries) {
+            const auto &e = it.second;
+            if (e.mWhole && result.intersects(e.mBounds) &&
+                !result.contains(e.mBounds)) {
+                result = result | e.mBounds;
+                grown = true;
+            }
+        }
+    }
+    ++mFrame;
+    return result;
+}
+
+void renderer::DamageTracker::reset()
+{
+    mEntries.clear();
+    mFrame = 1;
+}
+
 void renderer::Mask::update(int frameNo, const VMatrix &parentMatrix,
                             float /*parentAlpha*/, const DirtyFlag &flag)
 {
@@ -259,6 +594,8 @@ void renderer::Mask::preprocess(const VRect &clip)
 void renderer::Layer::render(VPainter *painter, const VRle &inheritMask,
                              const VRle &matteRle, SurfaceCache &)
 {
+    if (mCulled) return;
+
     auto renderlist = renderList();
 
     if (renderlist.empty()) return;
@@ -300,6 +637,205 @@ void renderer::Layer::render(VPainter *painter, const VRle &inheritMask,
     }
 }
 
+/*
+ * Coverage the drawables leave in the alpha channel when drawn one over
+ * the other, scaled by alpha. Only solid colors give the same coverage
+ * over the whole rle.
+ */
+bool renderer::Layer::solidCoverage(const VRect &clip, const VRle &inheritMask,
+                                    uint8_t alpha, VRle &rle)
+{
+    auto renderlist = renderList();
+    for (auto &i : renderlist) {
+        if (i->mBrush.type() != VBrush::Type::Solid) return false;
+    }
+
+    rle.reset();
+    if (mCulled || renderlist.empty()) return true;
+
+    for (auto &i : renderlist) {
+        VRle coverage = i->rle();
+        uint8_t a = i->mBrush.mColor.alpha();
+        if (a != 255) coverage *= a;
+        rle = rle.empty() ? coverage : rle + coverage;
+    }
+
+    if (mLayerMask) {
+        VRle mask = mLayerMask->maskRle(clip);
+        if (!inheritMask.empty()) mask = mask & inheritMask;
+        rle = rle & mask;
+    } else if (!inheritMask.empty()) {
+        rle = rle & inheritMask;
+    }
+
+    if (alpha != 255) rle *= alpha;
+    return true;
+}
+
+VRect renderer::Layer::contentBounds()
+{
+    if (mCulled) return {};
+
+    VRect rect;
+    for (auto &i : renderList()) rect = rect | i->rle().boundingRect();
+    return rect;
+}
+
+bool renderer::Layer::rasterCacheWorthy(const DrawableList &renderlist,
+                                        const VRle &        mask) const
+{
+    // a single solid fill is cheaper to blend than the cached bitmap.
+    if (renderlist.size() > 1 || mLayerMask || !mask.empty() ||
+        !vCompare(combinedAlpha(), 1.0f))
+        return true;
+
+    for (auto &i : renderlist) {
+        if (i->mBrush.type() == VBrush::Type::LinearGradient ||
+            i->mBrush.type() == VBrush::Type::RadialGradient)
+            return true;
+    }
+    return false;
+}
+
+// the rles are already clipped to the surface, so the cache holds the whole
+// visible content whatever the clip of the painter drawing it.
+void renderer::Layer::buildRasterCache(const VRle &mask, size_t threadCount,
+                                       SurfaceCache &cache)
+{
+    const VRect &rect = mRasterCache.mRect;
+
+    mRasterCache.mValid = true;
+    if (rect.empty()) {
+        mRasterCache.mBitmap = VBitmap();
+        return;
+    }
+
+    if (mRasterCache.mBitmap.width() != size_t(rect.width()) ||
+        mRasterCache.mBitmap.height() != size_t(rect.height())) {
+        mRasterCache.mBitmap = VBitmap(rect.width(), rect.height(),
+                                       VBitmap::Format::ARGB32_Premultiplied);
+    }
+
+    VPainter painter;
+    painter.begin(&mRasterCache.mBitmap);
+    painter.setOrigin(VPoint(rect.x(), rect.y()));
+    painter.setThreadCount(threadCount);
+    Layer::render(&painter, mask, {}, cache);
+    painter.end();
+}
+
+size_t renderer::Layer::rasterCacheUsage() const
+{
+    return mRasterCache.mBitmap.stride() * mRasterCache.mBitmap.height();
+}
+
+// keeps the matrix, clip and mask so the cache is rebuilt on the next
+// render instead of waiting for a second identical frame.
+void renderer::Layer::releaseRasterCache()
+{
+    mRasterCache.mBitmap = VBitmap();
+    mRasterCache.mValid = false;
+}
+
+/*
+ * Static layers are drawn from a cached bitmap, the cache is only built
+ * when the layer is rendered twice in a row with the same matrix, clip
+ * and mask so that layers moved by an animated parent don't pay for it.
+ */
+bool renderer::Layer::renderCached(VPainter *painter, const VRle &inheritMask,
+                                   const VRle &matteRle, SurfaceCache &cache)
+{
+    if (!isStatic() || mHasDynamicValue || !matteRle.empty()) return false;
+
+    auto renderlist = renderList();
+    if (renderlist.empty()) return false;
+
+    VRect    rect = Layer::contentBounds();
+    uint64_t maskHash = inheritMask.empty() ? 0 : inheritMask.hash();
+
+    if (!rasterCacheMatches(rect, maskHash)) {
+        mRasterCache = RasterCache();
+        mRasterCache.mRect = rect;
+        mRasterCache.mMatrix = combinedMatrix();
+        mRasterCache.mMaskHash = maskHash;
+        return false;
+    }
+
+    if (!mRasterCache.mValid) {
+        if (!rasterCacheWorthy(renderlist, inheritMask)) return false;
+        buildRasterCache(inheritMask, painter->threadCount(), cache);
+    }
+
+    if (!mRasterCache.mRect.empty()) {
+        painter->drawBitmap(VPoint(mRasterCache.mRect.x(), mRasterCache.mRect.y()),
+                            mRasterCache.mBitmap,
+                            uint8_t(combinedAlpha() * 255.0f));
+    }
+    return true;
+}
+
+bool renderer::Layer::rasterCacheMatches(const VRect &rect,
+                                         uint64_t     maskHash) const
+{
+    return mRasterCache.mRect == rect &&
+           mRasterCache.mMatrix == combinedMatrix() &&
+           mRasterCache.mMaskHash == maskHash;
+}
+
+/*
+ * Whether the next render draws the layer from its raster cache. The
+ * cached bitmap is blended as a whole so it differs from drawing the
+ * drawables one by one in the last bit, switching between the two has
+ * to damage the layer.
+ */
+bool renderer::Layer::rasterCached(const DrawableList &renderlist,
+                                   const VRle &        inheritMask)
+{
+    if (!isStatic() || mHasDynamicValue) return false;
+
+    uint64_t maskHash = inheritMask.empty() ? 0 : inheritMask.hash();
+    if (!rasterCacheMatches(Layer::contentBounds(), maskHash)) return false;
+
+    return mRasterCache.mValid || rasterCacheWorthy(renderlist, inheritMask);
+}
+
+void renderer::Layer::collectDamage(DamageTracker &tracker, const VRect &clip,
+                                    const VRle &inheritMask, uint64_t signature)
+{
+    if (mCulled) return;
+
+    auto renderlist = renderList();
+
+    if (renderlist.empty()) return;
+
+    signature = mixHash(signature, uint64_t(rasterCached(renderlist, inheritMask)));
+
+    VRle mask = inheritMask;
+    if (mLayerMask) {
+        mask = mLayerMask->maskRle(clip);
+        if (!inheritMask.empty()) mask = mask & inheritMask;
+        if (mask.empty()) return;
+        signature = mixHash(signature, mask.hash());
+    }
+    // layer alpha is applied while blending the offscreen buffer.
+    signature = mixHash(signature, combinedAlpha());
+
+    VRect area = mask.empty() ? clip : (mask.boundingRect() & clip);
+    for (auto &i : renderlist) {
+        VRle rle = i->rle();
+        if (rle.empty()) continue;
+
+        VRect bounds = rle.boundingRect() & area;
+        if (bounds.empty()) continue;
+
+        // radial gradients step from the start of the span, a span cut by
+        // the damage would not get the colors of the full span.
+        tracker.add(i, bounds,
+                    mixHash(mixHash(signature, rle.hash()), i->mBrush),
+                    i->mBrush.type() == VBrush::Type::RadialGradient);
+    }
+}
+
 void renderer::LayerMask::preprocess(const VRect &clip)
 {
     for (auto &i : mMasks) {
@@ -386,48 +922,47 @@ renderer::Layer::Layer(model::Layer *layerData) : mLayerData(layerData)
         mLayerMask = std::make_unique<renderer::LayerMask>(mLayerData);
 }
 
-bool renderer::Layer::resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
-                                     LOTVariant &value)
+void renderer::Layer::resolveKeyPath(LOTKeyPath & /*keyPath*/,
+                                     uint32_t /*depth*/,
+                                     KeyPathTargets & /*targets*/)
 {
-    if (!keyPath.matches(name(), depth)) {
-        return false;
-    }
+    //@TODO handle layer transform properties.
+}
 
-    if (!keyPath.skip(name())) {
-        if (keyPath.fullyResolvesTo(name(), depth) &&
-            transformProp(value.property())) {
-            //@TODO handle propery update.
-        }
-    }
-    return true;
+/*
+ * a new value forces one content update of the layer, a value that is
+ * computed by a callback forces it on every frame.
+ */
+void renderer::Layer::valueChanged(const LOTVariant &value)
+{
+    mValueChanged = true;
+    if (!value.isConstant()) mHasDynamicValue = true;
+    mRasterCache = RasterCache();
 }
 
-bool renderer::ShapeLayer::resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
-                                          LOTVariant &value)
+void renderer::ShapeLayer::resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
+                                          KeyPathTargets &targets)
 {
-    if (renderer::Layer::resolveKeyPath(keyPath, depth, value)) {
-        if (keyPath.propagate(name(), depth)) {
-            uint32_t newDepth = keyPath.nextDepth(name(), depth);
-            mRoot->resolveKeyPath(keyPath, newDepth, value);
-        }
-        return true;
-    }
-    return false;
+    if (!keyPath.matches(name(), depth) || !keyPath.propagate(name(), depth))
+        return;
+
+    size_t   first = targets.size();
+    uint32_t newDepth = keyPath.nextDepth(name(), depth);
+    mRoot->resolveKeyPath(keyPath, newDepth, targets);
+
+    for (size_t i = first; i < targets.size(); i++) targets[i].mLayer = this;
 }
 
-bool renderer::CompLayer::resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
-                                         LOTVariant &value)
+void renderer::CompLayer::resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
+                                         KeyPathTargets &targets)
 {
-    if (renderer::Layer::resolveKeyPath(keyPath, depth, value)) {
-        if (keyPath.propagate(name(), depth)) {
-            uint32_t newDepth = keyPath.nextDepth(name(), depth);
-            for (const auto &layer : mLayers) {
-                layer->resolveKeyPath(keyPath, newDepth, value);
-            }
-        }
-        return true;
+    if (!keyPath.matches(name(), depth) || !keyPath.propagate(name(), depth))
+        return;
+
+    uint32_t newDepth = keyPath.nextDepth(name(), depth);
+    for (const auto &layer : mLayers) {
+        layer->resolveKeyPath(keyPath, newDepth, targets);
     }
-    return false;
 }
 
 void renderer::Layer::update(int frameNumber, const VMatrix &parentMatrix,
@@ -466,7 +1001,7 @@ void renderer::Layer::update(int frameNumber, const VMatrix &parentMatrix,
 
     // 5. if no parent property change and layer is static then nothing to do.
     if (!mLayerData->precompLayer() && flag().testFlag(DirtyFlagBit::None) &&
-        isStatic())
+        isStatic() && !mHasDynamicValue && !mValueChanged)
         return;
 
     // 6. update the content of the layer
@@ -474,6 +1009,7 @@ void renderer::Layer::update(int frameNumber, const VMatrix &parentMatrix,
 
     // 7. reset the dirty flag
     mDirtyFlag = DirtyFlagBit::None;
+    mValueChanged = false;
 }
 
 VMatrix renderer::Layer::matrix(int frameNo) const
@@ -499,13 +1035,21 @@ bool renderer::Layer::visible() const
 
 void renderer::Layer::preprocess(const VRect &clip)
 {
+    mCulled = false;
+
     // layer dosen't contribute to the frame
     if (skipRendering()) return;
 
+    preprocessStage(clip);
+
+    // the masks of a layer outside the clip are never used.
+    if (mCulled) {
+        VPROFILE_COUNT(mCulledLayers, 1);
+        return;
+    }
+
     // preprocess layer masks
     if (mLayerMask) mLayerMask->preprocess(clip);
-
-    preprocessStage(clip);
 }
 
 renderer::CompLayer::CompLayer(model::Layer *layerModel, VArenaAlloc *allocator,
@@ -549,19 +1093,19 @@ renderer::CompLayer::CompLayer(model::Layer *layerModel, VArenaAlloc *allocator,
 void renderer::CompLayer::render(VPainter *painter, const VRle &inheritMask,
                                  const VRle &matteRle, SurfaceCache &cache)
 {
-    if (vIsZero(combinedAlpha())) return;
+    if (vIsZero(combinedAlpha()) || mCulled) return;
 
     if (vCompare(combinedAlpha(), 1.0)) {
         renderHelper(painter, inheritMask, matteRle, cache);
     } else {
         if (complexContent()) {
-            VSize    size = painter->clipBoundingRect().size();
+            VRect area = contentBounds() & painter->clipBoundingRect();
+            if (area.empty()) return;
             VPainter srcPainter;
-            VBitmap srcBitmap = cache.make_surface(size.width(), size.height());
-            srcPainter.begin(&srcBitmap);
+            VBitmap  srcBitmap = beginOffscreen(srcPainter, painter, area, cache);
             renderHelper(&srcPainter, inheritMask, matteRle, cache);
             srcPainter.end();
-            painter->drawBitmap(VPoint(), srcBitmap,
+            painter->drawBitmap(VPoint(area.x(), area.y()), srcBitmap,
                                 uint8_t(combinedAlpha() * 255.0f));
             cache.release_surface(srcBitmap);
         } else {
@@ -587,20 +1131,90 @@ void renderer::CompLayer::renderHelper(VPainter *    painter,
     } depthGuard{cache};
 
     VRle mask;
+    if (!layerMask(painter->clipBoundingRect(), inheritMask, mask)) return;
+
+    renderer::Layer *matte = nullptr;
+    for (const auto &layer : mLayers) {
+        if (layer->hasMatte()) {
+            matte = layer;
+        } else {
+            if (layer->visible()) {
+                if (matte) {
+                    if (matte->visible() && !matte->culled())
+                        renderMatteLayer(painter, mask, matteRle, matte, layer,
+                                         cache);
+                } else {
+                    layer->render(painter, mask, matteRle, cache);
+                }
+            }
+            matte = nullptr;
+        }
+    }
+}
+
+bool renderer::CompLayer::layerMask(const VRect &clip, const VRle &inheritMask,
+                                    VRle &mask)
+{
     if (mLayerMask) {
-        mask = mLayerMask->maskRle(painter->clipBoundingRect());
+        mask = mLayerMask->maskRle(clip);
         if (!inheritMask.empty()) mask = mask & inheritMask;
-        // if resulting mask is empty then return.
-        if (mask.empty()) return;
+        // if resulting mask is empty then nothing to draw.
+        if (mask.empty()) return false;
     } else {
         mask = inheritMask;
     }
 
     if (mClipper) {
         mask = mClipper->rle(mask);
-        if (mask.empty()) return;
+        if (mask.empty()) return false;
+    }
+    return true;
+}
+
+void renderer::CompLayer::collectDamage(DamageTracker &tracker,
+                                        const VRect &clip,
+                                        const VRle &inheritMask,
+                                        uint64_t signature)
+{
+    if (vIsZero(combinedAlpha()) || mCulled) return;
+
+    VRle mask;
+    if (!layerMask(clip, inheritMask, mask)) return;
+
+    if (mLayerMask || mClipper) signature = mixHash(signature, mask.hash());
+    // complex content is blended with the layer alpha as a whole.
+    if (complexContent()) signature = mixHash(signature, combinedAlpha());
+
+    renderer::Layer *matte = nullptr;
+    for (const auto &layer : mLayers) {
+        if (layer->hasMatte()) {
+            matte = layer;
+        } else {
+            if (layer->visible()) {
+                if (matte) {
+                    if (matte->visible() && !matte->culled()) {
+                        auto matteSignature = mixHash(
+                            signature, uint64_t(matte->matteType()) + 1);
+                        layer->collectDamage(tracker, clip, mask,
+                                             matteSignature);
+                        matte->collectDamage(tracker, clip, mask,
+                                             matteSignature);
+                    }
+                } else {
+                    layer->collectDamage(tracker, clip, mask, signature);
+                }
+            }
+            matte = nullptr;
+        }
     }
+}
+
+// masks and the clipper only take away, they are left out.
+VRect renderer::CompLayer::contentBounds()
+{
+    if (skipRendering() || mCulled) return {};
 
+    VRect            rect;
     renderer::Layer *matte = nullptr;
     for (const auto &layer : mLayers) {
         if (layer->hasMatte()) {
@@ -608,16 +1222,29 @@ void renderer::CompLayer::renderHelper(VPainter *    painter,
         } else {
             if (layer->visible()) {
                 if (matte) {
-                    if (matte->visible())
-                        renderMatteLayer(painter, mask, matteRle, matte, layer,
-                                         cache);
+                    if (matte->visible() && !matte->culled())
+                        rect = rect | matte->contentBounds();
                 } else {
-                    layer->render(painter, mask, matteRle, cache);
+                    rect = rect | layer->contentBounds();
                 }
             }
             matte = nullptr;
         }
     }
+    return rect;
+}
+
+size_t renderer::CompLayer::rasterCacheUsage() const
+{
+    size_t bytes = Layer::rasterCacheUsage();
+    for (const auto &layer : mLayers) bytes += layer->rasterCacheUsage();
+    return bytes;
+}
+
+void renderer::CompLayer::releaseRasterCache()
+{
+    Layer::releaseRasterCache();
+    for (auto &layer : mLayers) layer->releaseRasterCache();
 }
 
 void renderer::CompLayer::renderMatteLayer(VPainter *painter, const VRle &mask,
@@ -626,58 +1253,82 @@ void renderer::CompLayer::renderMatteLayer(VPainter *painter, const VRle &mask,
                                            renderer::Layer *src,
                                            SurfaceCache &   cache)
 {
-    VSize size = painter->clipBoundingRect().size();
-    // Decide if we can use fast matte.
-    // 1. draw src layer to matte buffer
+    VTRACE_SCOPE("matte");
+    auto matteType = layer->matteType();
+
+    // an alpha matte of solid colors is just coverage, a layer with a
+    // single drawable can then be drawn straight with the matte as clip, see
+    // Layer::render(). With more drawables the matte would be applied to
+    // each of them and overlaps would come out different.
+    VRle srcRle;
+    if ((matteType == model::MatteType::Alpha ||
+         matteType == model::MatteType::AlphaInv) &&
+        matteRle.empty() && !layer->precompLayer() &&
+        layer->renderList().size() == 1 &&
+        src->matteCoverage(painter->clipBoundingRect(), mask, srcRle)) {
+        VPROFILE_COUNT(mRleMattes, 1);
+        if (!srcRle.empty())
+            layer->render(painter, mask, srcRle, cache);
+        else if (matteType == model::MatteType::AlphaInv)
+            layer->render(painter, mask, {}, cache);
+        return;
+    }
+
+    // the matte only hides parts of the layer, and a non inverted one
+    // also everything outside of its own content. Both buffers only
+    // need to cover that area.
+    VRect area = layer->contentBounds() & painter->clipBoundingRect();
+    if (matteType == model::MatteType::Alpha ||
+        matteType == model::MatteType::Luma)
+        area = area & src->contentBounds();
+    if (area.empty()) return;
+
+    // 1. draw src layer to matte buffer, an alpha matte only needs the
+    // coverage of it.
+    bool luma = matteType == model::MatteType::Luma ||
+                matteType == model::MatteType::LumaInv;
     VPainter srcPainter;
-    VBitmap  srcBitmap = cache.make_surface(size.width(), size.height());
-    srcPainter.begin(&srcBitmap);
+    VBitmap  srcBitmap = beginOffscreen(
+        srcPainter, painter, area, cache,
+        luma ? VBitmap::Format::ARGB32_Premultiplied : VBitmap::Format::Alpha8);
     src->render(&srcPainter, mask, matteRle, cache);
     srcPainter.end();
 
     // 2. draw layer to layer buffer
     VPainter layerPainter;
-    VBitmap  layerBitmap = cache.make_surface(size.width(), size.height());
-    layerPainter.begin(&layerBitmap);
+    VBitmap  layerBitmap = beginOffscreen(layerPainter, painter, area, cache);
     layer->render(&layerPainter, mask, matteRle, cache);
 
     // 2.1update composition mode
-    switch (layer->matteType()) {
-    case model::MatteType::Alpha:
-    case model::MatteType::Luma: {
+    switch (matteType) {
+    case model::MatteType::Alpha: {
         layerPainter.setBlendMode(BlendMode::DestIn);
         break;
     }
-    case model::MatteType::AlphaInv:
-    case model::MatteType::LumaInv: {
+    case model::MatteType::AlphaInv: {
         layerPainter.setBlendMode(BlendMode::DestOut);
         break;
     }
-    default:
+    // the luminance of the src buffer is taken while blending, only the
+    // pixels of the area get converted.
+    case model::MatteType::Luma: {
+        layerPainter.setBlendMode(BlendMode::DestInLuma);
         break;
     }
-
-    // 2.2 update srcBuffer if the matte is luma type
-    if (layer->matteType() == model::MatteType::Luma ||
-        layer->matteType() == model::MatteType::LumaInv) {
-        srcBitmap.updateLuma();
+    case model::MatteType::LumaInv: {
+        layerPainter.setBlendMode(BlendMode::DestOutLuma);
+        break;
     }
-
-    auto clip = layerPainter.clipBoundingRect();
-
-    // if the layer has only one renderer then use it as the clip rect
-    // when blending 2 buffer and copy back to final buffer to avoid
-    // unnecessary pixel processing.
-    if (layer->renderList().size() == 1)
-    {
-        clip = layer->renderList()[0]->rle().boundingRect();
+    default:
+        break;
     }
 
-    // 2.3 draw src buffer as mask
-    layerPainter.drawBitmap(clip, srcBitmap, clip);
+    // 2.2 draw src buffer as mask
+    VPoint origin(area.x(), area.y());
+    layerPainter.drawBitmap(origin, srcBitmap);
     layerPainter.end();
     // 3. draw the result buffer into painter
-    painter->drawBitmap(clip, layerBitmap, clip);
+    painter->drawBitmap(origin, layerBitmap);
 
     cache.release_surface(srcBitmap);
     cache.release_surface(layerBitmap);
@@ -722,8 +1373,7 @@ void renderer::CompLayer::updateContent()
 
 void renderer::CompLayer::preprocessStage(const VRect &clip)
 {
-    // if layer has clipper
-    if (mClipper) mClipper->preprocess(clip);
+    bool culled = true;
 
     renderer::Layer *matte = nullptr;
     for (const auto &layer : mLayers) {
@@ -733,16 +1383,25 @@ void renderer::CompLayer::preprocessStage(const VRect &clip)
             if (layer->visible()) {
                 if (matte) {
                     if (matte->visible()) {
-                        layer->preprocess(clip);
+                        // the matte only hides parts of the matted layer,
+                        // its source is not needed if that one is culled.
                         matte->preprocess(clip);
+                        if (!matte->culled()) layer->preprocess(clip);
+                        culled &= matte->culled();
                     }
                 } else {
                     layer->preprocess(clip);
+                    culled &= layer->culled();
                 }
             }
             matte = nullptr;
         }
     }
+
+    mCulled = culled;
+
+    // if layer has clipper
+    if (mClipper && !mCulled) mClipper->preprocess(clip);
 }
 
 renderer::SolidLayer::SolidLayer(model::Layer *layerData)
@@ -769,9 +1428,17 @@ void renderer::SolidLayer::updateContent()
     }
 }
 
+bool renderer::SolidLayer::matteCoverage(const VRect &clip, const VRle &mask,
+                                         VRle &rle)
+{
+    // the layer alpha is part of the color.
+    return solidCoverage(clip, mask, 255, rle);
+}
+
 void renderer::SolidLayer::preprocessStage(const VRect &clip)
 {
     mRenderNode.preprocess(clip);
+    mCulled = mRenderNode.culled();
 }
 
 renderer::DrawableList renderer::SolidLayer::renderList()
@@ -815,6 +1482,7 @@ void renderer::ImageLayer::updateContent()
 void renderer::ImageLayer::preprocessStage(const VRect &clip)
 {
     mRenderNode.preprocess(clip);
+    mCulled = mRenderNode.culled();
 }
 
 renderer::DrawableList renderer::ImageLayer::renderList()
@@ -949,6 +1617,9 @@ void renderer::ShapeLayer::preprocessStage(const VRect &clip)
     mRoot->renderList(mDrawableList);
 
     for (auto &drawable : mDrawableList) drawable->preprocess(clip);
+
+    mCulled = std::all_of(mDrawableList.begin(), mDrawableList.end(),
+                          [](const VDrawable *d) { return d->culled(); });
 }
 
 renderer::DrawableList renderer::ShapeLayer::renderList()
@@ -966,77 +1637,98 @@ renderer::DrawableList renderer::ShapeLayer::renderList()
 void renderer::ShapeLayer::render(VPainter *painter, const VRle &inheritMask,
                                  const VRle &matteRle, SurfaceCache &cache)
 {
-    if (vIsZero(combinedAlpha())) return;
+    if (vIsZero(combinedAlpha()) || mCulled) return;
+
+    if (renderCached(painter, inheritMask, matteRle, cache)) return;
 
     if (vCompare(combinedAlpha(), 1.0)) {
         Layer::render(painter, inheritMask, matteRle, cache);
     } else {
         //do offscreen rendering
-        VSize    size = painter->clipBoundingRect().size();
+        VRect area = contentBounds() & painter->clipBoundingRect();
+        if (area.empty()) return;
         VPainter srcPainter;
-        VBitmap srcBitmap = cache.make_surface(size.width(), size.height());
-        srcPainter.begin(&srcBitmap);
+        VBitmap  srcBitmap = beginOffscreen(srcPainter, painter, area, cache);
         Layer::render(&srcPainter, inheritMask, matteRle, cache);
         srcPainter.end();
-        painter->drawBitmap(VPoint(), srcBitmap,
+        painter->drawBitmap(VPoint(area.x(), area.y()), srcBitmap,
                             uint8_t(combinedAlpha() * 255.0f));
         cache.release_surface(srcBitmap);
     }
 }
 
-bool renderer::Group::resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
-                                     LOTVariant &value)
+bool renderer::ShapeLayer::matteCoverage(const VRect &clip, const VRle &mask,
+                                         VRle &rle)
+{
+    if (vIsZero(combinedAlpha())) {
+        rle.reset();
+        return true;
+    }
+    return solidCoverage(clip, mask, uint8_t(combinedAlpha() * 255.0f), rle);
+}
+
+void renderer::Group::resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
+                                     KeyPathTargets &targets)
 {
     if (!keyPath.skip(name())) {
         if (!keyPath.matches(mModel.name(), depth)) {
-            return false;
+            return;
         }
 
-        if (!keyPath.skip(mModel.name())) {
-            if (keyPath.fullyResolvesTo(mModel.name(), depth) &&
-                transformProp(value.property())) {
-                mModel.filter()->addValue(value);
-            }
+        if (!keyPath.skip(mModel.name()) &&
+            keyPath.fullyResolvesTo(mModel.name(), depth)) {
+            targets.push_back({nullptr, this});
         }
     }
 
     if (keyPath.propagate(name(), depth)) {
         uint32_t newDepth = keyPath.nextDepth(name(), depth);
         for (auto &child : mContents) {
-            child->resolveKeyPath(keyPath, newDepth, value);
+            child->resolveKeyPath(keyPath, newDepth, targets);
         }
     }
+}
+
+bool renderer::Group::setValue(LOTVariant &value)
+{
+    if (!transformProp(value.property())) return false;
+
+    mModel.filter()->addValue(value);
     return true;
 }
 
-bool renderer::Fill::resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
-                                    LOTVariant &value)
+void renderer::Fill::resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
+                                    KeyPathTargets &targets)
 {
-    if (!keyPath.matches(mModel.name(), depth)) {
-        return false;
+    if (keyPath.matches(mModel.name(), depth) &&
+        keyPath.fullyResolvesTo(mModel.name(), depth)) {
+        targets.push_back({nullptr, this});
     }
+}
 
-    if (keyPath.fullyResolvesTo(mModel.name(), depth) &&
-        fillProp(value.property())) {
-        mModel.filter()->addValue(value);
-        return true;
-    }
-    return false;
+bool renderer::Fill::setValue(LOTVariant &value)
+{
+    if (!fillProp(value.property())) return false;
+
+    mModel.filter()->addValue(value);
+    return true;
 }
 
-bool renderer::Stroke::resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
-                                      LOTVariant &value)
+void renderer::Stroke::resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
+                                      KeyPathTargets &targets)
 {
-    if (!keyPath.matches(mModel.name(), depth)) {
-        return false;
+    if (keyPath.matches(mModel.name(), depth) &&
+        keyPath.fullyResolvesTo(mModel.name(), depth)) {
+        targets.push_back({nullptr, this});
     }
+}
 
-    if (keyPath.fullyResolvesTo(mModel.name(), depth) &&
-        strokeProp(value.property())) {
-        mModel.filter()->addValue(value);
-        return true;
-    }
-    return false;
+bool renderer::Stroke::setValue(LOTVariant &value)
+{
+    if (!strokeProp(value.property())) return false;
+
+    mModel.filter()->addValue(value);
+    return true;
 }
 
 renderer::Group::Group(model::Group *data, VArenaAlloc *allocator,
@@ -1082,8 +1774,9 @@ void renderer::Group::update(int frameNo, const VMatrix &parentMatrix,
         VMatrix m = mModel.matrix(frameNo);
 
         m *= parentMatrix;
-        if (!(flag & DirtyFlagBit::Matrix) && !mModel.transform()->isStatic() &&
-            (m != mMatrix)) {
+        // the transform of a static group can still be overridden by a
+        // dynamic property, so compare the matrix in any case.
+        if (!(flag & DirtyFlagBit::Matrix) && (m != mMatrix)) {
             newFlag |= DirtyFlagBit::Matrix;
         }
 
@@ -1210,6 +1903,7 @@ void renderer::Shape::update(int              frameNo, const VMatrix &, float,
         // from the last frame update.
         mTemp = VPath();
 
+        VPROFILE_SCOPE(Path);
         updatePath(mLocalPath, frameNo);
         mDirtyPath = true;
     }
@@ -1327,6 +2021,7 @@ void renderer::Paint::updateRenderNode()
     }
 
     if (dirty) {
+        VPROFILE_SCOPE(Path);
         mPath.reset();
         for (const auto &i : mPathItems) {
             i->finalPath(mPath);
@@ -1475,19 +2170,23 @@ bool renderer::GradientStroke::updateContent(int frameNo, const VMatrix &matrix,
     return !vIsZero(combinedAlpha);
 }
 
-bool renderer::Trim::resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
-                                      LOTVariant &value)
+void renderer::Trim::resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
+                                    KeyPathTargets &targets)
 {
-    if (!keyPath.matches(mModel.name(), depth)) {
-        return false;
+    if (keyPath.matches(mModel.name(), depth) &&
+        keyPath.fullyResolvesTo(mModel.name(), depth)) {
+        targets.push_back({nullptr, this});
     }
+}
 
-    if (keyPath.fullyResolvesTo(mModel.name(), depth) &&
-        trimProp(value.property())) {
-        mModel.filter()->addValue(value);
-        return true;
-    }
-    return false;
+bool renderer::Trim::setValue(LOTVariant &value)
+{
+    if (!trimProp(value.property())) return false;
+
+    mModel.filter()->addValue(value);
+    // recompute the segment even if the frame didn't change.
+    mCache.mFrameNo = -1;
+    return true;
 }
 
 void renderer::Trim::update(int frameNo, const VMatrix & /*parentMatrix*/,
@@ -1512,6 +2211,7 @@ void renderer::Trim::update()
     // when both path and trim are not dirty
     if (!(mDirty || pathDirty())) return;
 
+    VPROFILE_SCOPE(Path);
     if (vCompare(mCache.mSegment.start, mCache.mSegment.end)) {
         for (auto &i : mPathItems) {
             i->updatePath(VPath());
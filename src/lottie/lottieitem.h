@@ -25,6 +25,7 @@
 
 #include <memory>
 #include <sstream>
+#include <unordered_map>
 
 #include "lottiekeypath.h"
 #include "lottiefiltermodel.h"
@@ -33,10 +34,12 @@
 #include "varenaalloc.h"
 #include "vdrawable.h"
 #include "vmatrix.h"
+#include "vmemory.h"
 #include "vpainter.h"
 #include "vpath.h"
 #include "vpathmesure.h"
 #include "vpoint.h"
+#include "vprofile.h"
 
 V_USE_NAMESPACE
 
@@ -88,29 +91,45 @@ enum class DirtyFlagBit : uint8_t {
 };
 typedef vFlag<DirtyFlagBit> DirtyFlag;
 
+/*
+ * Pool of the offscreen surfaces. Surfaces are allocated with the size of
+ * their size class, so a released surface serves any later request of its
+ * class. The released surfaces are kept within the budget, least recently
+ * used first out, and freed once they were not used for a while.
+ */
 class SurfaceCache {
 public:
     SurfaceCache() { mCache.reserve(10); }
 
     VBitmap make_surface(
         size_t width, size_t height,
-        VBitmap::Format format = VBitmap::Format::ARGB32_Premultiplied)
-    {
-        if (mCache.empty()) return {width, height, format};
+        VBitmap::Format format = VBitmap::Format::ARGB32_Premultiplied);
+    void release_surface(VBitmap &surface);
 
-        auto surface = mCache.back();
-        surface.reset(width, height, format);
+    // frees the surfaces not used in the last frames, call once per frame.
+    void nextFrame();
+    // 0 keeps every released surface (default).
+    void setBudget(size_t bytes);
 
-        mCache.pop_back();
-        return surface;
-    }
+    size_t memoryUsage() const { return mBytes; }
 
-    void release_surface(VBitmap &surface) { mCache.push_back(surface); }
+    void clear();
 
     int mRenderDepth{0};
 
 private:
-    std::vector<VBitmap> mCache;
+    struct Entry {
+        VBitmap  mSurface;
+        uint32_t mFrame;
+    };
+    static size_t sizeClass(size_t bytes);
+    void          evict(size_t bytes);
+    void          remove(size_t index);
+
+    std::vector<Entry> mCache;
+    size_t             mBytes{0};
+    size_t             mBudget{0};
+    uint32_t           mFrame{0};
 };
 
 class Drawable final : public VDrawable {
@@ -187,7 +206,45 @@ public:
     bool              mDirty{true};
 };
 
+/*
+ * Remembers the bounds and a content signature of every drawable painted
+ * in the last frame, the damage of a frame is the union of the bounds of
+ * the drawables that appeared, disappeared or changed since then. A
+ * drawable added as whole is repainted entirely or not at all.
+ */
+class DamageTracker {
+public:
+    void  add(const void *key, const VRect &bounds, uint64_t signature,
+              bool whole = false);
+    VRect damage();
+    void  reset();
+
+private:
+    struct Entry {
+        VRect    mBounds;
+        VRect    mPrevBounds;
+        uint64_t mSignature{0};
+        uint64_t mPrevSignature{0};
+        uint32_t mFrame{0};
+        bool     mPrevDrawn{false};
+        bool     mWhole{false};
+    };
+    std::unordered_map<const void *, Entry> mEntries;
+    uint32_t                                mFrame{1};
+};
+
 class Layer;
+class Object;
+
+/*
+ * content node a keypath resolved to and the layer it belongs to.
+ */
+struct KeyPathTarget {
+    Layer * mLayer{nullptr};
+    Object *mContent{nullptr};
+};
+
+using KeyPathTargets = std::vector<KeyPathTarget>;
 
 class Composition {
 public:
@@ -196,11 +253,21 @@ public:
     VSize size() const { return mViewSize; }
     void  buildRenderTree();
     const LOTLayerNode *renderTree() const;
-    bool                render(const rlottie::Surface &surface);
-    void                setValue(const std::string &keypath, LOTVariant &value);
+    bool render(const rlottie::Surface &surface, VRect *damage = nullptr);
+    void invalidateDamage();
+    KeyPathTargets resolveKeyPath(const std::string &keypath);
+    void setValue(const KeyPathTargets &targets, LOTVariant &value);
+    bool hasDynamicValue() const { return mHasDynamicValue; }
+    void setThreadCount(size_t count) { mThreadCount = count; }
+    void setSurfaceBudget(size_t bytes) { mSurfaceCache.setBudget(bytes); }
+    const std::shared_ptr<model::Composition> &model() const { return mModel; }
+    void memoryUsage(VMemoryUsage &usage) const;
+    void trim(VTrimLevel level);
 
 private:
     SurfaceCache                        mSurfaceCache;
+    DamageTracker                       mDamageTracker;
+    rlottie::Surface                    mDamageSurface;
     VBitmap                             mSurface;
     VMatrix                             mScaleMatrix;
     VSize                               mViewSize;
@@ -208,8 +275,11 @@ private:
     Layer *                             mRootLayer{nullptr};
     VArenaAlloc                         mAllocator{2048};
     int                                 mCurFrameNo;
+    size_t                              mThreadCount{1};
     bool                                mKeepAspectRatio{true};
     bool                                mHasDynamicValue{false};
+    bool                                mValueChanged{false};
+    bool                                mDamageValid{false};
 };
 
 class Layer {
@@ -230,6 +300,8 @@ public:
     virtual DrawableList renderList() { return {}; }
     virtual void         render(VPainter *painter, const VRle &mask,
                                 const VRle &matteRle, SurfaceCache &cache);
+    virtual void collectDamage(DamageTracker &tracker, const VRect &clip,
+                               const VRle &mask, uint64_t signature);
     bool                 hasMatte()
     {
         if (mLayerData->mMatteType == model::MatteType::None) return false;
@@ -237,14 +309,30 @@ public:
     }
     model::MatteType matteType() const { return mLayerData->mMatteType; }
     bool             visible() const;
+    // true if nothing of the layer is inside the clip of the last
+    // preprocess, the layer is neither rasterized nor rendered then.
+    bool             culled() const { return mCulled; }
+    // area the layer draws into, it can be larger than what is actually
+    // drawn but never smaller. Valid once the layer got preprocessed.
+    virtual VRect    contentBounds();
+    // coverage of the layer as a single rle when it only draws solid
+    // colors, lets a track matte be applied without offscreen buffers.
+    virtual bool     matteCoverage(const VRect &, const VRle &, VRle &)
+    {
+        return false;
+    }
+    bool             precompLayer() const { return mLayerData->precompLayer(); }
     virtual void     buildLayerNode();
     LOTLayerNode &   clayer() { return mCApiData->mLayer; }
     std::vector<LOTLayerNode *> &clayers() { return mCApiData->mLayers; }
     std::vector<LOTMask> &       cmasks() { return mCApiData->mMasks; }
     std::vector<LOTNode *> &     cnodes() { return mCApiData->mCNodeList; }
     const char *                 name() const { return mLayerData->name(); }
-    virtual bool resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
-                                LOTVariant &value);
+    virtual void resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
+                                KeyPathTargets &targets);
+    void         valueChanged(const LOTVariant &value);
+    virtual size_t rasterCacheUsage() const;
+    virtual void   releaseRasterCache();
 
 protected:
     virtual void   preprocessStage(const VRect &clip) = 0;
@@ -259,6 +347,33 @@ protected:
     {
         return (!visible() || vIsZero(combinedAlpha()));
     }
+    bool renderCached(VPainter *painter, const VRle &mask,
+                      const VRle &matteRle, SurfaceCache &cache);
+    bool solidCoverage(const VRect &clip, const VRle &inheritMask,
+                       uint8_t alpha, VRle &rle);
+
+private:
+    bool rasterCacheWorthy(const DrawableList &renderlist,
+                           const VRle &        mask) const;
+    bool rasterCacheMatches(const VRect &rect, uint64_t maskHash) const;
+    bool rasterCached(const DrawableList &renderlist,
+                      const VRle &        inheritMask);
+    void buildRasterCache(const VRle &mask, size_t threadCount,
+                          SurfaceCache &cache);
+
+    /*
+     * Rasterized content of a static layer, it is valid as long as the
+     * layer is rendered with the same matrix and inherited mask and its
+     * rles, clipped to the surface, keep the same bounds.
+     */
+    struct RasterCache {
+        VBitmap  mBitmap;
+        VRect    mRect;
+        VMatrix  mMatrix;
+        uint64_t mMaskHash{0};
+        bool     mValid{false};
+    };
+    RasterCache mRasterCache;
 
 protected:
     std::unique_ptr<LayerMask> mLayerMask;
@@ -269,6 +384,9 @@ protected:
     int                        mFrameNo{-1};
     DirtyFlag                  mDirtyFlag{DirtyFlagBit::All};
     bool                       mComplexContent{false};
+    bool                       mCulled{false};
+    bool                       mHasDynamicValue{false};
+    bool                       mValueChanged{false};
     std::unique_ptr<CApiData>  mCApiData;
 };
 
@@ -279,15 +397,21 @@ public:
 
     void render(VPainter *painter, const VRle &mask, const VRle &matteRle,
                 SurfaceCache &cache) final;
+    void collectDamage(DamageTracker &tracker, const VRect &clip,
+                       const VRle &mask, uint64_t signature) final;
+    VRect contentBounds() final;
     void buildLayerNode() final;
-    bool resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
-                        LOTVariant &value) override;
+    void resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
+                        KeyPathTargets &targets) override;
+    size_t rasterCacheUsage() const final;
+    void   releaseRasterCache() final;
 
 protected:
     void preprocessStage(const VRect &clip) final;
     void updateContent() final;
 
 private:
+    bool layerMask(const VRect &clip, const VRle &inheritMask, VRle &mask);
     void renderHelper(VPainter *painter, const VRle &mask, const VRle &matteRle,
                       SurfaceCache &cache);
     void renderMatteLayer(VPainter *painter, const VRle &inheritMask,
@@ -304,6 +428,7 @@ public:
     explicit SolidLayer(model::Layer *layerData);
     void         buildLayerNode() final;
     DrawableList renderList() final;
+    bool matteCoverage(const VRect &clip, const VRle &mask, VRle &rle) final;
 
 protected:
     void preprocessStage(const VRect &clip) final;
@@ -323,10 +448,11 @@ public:
                         size_t &contentBudget);
     DrawableList renderList() final;
     void         buildLayerNode() final;
-    bool         resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
-                                LOTVariant &value) override;
+    void         resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
+                                KeyPathTargets &targets) override;
     void         render(VPainter *painter, const VRle &mask, const VRle &matteRle,
                         SurfaceCache &cache) final;
+    bool matteCoverage(const VRect &clip, const VRle &mask, VRle &rle) final;
 
 protected:
     void                     preprocessStage(const VRect &clip) final;
@@ -369,10 +495,9 @@ public:
     virtual void update(int frameNo, const VMatrix &parentMatrix,
                         float parentAlpha, const DirtyFlag &flag) = 0;
     virtual void renderList(std::vector<VDrawable *> &) {}
-    virtual bool resolveKeyPath(LOTKeyPath &, uint32_t, LOTVariant &)
-    {
-        return false;
-    }
+    virtual void resolveKeyPath(LOTKeyPath &, uint32_t, KeyPathTargets &) {}
+    // returns true if the node has the property of the value.
+    virtual bool setValue(LOTVariant &) { return false; }
     virtual Object::Type type() const { return Object::Type::Unknown; }
 };
 
@@ -397,8 +522,9 @@ public:
         static const char *TAG = "__";
         return mModel.hasModel() ? mModel.name() : TAG;
     }
-    bool resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
-                        LOTVariant &value) override;
+    void resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
+                        KeyPathTargets &targets) override;
+    bool setValue(LOTVariant &value) override;
 
 protected:
     std::vector<Object *> mContents;
@@ -542,8 +668,9 @@ public:
 
 protected:
     bool updateContent(int frameNo, const VMatrix &matrix, float alpha) final;
-    bool resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
-                        LOTVariant &value) final;
+    void resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
+                        KeyPathTargets &targets) final;
+    bool setValue(LOTVariant &value) final;
 
 private:
     model::Filter<model::Fill> mModel;
@@ -567,8 +694,9 @@ public:
 
 protected:
     bool updateContent(int frameNo, const VMatrix &matrix, float alpha) final;
-    bool resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
-                        LOTVariant &value) final;
+    void resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
+                        KeyPathTargets &targets) final;
+    bool setValue(LOTVariant &value) final;
 
 private:
     model::Filter<model::Stroke> mModel;
@@ -596,8 +724,9 @@ public:
     void         addPathItems(std::vector<Shape *> &list, size_t startOffset);
 
 protected:
-    bool resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
-                        LOTVariant &value) final;
+    void resolveKeyPath(LOTKeyPath &keyPath, uint32_t depth,
+                        KeyPathTargets &targets) final;
+    bool setValue(LOTVariant &value) final;
 private:
     bool pathDirty() const
     {
@@ -26,14 +26,32 @@
 
 #include "lottiemodel.h"
 
+#if defined(__unix__) || defined(__APPLE__)
+#define LOTTIE_MMAP_SUPPORT
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 using namespace rlottie::internal;
 
 #ifdef LOTTIE_CACHE_SUPPORT
 
+#include <list>
 #include <mutex>
 #include <unordered_map>
+#include "vmemory.h"
 
-class ModelCache {
+/*
+ * Least recently used cache of the parsed models.
+ * Entries are kept in mLru from most to least recently used, mHash maps the
+ * key to its position in the list. The cache is bounded by the number of
+ * entries and optionally by the approximate memory held by the models.
+ * The models are also reported to the process wide memory budget, which
+ * drops them all when it trims the caches.
+ */
+class ModelCache : public VMemoryClient {
 public:
     static ModelCache &instance()
     {
@@ -47,20 +65,61 @@ public:
         if (!mcacheSize) return nullptr;
 
         auto search = mHash.find(key);
-
-        return (search != mHash.end()) ? search->second : nullptr;
+        if (search == mHash.end()) {
+            mStats.misses++;
+            return nullptr;
+        }
+
+        mStats.hits++;
+        // move the entry to the front of the lru list.
+        mLru.splice(mLru.begin(), mLru, search->second);
+        return search->second->mModel;
     }
     void add(const std::string &key, std::shared_ptr<model::Composition> value)
     {
-        std::lock_guard<std::mutex> guard(mMutex);
+        // walking the model is not free, keep it out of the lock.
+        auto bytes = value->memoryUsage();
+
+        {
+            std::lock_guard<std::mutex> guard(mMutex);
+
+            if (!mcacheSize) return;
+
+            // a model that alone exceeds the budget is never cached.
+            if (mBudget && bytes > mBudget) return;
+
+            auto search = mHash.find(key);
+            if (search != mHash.end()) {
+                mStats.bytes -= search->second->mBytes;
+                mLru.erase(search->second);
+                mHash.erase(search);
+            }
+
+            mLru.push_front({key, std::move(value), bytes});
+            mHash[key] = mLru.begin();
+            mStats.bytes += bytes;
+
+            shrink();
+        }
+        VMemoryBudget::instance().grew();
+        VMemoryBudget::instance().enforce();
+    }
 
-        if (!mcacheSize) return;
+    void usage(VMemoryUsage &usage) const override
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        usage.model += mStats.bytes;
+    }
 
-        //@TODO just remove the 1st element
-        // not the best of LRU logic
-        if (mcacheSize == mHash.size()) mHash.erase(mHash.cbegin());
+    void trim(VTrimLevel level) override
+    {
+        if (level == VTrimLevel::Scratch) return;
 
-        mHash[key] = std::move(value);
+        std::lock_guard<std::mutex> guard(mMutex);
+        mStats.evictions += mLru.size();
+        mStats.bytes = 0;
+        mHash.clear();
+        mLru.clear();
     }
 
     void configureCacheSize(size_t cacheSize)
@@ -68,15 +127,53 @@ public:
         std::lock_guard<std::mutex> guard(mMutex);
         mcacheSize = cacheSize;
 
-        if (!mcacheSize) mHash.clear();
+        shrink();
+    }
+
+    void configureBudget(size_t bytes)
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        mBudget = bytes;
+
+        shrink();
+    }
+
+    model::ModelCacheStats stats()
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        auto stats = mStats;
+        stats.entries = mHash.size();
+        return stats;
     }
 
 private:
-    ModelCache() = default;
+    struct Entry {
+        std::string                         mKey;
+        std::shared_ptr<model::Composition> mModel;
+        size_t                              mBytes;
+    };
 
-    std::unordered_map<std::string, std::shared_ptr<model::Composition>> mHash;
-    std::mutex                                                           mMutex;
+    void shrink()
+    {
+        while (!mLru.empty() && (mLru.size() > mcacheSize ||
+                                 (mBudget && mStats.bytes > mBudget))) {
+            auto &entry = mLru.back();
+            mStats.bytes -= entry.mBytes;
+            mStats.evictions++;
+            mHash.erase(entry.mKey);
+            mLru.pop_back();
+        }
+    }
+
+    ModelCache() { VMemoryBudget::instance().add(this); }
+    ~ModelCache() override { VMemoryBudget::instance().remove(this); }
+
+    std::list<Entry>                                              mLru;
+    std::unordered_map<std::string, std::list<Entry>::iterator>  mHash;
+    mutable std::mutex                                            mMutex;
+    model::ModelCacheStats                                        mStats;
     size_t mcacheSize{10};
+    size_t mBudget{0};
 };
 
 #else
@@ -94,6 +191,8 @@ public:
     }
     void add(const std::string &, std::shared_ptr<model::Composition>) {}
     void configureCacheSize(size_t) {}
+    void configureBudget(size_t) {}
+    model::ModelCacheStats stats() { return {}; }
 };
 
 #endif
@@ -113,6 +212,60 @@ void model::configureModelCacheSize(size_t cacheSize)
     ModelCache::instance().configureCacheSize(cacheSize);
 }
 
+void model::configureModelCacheBudget(size_t bytes)
+{
+    ModelCache::instance().configureBudget(bytes);
+}
+
+model::ModelCacheStats model::modelCacheStats()
+{
+    return ModelCache::instance().stats();
+}
+
+#ifdef LOTTIE_MMAP_SUPPORT
+
+/*
+ * Parse the file straight from a private copy-on-write mapping instead of
+ * reading it into a string first. The in-situ json parser only writes to
+ * the pages holding escaped strings, so those are the only pages that get
+ * copied, the rest is shared with the page cache.
+ * The parser needs a '\0' terminated buffer, mmap() zero fills the tail of
+ * the last page so that is guaranteed unless the file size is a multiple of
+ * the page size. Returns false if the file has to be read the regular way.
+ */
+static bool parseMappedFile(const std::string &                  path,
+                            std::shared_ptr<model::Composition> &result)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+
+    auto fsize = size_t(st.st_size);
+    auto pageSize = size_t(sysconf(_SC_PAGESIZE));
+    if (!pageSize || !(fsize % pageSize)) {
+        close(fd);
+        return false;
+    }
+
+    void *data = mmap(nullptr, fsize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+
+    madvise(data, fsize, MADV_SEQUENTIAL);
+
+    result = model::parse(static_cast<char *>(data), fsize, dirname(path));
+
+    munmap(data, fsize);
+    return true;
+}
+
+#endif
+
 std::shared_ptr<model::Composition> model::loadFromFile(const std::string &path,
                                                         bool cachePolicy)
 {
@@ -121,6 +274,14 @@ std::shared_ptr<model::Composition> model::loadFromFile(const std::string &path,
         if (obj) return obj;
     }
 
+#ifdef LOTTIE_MMAP_SUPPORT
+    std::shared_ptr<model::Composition> mapped;
+    if (parseMappedFile(path, mapped)) {
+        if (mapped && cachePolicy) ModelCache::instance().add(path, mapped);
+        return mapped;
+    }
+#endif
+
     std::ifstream f;
     f.open(path);
 
@@ -167,9 +328,88 @@ std::shared_ptr<model::Composition> model::loadFromData(
     return obj;
 }
 
+std::shared_ptr<model::Composition> model::loadFromData(
+    std::unique_ptr<char[]> data, size_t size, const std::string &key,
+    std::string resourcePath, bool cachePolicy)
+{
+    if (!data || !size) return {};
+
+    if (cachePolicy) {
+        auto obj = ModelCache::instance().find(key);
+        if (obj) return obj;
+    }
+
+    // the in-situ parser needs the '\0' terminator inside the buffer,
+    // only fall back to a copy when the caller didn't provide one.
+    if (data[size - 1] != '\0') {
+        auto copy = std::make_unique<char[]>(size + 1);
+        memcpy(copy.get(), data.get(), size);
+        copy[size] = '\0';
+        data = std::move(copy);
+    }
+
+    auto obj = internal::model::parse(data.get(), size, std::move(resourcePath));
+
+    if (obj && cachePolicy) ModelCache::instance().add(key, obj);
+
+    return obj;
+}
+
 std::shared_ptr<model::Composition> model::loadFromData(
     std::string jsonData, std::string resourcePath, model::ColorFilter filter)
 {
     return internal::model::parse(const_cast<char *>(jsonData.c_str()), jsonData.size(),
                                   std::move(resourcePath), std::move(filter));
 }
+
+std::shared_ptr<model::Composition> model::loadFromBinary(
+    const std::string &path, bool cachePolicy)
+{
+    if (cachePolicy) {
+        auto obj = ModelCache::instance().find(path);
+        if (obj) return obj;
+    }
+
+    std::ifstream f;
+    f.open(path, std::ios::binary);
+
+    if (!f.is_open()) {
+        vCritical << "failed to open file = " << path.c_str();
+        return {};
+    }
+
+    std::string content;
+    f.seekg(0, std::ios::end);
+    auto fsize = f.tellg();
+    if (fsize <= 0) return {};
+
+    content.resize(size_t(fsize));
+    f.seekg(0, std::ios::beg);
+    f.read(&content[0], fsize);
+    f.close();
+
+    auto obj = internal::model::deserialize(content.data(), content.size());
+
+    if (obj && cachePolicy) ModelCache::instance().add(path, obj);
+
+    return obj;
+}
+
+bool model::saveBinary(const model::Composition &composition,
+                       const std::string &       path)
+{
+    auto data = internal::model::serialize(composition);
+
+    std::ofstream f;
+    f.open(path, std::ios::binary | std::ios::trunc);
+
+    if (!f.is_open()) {
+        vCritical << "failed to open file = " << path.c_str();
+        return false;
+    }
+
+    f.write(data.data(), data.size());
+    f.close();
+
+    return !f.fail();
+}
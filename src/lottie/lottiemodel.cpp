@@ -166,6 +166,160 @@ private:
     int mDepth{0};
 };
 
+/*
+ * Approximates the heap memory held by the model. The objects themselves
+ * live in the arena, so only the data owned by them outside the arena
+ * (keyframe lists, path points, gradient stops, masks) is counted here.
+ * Precomp layers share their children with the asset, so only the asset
+ * list is walked for them.
+ */
+class LottieMemoryVisitor {
+public:
+    size_t bytes{0};
+
+    void visitChildren(const model::Group *obj)
+    {
+        for (const auto &child : obj->mChildren) {
+            if (child) visit(child);
+        }
+        if (obj->mTransform) visitTransform(obj->mTransform);
+    }
+    void visitLayer(const model::Layer *layer)
+    {
+        if (layer->mExtra) {
+            bytes += sizeof(model::Layer::Extra);
+            add(layer->mExtra->mTimeRemap);
+            for (const auto &mask : layer->mExtra->mMasks) {
+                add(mask->mShape);
+                add(mask->mOpacity);
+            }
+        }
+        if (layer->precompLayer()) {
+            if (layer->mTransform) visitTransform(layer->mTransform);
+            return;
+        }
+        visitChildren(layer);
+    }
+    void visitTransform(const model::Transform *obj)
+    {
+        auto data = obj->data();
+        if (!data) return;
+        add(data->mRotation);
+        add(data->mScale);
+        add(data->mPosition);
+        add(data->mAnchor);
+        add(data->mOpacity);
+        if (data->mExtra) bytes += sizeof(model::Transform::Data::Extra);
+    }
+    void visit(const model::Object *obj)
+    {
+        if (mDepth >= kMaxModelTreeDepth) return;
+        DepthGuard guard(mDepth);
+        switch (obj->type()) {
+        case model::Object::Type::Layer: {
+            visitLayer(static_cast<const model::Layer *>(obj));
+            break;
+        }
+        case model::Object::Type::Group: {
+            visitChildren(static_cast<const model::Group *>(obj));
+            break;
+        }
+        case model::Object::Type::Repeater: {
+            auto content = static_cast<const model::Repeater *>(obj)->content();
+            if (content) visitChildren(content);
+            break;
+        }
+        case model::Object::Type::Path: {
+            add(static_cast<const model::Path *>(obj)->mShape);
+            break;
+        }
+        case model::Object::Type::Fill: {
+            auto fill = static_cast<const model::Fill *>(obj);
+            add(fill->mColor);
+            add(fill->mOpacity);
+            break;
+        }
+        case model::Object::Type::Stroke: {
+            auto stroke = static_cast<const model::Stroke *>(obj);
+            add(stroke->mColor);
+            add(stroke->mOpacity);
+            add(stroke->mWidth);
+            break;
+        }
+        case model::Object::Type::GFill:
+        case model::Object::Type::GStroke: {
+            auto gradient = static_cast<const model::Gradient *>(obj);
+            add(gradient->mStartPoint);
+            add(gradient->mEndPoint);
+            add(gradient->mGradient);
+            break;
+        }
+        case model::Object::Type::Rect: {
+            auto rect = static_cast<const model::Rect *>(obj);
+            add(rect->mPos);
+            add(rect->mSize);
+            break;
+        }
+        case model::Object::Type::Ellipse: {
+            auto ellipse = static_cast<const model::Ellipse *>(obj);
+            add(ellipse->mPos);
+            add(ellipse->mSize);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+private:
+    size_t size(const model::PathData &path) const
+    {
+        return path.mPoints.capacity() * sizeof(VPointF);
+    }
+    size_t size(const model::Gradient::Data &grad) const
+    {
+        return grad.mGradient.capacity() * sizeof(float);
+    }
+    template <typename T>
+    size_t size(const T &) const
+    {
+        return 0;
+    }
+    template <typename T, typename Tag>
+    void add(const model::Property<T, Tag> &prop)
+    {
+        if (prop.isStatic()) {
+            bytes += size(prop.value());
+            return;
+        }
+        const auto &frames = prop.animation().frames_;
+        bytes += sizeof(typename model::Property<T, Tag>::Animation) +
+                 frames.capacity() * sizeof(frames.front());
+        for (const auto &frame : frames)
+            bytes += size(frame.value_.start_) + size(frame.value_.end_);
+    }
+
+    int mDepth{0};
+};
+
+size_t model::Composition::memoryUsage() const
+{
+    LottieMemoryVisitor visitor;
+
+    visitor.bytes = sizeof(model::Composition) + mArenaAlloc.allocatedSize();
+    if (mRootLayer) visitor.visit(mRootLayer);
+
+    for (const auto &e : mAssets) {
+        auto asset = e.second;
+        visitor.bytes += sizeof(model::Asset) + e.first.capacity();
+        if (asset->mBitmap.valid())
+            visitor.bytes += asset->mBitmap.stride() * asset->mBitmap.height();
+        for (const auto &layer : asset->mLayers) visitor.visit(layer);
+    }
+
+    return visitor.bytes;
+}
+
 void model::Composition::processRepeaterObjects()
 {
     LottieRepeaterProcesser visitor;
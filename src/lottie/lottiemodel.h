@@ -24,6 +24,7 @@
 #define LOTModel_H
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstring>
 #include <functional>
@@ -244,10 +245,8 @@ public:
                 return frames_.front().value_.start_;
             if (frames_.back().end_ <= frameNo) return frames_.back().value_.end_;
 
-            for (const auto &keyFrame : frames_) {
-                if (frameNo >= keyFrame.start_ && frameNo < keyFrame.end_)
-                    return keyFrame.value(frameNo);
-            }
+            auto index = frameIndex(frameNo);
+            if (index >= 0) return frames_[index].value(frameNo);
         }
         return {};
     }
@@ -259,11 +258,40 @@ public:
             (frames_.back().end_ <= frameNo))
             return 0;
 
-        for (const auto &frame : frames_) {
-            if (frameNo >= frame.start_ && frameNo < frame.end_)
-                return frame.angle(frameNo);
+        auto index = frameIndex(frameNo);
+        return index >= 0 ? frames_[index].angle(frameNo) : 0;
+    }
+
+    /*
+     * Returns the index of the keyframe that contains frameNo or -1.
+     * Sequential playback either stays in the last found keyframe or moves
+     * to the next one, so those are checked first before falling back to a
+     * binary search. The model is shared between animations rendering in
+     * parallel, hence the cursor is only a relaxed atomic hint.
+     */
+    int frameIndex(int frameNo) const
+    {
+        auto contains = [frameNo](const Frame &frame) {
+            return frameNo >= frame.start_ && frameNo < frame.end_;
+        };
+
+        auto size = frames_.size();
+        auto hint = cursor_.load(std::memory_order_relaxed);
+        if (hint < size && contains(frames_[hint])) return int(hint);
+        if (hint + 1 < size && contains(frames_[hint + 1])) {
+            cursor_.store(hint + 1, std::memory_order_relaxed);
+            return int(hint + 1);
         }
-        return 0;
+
+        // keyframes are sorted, find the first one that ends after frameNo.
+        auto it = std::upper_bound(
+            frames_.cbegin(), frames_.cend(), frameNo,
+            [](int frame, const Frame &keyFrame) { return frame < keyFrame.end_; });
+        if (it == frames_.cend() || !contains(*it)) return -1;
+
+        auto index = uint32_t(it - frames_.cbegin());
+        cursor_.store(index, std::memory_order_relaxed);
+        return int(index);
     }
 
     bool changed(int prevFrame, int curFrame) const
@@ -283,6 +311,9 @@ public:
 
 public:
     std::vector<Frame> frames_;
+
+private:
+    mutable std::atomic<uint32_t> cursor_{0};
 };
 
 template <typename T, typename Tag = void>
@@ -351,11 +382,11 @@ public:
             if (vec.back().end_ <= frameNo)
                 return vec.back().value_.end_.toPath(path);
 
-            for (const auto &keyFrame : vec) {
-                if (frameNo >= keyFrame.start_ && frameNo < keyFrame.end_) {
-                    T::lerp(keyFrame.value_.start_, keyFrame.value_.end_,
-                            keyFrame.progress(frameNo), path);
-                }
+            auto index = animation().frameIndex(frameNo);
+            if (index >= 0) {
+                const auto &keyFrame = vec[index];
+                T::lerp(keyFrame.value_.start_, keyFrame.value_.end_,
+                        keyFrame.progress(frameNo), path);
             }
         }
     }
@@ -553,6 +584,7 @@ public:
     VSize  size() const { return mSize; }
     void   processRepeaterObjects();
     void   updateStats();
+    size_t memoryUsage() const;
 
 public:
     struct Stats {
@@ -618,6 +650,12 @@ public:
             impl.mData = data;
         }
     }
+    void set(const VMatrix &matrix, float opacity)
+    {
+        setStatic(true);
+        new (&impl.mStaticData) StaticData(VMatrix(matrix), opacity);
+    }
+    const Data *data() const { return isStatic() ? nullptr : impl.mData; }
     VMatrix matrix(int frameNo, bool autoOrient = false) const
     {
         if (isStatic()) return impl.mStaticData.mMatrix;
@@ -1149,8 +1187,20 @@ inline Gradient::Data operator*(float m, const Gradient::Data &g)
 
 using ColorFilter = std::function<void(float &, float &, float &)>;
 
+struct ModelCacheStats {
+    size_t hits{0};
+    size_t misses{0};
+    size_t evictions{0};
+    size_t entries{0};
+    size_t bytes{0};
+};
+
 void configureModelCacheSize(size_t cacheSize);
 
+void configureModelCacheBudget(size_t bytes);
+
+ModelCacheStats modelCacheStats();
+
 std::shared_ptr<model::Composition> loadFromFile(const std::string &filePath,
                                                  bool cachePolicy);
 
@@ -1163,9 +1213,26 @@ std::shared_ptr<model::Composition> loadFromData(std::string jsonData,
                                                  std::string resourcePath,
                                                  ColorFilter filter);
 
+std::shared_ptr<model::Composition> loadFromData(std::unique_ptr<char[]> data,
+                                                 size_t                  size,
+                                                 const std::string &     key,
+                                                 std::string resourcePath,
+                                                 bool        cachePolicy);
+
 std::shared_ptr<model::Composition> parse(char *str, size_t length, std::string dir_path,
                                           ColorFilter filter = {});
 
+std::shared_ptr<model::Composition> loadFromBinary(const std::string &filePath,
+                                                   bool cachePolicy);
+
+bool saveBinary(const model::Composition &composition,
+                const std::string &       filePath);
+
+std::string serialize(const model::Composition &composition);
+
+std::shared_ptr<model::Composition> deserialize(const char *data,
+                                                size_t      length);
+
 }  // namespace model
 
 }  // namespace internal
@@ -58,6 +58,7 @@
 #include <unordered_set>
 
 #include "lottiemodel.h"
+#include "vprofile.h"
 #include "rapidjson/document.h"
 #include "zip/zip.h"
 
@@ -2597,6 +2598,7 @@ std::shared_ptr<model::Composition> model::parse(char *             str,
                                                  std::string        dir_path,
                                                  model::ColorFilter filter)
 {
+    VTRACE_SCOPE("parse");
     auto input = str;
 
     auto dotLottie = checkDotLottie(str);
@@ -21,6 +21,7 @@
  */
 
 #include "vbitmap.h"
+#include <algorithm>
 #include <string>
 #include <memory>
 #include "vdrawhelper.h"
@@ -28,7 +29,8 @@
 
 V_BEGIN_NAMESPACE
 
-void VBitmap::Impl::reset(size_t width, size_t height, VBitmap::Format format)
+void VBitmap::Impl::reset(size_t width, size_t height, VBitmap::Format format,
+                          size_t capacity)
 {
     mRoData = nullptr;
     mWidth = uint32_t(width);
@@ -36,9 +38,15 @@ void VBitmap::Impl::reset(size_t width, size_t height, VBitmap::Format format)
     mFormat = format;
 
     mDepth = depth(format);
-    mStride = ((mWidth * mDepth + 31) >> 5)
-                  << 2;  // bytes per scanline (must be multiple of 4)
-    mOwnData = std::make_unique<uint8_t[]>(mStride * mHeight);
+    mStride = uint32_t(bytesPerLine(width, format));
+
+    size_t bytes = std::max(size_t(mStride) * mHeight, capacity);
+    if (mOwnData && bytes <= mCapacity) return;
+
+    mOwnData = std::make_unique<uint8_t[]>(bytes + alignment - 1);
+    mCapacity = bytes;
+    auto offset = reinterpret_cast<uintptr_t>(mOwnData.get()) % alignment;
+    mAlignedData = mOwnData.get() + (offset ? alignment - offset : 0);
 }
 
 void VBitmap::Impl::reset(uint8_t *data, size_t width, size_t height,
@@ -51,6 +59,8 @@ void VBitmap::Impl::reset(uint8_t *data, size_t width, size_t height,
     mFormat = format;
     mDepth = depth(format);
     mOwnData = nullptr;
+    mAlignedData = nullptr;
+    mCapacity = 0;
 }
 
 uint8_t VBitmap::Impl::depth(VBitmap::Format format)
@@ -75,41 +85,12 @@ void VBitmap::Impl::fill(uint32_t /*pixel*/)
     //@TODO
 }
 
-void VBitmap::Impl::updateLuma()
-{
-    if (mFormat != VBitmap::Format::ARGB32_Premultiplied) return;
-    auto dataPtr = data();
-    for (uint32_t col = 0; col < mHeight; col++) {
-        uint32_t *pixel = (uint32_t *)(dataPtr + mStride * col);
-        for (uint32_t row = 0; row < mWidth; row++) {
-            int alpha = vAlpha(*pixel);
-            if (alpha == 0) {
-                pixel++;
-                continue;
-            }
-
-            int red = vRed(*pixel);
-            int green = vGreen(*pixel);
-            int blue = vBlue(*pixel);
-
-            if (alpha != 255) {
-                // un multiply
-                red = (red * 255) / alpha;
-                green = (green * 255) / alpha;
-                blue = (blue * 255) / alpha;
-            }
-            int luminosity = int(0.299f * red + 0.587f * green + 0.114f * blue);
-            *pixel = luminosity << 24;
-            pixel++;
-        }
-    }
-}
-
-VBitmap::VBitmap(size_t width, size_t height, VBitmap::Format format)
+VBitmap::VBitmap(size_t width, size_t height, VBitmap::Format format,
+                 size_t capacity)
 {
     if (width <= 0 || height <= 0 || format == Format::Invalid) return;
 
-    mImpl = rc_ptr<Impl>(width, height, format);
+    mImpl = arc_ptr<Impl>(width, height, format, capacity);
 }
 
 VBitmap::VBitmap(uint8_t *data, size_t width, size_t height,
@@ -119,7 +100,7 @@ VBitmap::VBitmap(uint8_t *data, size_t width, size_t height,
         format == Format::Invalid)
         return;
 
-    mImpl = rc_ptr<Impl>(data, width, height, bytesPerLine, format);
+    mImpl = arc_ptr<Impl>(data, width, height, bytesPerLine, format);
 }
 
 void VBitmap::reset(uint8_t *data, size_t w, size_t h, size_t bytesPerLine,
@@ -128,7 +109,7 @@ void VBitmap::reset(uint8_t *data, size_t w, size_t h, size_t bytesPerLine,
     if (mImpl) {
         mImpl->reset(data, w, h, bytesPerLine, format);
     } else {
-        mImpl = rc_ptr<Impl>(data, w, h, bytesPerLine, format);
+        mImpl = arc_ptr<Impl>(data, w, h, bytesPerLine, format);
     }
 }
 
@@ -141,15 +122,26 @@ void VBitmap::reset(size_t w, size_t h, VBitmap::Format format)
         }
         mImpl->reset(w, h, format);
     } else {
-        mImpl = rc_ptr<Impl>(w, h, format);
+        mImpl = arc_ptr<Impl>(w, h, format, 0);
     }
 }
 
+// bytes per scanline (must be multiple of 4)
+size_t VBitmap::bytesPerLine(size_t width, VBitmap::Format format)
+{
+    return ((width * Impl::depth(format) + 31) >> 5) << 2;
+}
+
 size_t VBitmap::stride() const
 {
     return mImpl ? mImpl->stride() : 0;
 }
 
+size_t VBitmap::capacity() const
+{
+    return mImpl ? mImpl->mCapacity : 0;
+}
+
 size_t VBitmap::width() const
 {
     return mImpl ? mImpl->width() : 0;
@@ -200,20 +192,4 @@ void VBitmap::fill(uint32_t pixel)
     if (mImpl) mImpl->fill(pixel);
 }
 
-/*
- * This is special function which converts
- * RGB value to Luminosity and stores it in
- * the Alpha component of the pixel.
- * After this conversion the bitmap data is no more
- * in RGB space. but the Alpha component contains the
- *  Luminosity value of the pixel in HSL color space.
- * NOTE: this api has its own special usecase
- * make sure you know what you are doing before using
- * this api.
- */
-void VBitmap::updateLuma()
-{
-    if (mImpl) mImpl->updateLuma();
-}
-
 V_END_NAMESPACE
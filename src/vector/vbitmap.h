@@ -38,13 +38,17 @@ public:
     };
 
     VBitmap() = default;
-    VBitmap(size_t w, size_t h, VBitmap::Format format);
+    // capacity reserves the pixel storage for reset() to bigger sizes.
+    VBitmap(size_t w, size_t h, VBitmap::Format format, size_t capacity = 0);
     VBitmap(uint8_t *data, size_t w, size_t h, size_t bytesPerLine,
             VBitmap::Format format);
     void reset(uint8_t *data, size_t w, size_t h, size_t stride,
                VBitmap::Format format);
+    // keeps the storage if the size fits in it, the pixels are undefined.
     void reset(size_t w, size_t h, VBitmap::Format format=Format::ARGB32_Premultiplied);
+    static size_t   bytesPerLine(size_t w, VBitmap::Format format);
     size_t          stride() const;
+    size_t          capacity() const;
     size_t          width() const;
     size_t          height() const;
     size_t          depth() const;
@@ -55,10 +59,13 @@ public:
     VRect           rect() const;
     VSize           size() const;
     void            fill(uint32_t pixel);
-    void    updateLuma();
 private:
     struct Impl {
+        // owned pixels start at a 64 byte boundary for the simd loads.
+        static constexpr size_t    alignment = 64;
         std::unique_ptr<uint8_t[]> mOwnData{nullptr};
+        uint8_t *                  mAlignedData{nullptr};
+        size_t                     mCapacity{0};
         uint8_t *                  mRoData{nullptr};
         uint32_t                   mWidth{0};
         uint32_t                   mHeight{0};
@@ -66,9 +73,10 @@ private:
         uint8_t                    mDepth{0};
         VBitmap::Format mFormat{VBitmap::Format::Invalid};
 
-        explicit Impl(size_t width, size_t height, VBitmap::Format format)
+        explicit Impl(size_t width, size_t height, VBitmap::Format format,
+                      size_t capacity)
         {
-            reset(width, height, format);
+            reset(width, height, format, capacity);
         }
         explicit Impl(uint8_t *data, size_t w, size_t h, size_t bytesPerLine,
                       VBitmap::Format format)
@@ -80,16 +88,15 @@ private:
         size_t  stride() const { return mStride; }
         size_t  width() const { return mWidth; }
         size_t  height() const { return mHeight; }
-        uint8_t *       data() { return mRoData ? mRoData : mOwnData.get(); }
+        uint8_t *       data() { return mRoData ? mRoData : mAlignedData; }
         VBitmap::Format format() const { return mFormat; }
         void reset(uint8_t *, size_t, size_t, size_t, VBitmap::Format);
-        void reset(size_t, size_t, VBitmap::Format);
+        void reset(size_t, size_t, VBitmap::Format, size_t capacity = 0);
         static uint8_t depth(VBitmap::Format format);
         void fill(uint32_t);
-        void updateLuma();
     };
 
-    rc_ptr<Impl> mImpl;
+    arc_ptr<Impl> mImpl;
 };
 
 V_END_NAMESPACE
@@ -21,7 +21,9 @@
  */
 
 #include "vdrawable.h"
+#include <algorithm>
 #include "vdasher.h"
+#include "vprofile.h"
 #include "vraster.h"
 
 VDrawable::VDrawable(VDrawable::Type type)
@@ -61,12 +63,58 @@ void VDrawable::applyDashOp()
     }
 }
 
+/*
+ * The control points of a path enclose it, so their bounding box grown by
+ * the reach of the stroke is a conservative bound of what the path paints.
+ * The dash pattern only removes parts of the outline and is ignored.
+ */
+bool VDrawable::outside(const VRect &clip) const
+{
+    if (clip.empty()) return false;
+
+    const auto &points = mPath.points();
+    if (points.empty()) return false;
+
+    float left = points[0].x(), right = left;
+    float top = points[0].y(), bottom = top;
+    for (const auto &pt : points) {
+        left = std::min(left, pt.x());
+        right = std::max(right, pt.x());
+        top = std::min(top, pt.y());
+        bottom = std::max(bottom, pt.y());
+    }
+
+    // one pixel of antialiasing around the edges.
+    float margin = 1;
+    if (mType != Type::Fill) {
+        // square caps reach sqrt(2) * half width, miter joins miterLimit
+        // times half width.
+        float reach = mStrokeInfo->join == JoinStyle::Miter
+                          ? std::max(mStrokeInfo->miterLimit, 1.5f)
+                          : 1.5f;
+        margin += mStrokeInfo->width / 2 * reach;
+    }
+
+    // written so that a NaN coordinate never culls.
+    return right + margin < float(clip.left()) ||
+           left - margin > float(clip.right()) ||
+           bottom + margin < float(clip.top()) ||
+           top - margin > float(clip.bottom());
+}
+
 void VDrawable::preprocess(const VRect &clip)
 {
     if (mFlag & (DirtyState::Path)) {
-        if (mType == Type::Fill) {
+        mCulled = outside(clip);
+        if (mCulled) {
+            VPROFILE_COUNT(mCulledDrawables, 1);
+            // an empty path leaves an empty rle.
+            mRasterizer.rasterize(VPath(), mFillRule, clip);
+        } else if (mType == Type::Fill) {
+            VPROFILE_COUNT(mDrawables, 1);
             mRasterizer.rasterize(std::move(mPath), mFillRule, clip);
         } else {
+            VPROFILE_COUNT(mDrawables, 1);
             applyDashOp();
             mRasterizer.rasterize(std::move(mPath), mStrokeInfo->cap, mStrokeInfo->join,
                                   mStrokeInfo->width, mStrokeInfo->miterLimit, clip);
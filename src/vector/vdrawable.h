@@ -59,6 +59,9 @@ public:
     void preprocess(const VRect &clip);
     void applyDashOp();
     VRle rle();
+    // true if the path was found to be outside of the clip, its rle is
+    // empty then.
+    bool culled() const { return mCulled; }
     void setName(const char *name)
     {
         mName = name;
@@ -77,6 +80,9 @@ public:
         std::vector<float> mDash;
     };
 
+private:
+    bool outside(const VRect &clip) const;
+
 public:
     VPath                    mPath;
     VBrush                   mBrush;
@@ -86,6 +92,7 @@ public:
     DirtyFlag                mFlag{DirtyState::All};
     FillRule                 mFillRule{FillRule::Winding};
     VDrawable::Type          mType{Type::Fill};
+    bool                     mCulled{false};
 
     const char              *mName{nullptr};
 };
@@ -21,6 +21,7 @@
  */
 
 #include "vdrawhelper.h"
+#include "vmemory.h"
 #include <algorithm>
 #include <climits>
 #include <cstring>
@@ -38,7 +39,7 @@ void VTextureData::setClip(const VRect &clip)
     bottom = std::min(clip.bottom(), int(height())) - 1;
 }
 
-class VGradientCache {
+class VGradientCache : public VMemoryClient {
 public:
     struct CacheInfo : public VColorTable {
         inline CacheInfo(VGradientStops s) : stops(std::move(s)) {}
@@ -56,6 +57,7 @@ public:
         VCacheKey             hash_val = 0;
         VCacheData            info;
         const VGradientStops &stops = gradient.mStops;
+        size_t                entries;
         for (uint32_t i = 0; i < stops.size() && i <= 2; i++)
             hash_val +=
                 VCacheKey(stops[i].second.premulARGB() * gradient.alpha());
@@ -89,10 +91,28 @@ public:
                     info = addCacheElement(hash_val, gradient);
                 }
             }
+            entries = mCache.size();
+        }
+        if (entries > mReported) {
+            mReported = entries;
+            VMemoryBudget::instance().grew();
         }
         return info;
     }
 
+    void usage(VMemoryUsage &usage) const override
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        usage.gradient += mCache.size() * sizeof(CacheInfo);
+    }
+
+    void trim(VTrimLevel) override
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        mCache.clear();
+        mReported = 0;
+    }
+
     static VGradientCache &instance()
     {
         static VGradientCache CACHE;
@@ -118,10 +138,12 @@ protected:
     }
 
 private:
-    VGradientCache() = default;
+    VGradientCache() { VMemoryBudget::instance().add(this); }
+    ~VGradientCache() override { VMemoryBudget::instance().remove(this); }
 
     VGradientColorTableHash mCache;
-    std::mutex              mMutex;
+    mutable std::mutex      mMutex;
+    std::atomic<size_t>     mReported{0};
 };
 
 bool VGradientCache::generateGradientColorTable(const VGradientStops &stops,
@@ -193,7 +215,7 @@ VBitmap::Format VRasterBuffer::prepare(const VBitmap *image)
     mBuffer = image->data();
     mWidth = image->width();
     mHeight = image->height();
-    mBytesPerPixel = 4;
+    mBytesPerPixel = image->depth() / 8;
     mBytesPerLine = image->stride();
 
     mFormat = image->format();
@@ -214,8 +236,6 @@ void VSpanData::init(VRasterBuffer *image)
  *
  */
 
-#define FIXPT_BITS 8
-#define FIXPT_SIZE (1 << FIXPT_BITS)
 static inline void getLinearGradientValues(LinearGradientValues *v,
                                            const VSpanData *     data)
 {
@@ -247,41 +267,40 @@ static inline void getRadialGradientValues(RadialGradientValues *v,
     v->extended = !vIsZero(gradient.radial.fradius) || v->a <= 0;
 }
 
-static inline int gradientClamp(const VGradientData *grad, int ipos)
+static void fetch_linear_fixed(uint32_t *buffer, int length,
+                               const VGradientData *gradient, int t, int inc)
 {
-    int limit;
-
-    if (grad->mSpread == VGradient::Spread::Repeat) {
-        ipos = ipos % VGradient::colorTableSize;
-        ipos = ipos < 0 ? VGradient::colorTableSize + ipos : ipos;
-    } else if (grad->mSpread == VGradient::Spread::Reflect) {
-        limit = VGradient::colorTableSize * 2;
-        ipos = ipos % limit;
-        ipos = ipos < 0 ? limit + ipos : ipos;
-        ipos = ipos >= VGradient::colorTableSize ? limit - 1 - ipos : ipos;
-    } else {
-        if (ipos < 0)
-            ipos = 0;
-        else if (ipos >= VGradient::colorTableSize)
-            ipos = VGradient::colorTableSize - 1;
+    const int last = VGradient::colorTableSize - 1;
+    const int first_pos = (t + (FIXPT_SIZE / 2)) >> FIXPT_BITS;
+    const int last_pos = (t + (length - 1) * inc + (FIXPT_SIZE / 2)) >>
+                         FIXPT_BITS;
+
+    // the span lies entirely before or after a padded gradient.
+    if (gradient->mSpread == VGradient::Spread::Pad) {
+        if (first_pos <= 0 && last_pos <= 0) {
+            memfill32(buffer, gradient->mColorTable[0], length);
+            return;
+        }
+        if (first_pos >= last && last_pos >= last) {
+            memfill32(buffer, gradient->mColorTable[last], length);
+            return;
+        }
     }
-    return ipos;
-}
 
-static uint32_t gradientPixelFixed(const VGradientData *grad, int fixed_pos)
-{
-    int ipos = (fixed_pos + (FIXPT_SIZE / 2)) >> FIXPT_BITS;
-
-    return grad->mColorTable[gradientClamp(grad, ipos)];
-}
-
-static inline uint32_t gradientPixel(const VGradientData *grad, float pos)
-{
-    int ipos = (int)(pos * (VGradient::colorTableSize - 1) + (float)(0.5));
+    // one table entry per pixel, the span is a slice of the table.
+    if (inc == FIXPT_SIZE && first_pos >= 0 && last_pos <= last) {
+        memcpy(buffer, gradient->mColorTable + first_pos,
+               size_t(length) * sizeof(uint32_t));
+        return;
+    }
 
-    return grad->mColorTable[gradientClamp(grad, ipos)];
+    RenderTable.linear()(buffer, length, gradient, t, inc);
 }
 
+/*
+ * The affine case steps from the start of the row in fixed point, so a
+ * pixel gets the same color whatever span it is fetched with.
+ */
 void fetch_linear_gradient(uint32_t *buffer, const Operator *op,
                            const VSpanData *data, int y, int x, int length)
 {
@@ -297,40 +316,45 @@ void fetch_linear_gradient(uint32_t *buffer, const Operator *op,
              data->dx;
         ry = data->m22 * (y + float(0.5)) + data->m12 * (x + float(0.5)) +
              data->dy;
-        t = op->linear.dx * rx + op->linear.dy * ry + op->linear.off;
         inc = op->linear.dx * data->m11 + op->linear.dy * data->m12;
         affine = !data->m13 && !data->m23;
 
         if (affine) {
+            // position at the first pixel of the row.
+            float rx0 = data->m21 * (y + float(0.5)) +
+                        data->m11 * float(0.5) + data->dx;
+            float ry0 = data->m22 * (y + float(0.5)) +
+                        data->m12 * float(0.5) + data->dy;
+            t = op->linear.dx * rx0 + op->linear.dy * ry0 + op->linear.off;
             t *= (VGradient::colorTableSize - 1);
             inc *= (VGradient::colorTableSize - 1);
+        } else {
+            t = op->linear.dx * rx + op->linear.dy * ry + op->linear.off;
         }
     }
 
     const uint32_t *end = buffer + length;
     if (affine) {
-        if (inc > float(-1e-5) && inc < float(1e-5)) {
-            memfill32(buffer, gradientPixelFixed(gradient, int(t * FIXPT_SIZE)),
-                      length);
-        } else {
-            if (t + inc * length < float(INT_MAX >> (FIXPT_BITS + 1)) &&
-                t + inc * length > float(INT_MIN >> (FIXPT_BITS + 1))) {
-                // we can use fixed point math
-                int t_fixed = int(t * FIXPT_SIZE);
-                int inc_fixed = int(inc * FIXPT_SIZE);
-                while (buffer < end) {
-                    *buffer = gradientPixelFixed(gradient, t_fixed);
-                    t_fixed += inc_fixed;
-                    ++buffer;
-                }
+        float t_end = t + inc * float(x + length);
+        if (t < float(INT_MAX >> (FIXPT_BITS + 1)) &&
+            t > float(INT_MIN >> (FIXPT_BITS + 1)) &&
+            t_end < float(INT_MAX >> (FIXPT_BITS + 1)) &&
+            t_end > float(INT_MIN >> (FIXPT_BITS + 1))) {
+            // we can use fixed point math
+            int inc_fixed = int(inc * FIXPT_SIZE);
+            int t_fixed = int(t * FIXPT_SIZE) + x * inc_fixed;
+            if (inc_fixed == 0) {
+                memfill32(buffer, gradientPixelFixed(gradient, t_fixed),
+                          length);
             } else {
-                // we have to fall back to float math
-                while (buffer < end) {
-                    *buffer =
-                        gradientPixel(gradient, t / VGradient::colorTableSize);
-                    t += inc;
-                    ++buffer;
-                }
+                fetch_linear_fixed(buffer, length, gradient, t_fixed,
+                                   inc_fixed);
+            }
+        } else {
+            // we have to fall back to float math
+            for (int i = x; buffer < end; ++i, ++buffer) {
+                *buffer = gradientPixel(gradient, (t + inc * float(i)) /
+                                                      VGradient::colorTableSize);
             }
         }
     } else {  // fall back to float math here as well
@@ -358,38 +382,6 @@ static inline float radialDeterminant(float a, float b, float c)
     return (b * b) - (4 * a * c);
 }
 
-static void fetch(uint32_t *buffer, uint32_t *end, const Operator *op,
-                  const VSpanData *data, float det, float delta_det,
-                  float delta_delta_det, float b, float delta_b)
-{
-    if (op->radial.extended) {
-        while (buffer < end) {
-            uint32_t result = 0;
-            if (det >= 0) {
-                float w = std::sqrt(det) - b;
-                if (data->mGradient.radial.fradius + op->radial.dr * w >= 0)
-                    result = gradientPixel(&data->mGradient, w);
-            }
-
-            *buffer = result;
-
-            det += delta_det;
-            delta_det += delta_delta_det;
-            b += delta_b;
-
-            ++buffer;
-        }
-    } else {
-        while (buffer < end) {
-            *buffer++ = gradientPixel(&data->mGradient, std::sqrt(det) - b);
-
-            det += delta_det;
-            delta_det += delta_delta_det;
-            b += delta_b;
-        }
-    }
-}
-
 void fetch_radial_gradient(uint32_t *buffer, const Operator *op,
                            const VSpanData *data, int y, int x, int length)
 {
@@ -443,8 +435,8 @@ void fetch_radial_gradient(uint32_t *buffer, const Operator *op,
         const float delta_delta_det =
             (delta_b_delta_b + 4 * op->radial.a * delta_rx_plus_ry) * inv_a;
 
-        fetch(buffer, end, op, data, det, delta_det, delta_delta_det, b,
-              delta_b);
+        RenderTable.radial()(buffer, length, &data->mGradient, &op->radial,
+                             det, delta_det, delta_delta_det, b, delta_b);
     } else {
         float rw = data->m23 * (y + float(0.5)) + data->m33 +
                    data->m13 * (x + float(0.5));
@@ -520,6 +512,123 @@ static inline Operator getOperator(const VSpanData *data)
     return op;
 }
 
+/*
+ * Alpha8 targets only keep the coverage. They follow the alpha channel of
+ * the ARGB32 functions step by step, so a matte rendered into an Alpha8
+ * buffer masks exactly like one rendered into an ARGB32 buffer.
+ */
+static inline uint32_t alpha8_mul(uint32_t a, uint32_t b)
+{
+    return (a * b) >> 8;
+}
+
+static void color8_Source(uint8_t *dest, int length, uint32_t color,
+                          uint32_t alpha)
+{
+    uint32_t a = vAlpha(color);
+    if (alpha == 255) {
+        memset(dest, int(a), size_t(length));
+    } else {
+        uint32_t ialpha = 255 - alpha;
+        a = alpha8_mul(a, alpha);
+        for (int i = 0; i < length; ++i)
+            dest[i] = uint8_t(a + alpha8_mul(dest[i], ialpha));
+    }
+}
+
+static void color8_SourceOver(uint8_t *dest, int length, uint32_t color,
+                              uint32_t alpha)
+{
+    uint32_t a = vAlpha(color);
+    if (alpha != 255) a = alpha8_mul(a, alpha);
+    uint32_t ialpha = 255 - a;
+    for (int i = 0; i < length; ++i)
+        dest[i] = uint8_t(a + alpha8_mul(dest[i], ialpha));
+}
+
+static void color8_DestinationIn(uint8_t *dest, int length, uint32_t color,
+                                 uint32_t alpha)
+{
+    uint32_t a = vAlpha(color);
+    if (alpha != 255) a = alpha8_mul(a, alpha) + 255 - alpha;
+    for (int i = 0; i < length; ++i) dest[i] = uint8_t(alpha8_mul(dest[i], a));
+}
+
+static void color8_DestinationOut(uint8_t *dest, int length, uint32_t color,
+                                  uint32_t alpha)
+{
+    color8_DestinationIn(dest, length, ~color, alpha);
+}
+
+static void src8_Source(uint8_t *dest, int length, const uint32_t *src,
+                        uint32_t alpha)
+{
+    if (alpha == 255) {
+        for (int i = 0; i < length; ++i) dest[i] = uint8_t(vAlpha(src[i]));
+    } else {
+        uint32_t ialpha = 255 - alpha;
+        for (int i = 0; i < length; ++i)
+            dest[i] = uint8_t((vAlpha(src[i]) * alpha + dest[i] * ialpha) >> 8);
+    }
+}
+
+static void src8_SourceOver(uint8_t *dest, int length, const uint32_t *src,
+                            uint32_t alpha)
+{
+    for (int i = 0; i < length; ++i) {
+        uint32_t a = vAlpha(src[i]);
+        if (alpha != 255) a = alpha8_mul(a, alpha);
+        // premultiplied, a transparent pixel leaves dest as is.
+        if (a == 0) continue;
+        dest[i] = uint8_t(a + alpha8_mul(dest[i], 255 - a));
+    }
+}
+
+static void src8_DestinationIn(uint8_t *dest, int length, const uint32_t *src,
+                               uint32_t alpha)
+{
+    for (int i = 0; i < length; ++i) {
+        uint32_t a = vAlpha(src[i]);
+        if (alpha != 255) a = alpha8_mul(a, alpha) + 255 - alpha;
+        dest[i] = uint8_t(alpha8_mul(dest[i], a));
+    }
+}
+
+static void src8_DestinationOut(uint8_t *dest, int length, const uint32_t *src,
+                                uint32_t alpha)
+{
+    for (int i = 0; i < length; ++i) {
+        uint32_t a = vAlpha(~src[i]);
+        if (alpha != 255) a = alpha8_mul(a, alpha) + 255 - alpha;
+        dest[i] = uint8_t(alpha8_mul(dest[i], a));
+    }
+}
+
+struct Alpha8Func {
+    void (*color)(uint8_t *dest, int length, uint32_t color, uint32_t alpha);
+    void (*src)(uint8_t *dest, int length, const uint32_t *src,
+                uint32_t alpha);
+};
+
+static Alpha8Func alpha8Func(BlendMode mode)
+{
+    switch (mode) {
+    case BlendMode::Src:
+        return {color8_Source, src8_Source};
+    case BlendMode::DestIn:
+        return {color8_DestinationIn, src8_DestinationIn};
+    case BlendMode::DestOut:
+        return {color8_DestinationOut, src8_DestinationOut};
+    default:
+        return {color8_SourceOver, src8_SourceOver};
+    }
+}
+
+static inline uint8_t *alpha8Buffer(const VSpanData *data, int x, int y)
+{
+    return reinterpret_cast<uint8_t *>(data->buffer(x, y));
+}
+
 static void blend_color(size_t size, const VRle::Span *array, void *userData)
 {
     VSpanData *data = (VSpanData *)(userData);
@@ -532,6 +641,19 @@ static void blend_color(size_t size, const VRle::Span *array, void *userData)
     }
 }
 
+static void blend_color_alpha8(size_t size, const VRle::Span *array,
+                               void *userData)
+{
+    VSpanData *data = (VSpanData *)(userData);
+    auto       func = alpha8Func(getOperator(data).mode).color;
+
+    for (size_t i = 0; i < size; ++i) {
+        const auto &span = array[i];
+        func(alpha8Buffer(data, span.x, span.y), span.len, data->mSolid,
+             span.coverage);
+    }
+}
+
 // Signature of Process Object
 //  void Pocess(uint* scratchBuffer, size_t x, size_t y, uint8_t cov)
 template <class Process>
@@ -552,13 +674,57 @@ static inline void process_in_chunk(const VRle::Span *array, size_t size,
     }
 }
 
+/*
+ * A linear gradient that only changes along x has the same colors on every
+ * row. The colors under all the spans are fetched once as one row and each
+ * span is blended from its slice of it. Returns false if the gradient
+ * changes along y or the spans are too far apart.
+ */
+template <class Process>
+static inline bool process_in_row(const VRle::Span *array, size_t size,
+                                  const Operator &op, const VSpanData *data,
+                                  Process process)
+{
+    if (data->mType != VSpanData::Type::LinearGradient || data->m13 ||
+        data->m23)
+        return false;
+    // t doesn't depend on y only when both y terms are exactly 0.
+    if ((op.linear.dx != 0 && data->m21 != 0) ||
+        (op.linear.dy != 0 && data->m22 != 0))
+        return false;
+
+    int left = INT_MAX, right = INT_MIN;
+    for (size_t i = 0; i < size; i++) {
+        left = std::min(left, int(array[i].x));
+        right = std::max(right, array[i].x + int(array[i].len));
+    }
+
+    std::array<uint32_t, 2048> row;
+    if (right - left > int(row.size())) return false;
+
+    op.srcFetch(row.data(), &op, data, array[0].y, left, right - left);
+    for (size_t i = 0; i < size; i++) {
+        const auto &span = array[i];
+        process(row.data() + (span.x - left), span.x, span.y, span.len,
+                span.coverage);
+    }
+    return true;
+}
+
 static void blend_gradient(size_t size, const VRle::Span *array,
                            void *userData)
 {
     VSpanData *data = (VSpanData *)(userData);
     Operator   op = getOperator(data);
 
-    if (!op.srcFetch) return;
+    if (!op.srcFetch || !size) return;
+
+    if (process_in_row(array, size, op, data,
+                       [&](const uint32_t *src, int x, int y, int len,
+                           uint8_t cov) {
+                           op.func(data->buffer(x, y), len, src, cov);
+                       }))
+        return;
 
     process_in_chunk(
         array, size,
@@ -568,6 +734,30 @@ static void blend_gradient(size_t size, const VRle::Span *array,
         });
 }
 
+static void blend_gradient_alpha8(size_t size, const VRle::Span *array,
+                                  void *userData)
+{
+    VSpanData *data = (VSpanData *)(userData);
+    Operator   op = getOperator(data);
+    auto       func = alpha8Func(op.mode).src;
+
+    if (!op.srcFetch || !size) return;
+
+    if (process_in_row(array, size, op, data,
+                       [&](const uint32_t *src, int x, int y, int len,
+                           uint8_t cov) {
+                           func(alpha8Buffer(data, x, y), len, src, cov);
+                       }))
+        return;
+
+    process_in_chunk(
+        array, size,
+        [&](uint32_t *scratch, size_t x, size_t y, size_t len, uint8_t cov) {
+            op.srcFetch(scratch, &op, data, (int)y, (int)x, (int)len);
+            func(alpha8Buffer(data, (int)x, (int)y), (int)len, scratch, cov);
+        });
+}
+
 template <class T>
 constexpr const T &clamp(const T &v, const T &lo, const T &hi)
 {
@@ -579,73 +769,172 @@ static constexpr inline uint8_t alpha_mul(uint8_t a, uint8_t b)
     return ((a * b) >> 8);
 }
 
+static bool argbTexture(const VTextureData &src)
+{
+    //@TODO other formats not yet handled.
+    return src.format() == VBitmap::Format::ARGB32_Premultiplied ||
+           src.format() == VBitmap::Format::ARGB32;
+}
+
+// nearest texture pixels of a transformed span.
+static inline void fetch_image_xform(uint32_t *buffer, const VSpanData *data,
+                                     size_t x, size_t y, size_t length)
+{
+    const auto &src = data->texture();
+    const float xfactor = y * data->m21 + data->dx + data->m11;
+    const float yfactor = y * data->m22 + data->dy + data->m12;
+    for (size_t i = 0; i < length; i++) {
+        const float fx = (x + i) * data->m11 + xfactor;
+        const float fy = (x + i) * data->m12 + yfactor;
+        const int   px = clamp(int(fx), src.left, src.right);
+        const int   py = clamp(int(fy), src.top, src.bottom);
+        buffer[i] = src.pixel(px, py);
+    }
+}
+
 static void blend_image_xform(size_t size, const VRle::Span *array,
                               void *userData)
 {
     const auto  data = reinterpret_cast<const VSpanData *>(userData);
     const auto &src = data->texture();
 
-    if (src.format() != VBitmap::Format::ARGB32_Premultiplied &&
-        src.format() != VBitmap::Format::ARGB32) {
-        //@TODO other formats not yet handled.
-        return;
-    }
+    if (!argbTexture(src)) return;
 
     Operator op = getOperator(data);
 
     process_in_chunk(
         array, size,
         [&](uint32_t *scratch, size_t x, size_t y, size_t len, uint8_t cov) {
-            const auto  coverage = (cov * src.alpha()) >> 8;
-            const float xfactor = y * data->m21 + data->dx + data->m11;
-            const float yfactor = y * data->m22 + data->dy + data->m12;
-            for (size_t i = 0; i < len; i++) {
-                const float fx = (x + i) * data->m11 + xfactor;
-                const float fy = (x + i) * data->m12 + yfactor;
-                const int   px = clamp(int(fx), src.left, src.right);
-                const int   py = clamp(int(fy), src.top, src.bottom);
-                scratch[i] = src.pixel(px, py);
-            }
+            const auto coverage = (cov * src.alpha()) >> 8;
+            fetch_image_xform(scratch, data, x, y, len);
             op.func(data->buffer((int)x, (int)y), (int)len, scratch, coverage);
         });
 }
 
+static void blend_image_xform_alpha8(size_t size, const VRle::Span *array,
+                                     void *userData)
+{
+    const auto  data = reinterpret_cast<const VSpanData *>(userData);
+    const auto &src = data->texture();
+
+    if (!argbTexture(src)) return;
+
+    auto func = alpha8Func(getOperator(data).mode).src;
+
+    process_in_chunk(
+        array, size,
+        [&](uint32_t *scratch, size_t x, size_t y, size_t len, uint8_t cov) {
+            const auto coverage = (cov * src.alpha()) >> 8;
+            fetch_image_xform(scratch, data, x, y, len);
+            func(alpha8Buffer(data, (int)x, (int)y), (int)len, scratch,
+                 coverage);
+        });
+}
+
+/*
+ * An Alpha8 texture only masks the ARGB32 target, the alpha of each pixel
+ * is taken like the one of an ARGB32 texture by src_DestinationIn() and
+ * src_DestinationOut().
+ */
+static void mask_DestinationIn(uint32_t *dest, int length, const uint8_t *mask,
+                               uint32_t alpha)
+{
+    if (alpha == 255) {
+        for (int i = 0; i < length; ++i) dest[i] = BYTE_MUL(dest[i], mask[i]);
+    } else {
+        uint32_t cia = 255 - alpha;
+        for (int i = 0; i < length; ++i)
+            dest[i] = BYTE_MUL(dest[i], alpha8_mul(mask[i], alpha) + cia);
+    }
+}
+
+static void mask_DestinationOut(uint32_t *dest, int length, const uint8_t *mask,
+                                uint32_t alpha)
+{
+    uint32_t cia = 255 - alpha;
+    for (int i = 0; i < length; ++i) {
+        uint32_t a = 255 - mask[i];
+        if (alpha != 255) a = alpha8_mul(a, alpha) + cia;
+        dest[i] = BYTE_MUL(dest[i], a);
+    }
+}
+
+// visible part of a span of an untransformed texture, false if none.
+static inline bool imageSpan(const VSpanData *data, const VRle::Span &span,
+                             int &x, int &length, int &sx, int &sy)
+{
+    const auto &src = data->texture();
+    x = span.x;
+    length = span.len;
+    sx = x + int(data->dx);
+    sy = span.y + int(data->dy);
+
+    // notyhing to copy.
+    if (sy < 0 || sy >= int(src.height()) || sx >= int(src.width()) ||
+        (sx + length) <= 0)
+        return false;
+
+    // intersecting left edge of image
+    if (sx < 0) {
+        x -= sx;
+        length += sx;
+        sx = 0;
+    }
+    // intersecting right edge of image
+    if (sx + length > int(src.width())) length = (int)src.width() - sx;
+    return true;
+}
+
+static void blend_image_alpha8(size_t size, const VRle::Span *array,
+                               void *userData)
+{
+    const auto  data = reinterpret_cast<const VSpanData *>(userData);
+    const auto &src = data->texture();
+
+    if (!argbTexture(src)) return;
+
+    auto func = alpha8Func(getOperator(data).mode).src;
+
+    int x, length, sx, sy;
+    for (size_t i = 0; i < size; i++) {
+        if (!imageSpan(data, array[i], x, length, sx, sy)) continue;
+        func(alpha8Buffer(data, x, array[i].y), length, src.pixelRef(sx, sy),
+             alpha_mul(array[i].coverage, src.alpha()));
+    }
+}
+
 static void blend_image(size_t size, const VRle::Span *array, void *userData)
 {
     const auto  data = reinterpret_cast<const VSpanData *>(userData);
     const auto &src = data->texture();
 
-    if (src.format() != VBitmap::Format::ARGB32_Premultiplied &&
-        src.format() != VBitmap::Format::ARGB32) {
-        //@TODO other formats not yet handled.
+    if (src.format() == VBitmap::Format::Alpha8) {
+        //@TODO an Alpha8 texture can only mask.
+        if (data->mBlendMode != BlendMode::DestIn &&
+            data->mBlendMode != BlendMode::DestOut)
+            return;
+        auto func = data->mBlendMode == BlendMode::DestIn ? mask_DestinationIn
+                                                          : mask_DestinationOut;
+
+        int x, length, sx, sy;
+        for (size_t i = 0; i < size; i++) {
+            if (!imageSpan(data, array[i], x, length, sx, sy)) continue;
+            func(data->buffer(x, array[i].y), length,
+                 reinterpret_cast<const uint8_t *>(src.pixelRef(sx, sy)),
+                 alpha_mul(array[i].coverage, src.alpha()));
+        }
         return;
     }
 
+    if (!argbTexture(src)) return;
+
     Operator op = getOperator(data);
 
+    int x, length, sx, sy;
     for (size_t i = 0; i < size; i++) {
-        const auto &span = array[i];
-        int         x = span.x;
-        int         length = span.len;
-        int         sx = x + int(data->dx);
-        int         sy = span.y + int(data->dy);
-
-        // notyhing to copy.
-        if (sy < 0 || sy >= int(src.height()) || sx >= int(src.width()) ||
-            (sx + length) <= 0)
-            continue;
-
-        // intersecting left edge of image
-        if (sx < 0) {
-            x -= sx;
-            length += sx;
-            sx = 0;
-        }
-        // intersecting right edge of image
-        if (sx + length > int(src.width())) length = (int)src.width() - sx;
-
-        op.func(data->buffer(x, span.y), length, src.pixelRef(sx, sy),
-                alpha_mul(span.coverage, src.alpha()));
+        if (!imageSpan(data, array[i], x, length, sx, sy)) continue;
+        op.func(data->buffer(x, array[i].y), length, src.pixelRef(sx, sy),
+                alpha_mul(array[i].coverage, src.alpha()));
     }
 }
 
@@ -735,6 +1024,12 @@ void VSpanData::initTexture(const VBitmap *bitmap, int alpha,
 
 void VSpanData::updateSpanFunc()
 {
+    if (mRasterBuffer &&
+        mRasterBuffer->format() == VBitmap::Format::Alpha8) {
+        updateAlpha8SpanFunc();
+        return;
+    }
+
     switch (mType) {
     case VSpanData::Type::None:
         mUnclippedBlendFunc = nullptr;
@@ -759,13 +1054,26 @@ void VSpanData::updateSpanFunc()
     }
 }
 
-#if !defined(__SSE2__) && !defined(__ARM_NEON__)
-void memfill32(uint32_t *dest, uint32_t value, int length)
+
+void VSpanData::updateAlpha8SpanFunc()
 {
-    // let compiler do the auto vectorization.
-    for (int i = 0 ; i < length; i++) {
-        *dest++ = value;
+    switch (mType) {
+    case VSpanData::Type::None:
+        mUnclippedBlendFunc = nullptr;
+        break;
+    case VSpanData::Type::Solid:
+        mUnclippedBlendFunc = &blend_color_alpha8;
+        break;
+    case VSpanData::Type::LinearGradient:
+    case VSpanData::Type::RadialGradient:
+        mUnclippedBlendFunc = &blend_gradient_alpha8;
+        break;
+    case VSpanData::Type::Texture:
+        if (transformType <= VMatrix::MatrixType::Translate) {
+            mUnclippedBlendFunc = &blend_image_alpha8;
+        } else {
+            mUnclippedBlendFunc = &blend_image_xform_alpha8;
+        }
+        break;
     }
 }
-#endif
-
@@ -23,6 +23,7 @@
 #ifndef VDRAWHELPER_H
 #define VDRAWHELPER_H
 
+#include <cmath>
 #include <memory>
 #include <array>
 #include "assert.h"
@@ -56,10 +57,47 @@ struct RenderFunc
     };
 };
 
+struct VGradientData;
+struct RadialGradientValues;
+
+struct GradientFunc
+{
+    // colors at the fixed point positions t + i * inc
+    using Linear = void (*)(uint32_t *buffer, int length,
+                            const VGradientData *gradient, int t, int inc);
+    // colors of an affine radial gradient, det and b advance per pixel
+    using Radial = void (*)(uint32_t *buffer, int length,
+                            const VGradientData *       gradient,
+                            const RadialGradientValues *v, float det,
+                            float delta_det, float delta_delta_det, float b,
+                            float delta_b);
+};
+
+/*
+ * Instruction sets the blend functions have specializations for. SSE2 and
+ * NEON are fixed at compile time, AVX2 is detected at runtime so the same
+ * x86 binary still runs on cpus without it.
+ */
+#if defined(__SSE2__) && defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define VDRAWHELPER_AVX2
+#endif
+
+struct CpuFeature {
+    enum : uint32_t {
+        SSE2 = 1 << 0,
+        NEON = 1 << 1,
+        AVX2 = 1 << 2,
+    };
+};
+
+uint32_t vCpuFeatures();
+
 class RenderFuncTable
 {
 public:
-    RenderFuncTable();
+    // features must be a subset of vCpuFeatures()
+    explicit RenderFuncTable(uint32_t features = vCpuFeatures());
     RenderFunc::Color color(BlendMode mode) const
     {
         return colorTable[uint32_t(mode)].color_;
@@ -68,9 +106,12 @@ public:
     {
         return srcTable[uint32_t(mode)].src_;
     }
+    GradientFunc::Linear linear() const { return linearFunc; }
+    GradientFunc::Radial radial() const { return radialFunc; }
 private:
     void neon();
     void sse();
+    void avx2();
     void updateColor(BlendMode mode, RenderFunc::Color f)
     {
         colorTable[uint32_t(mode)] = {RenderFunc::Type::Color, f};
@@ -79,9 +120,17 @@ private:
     {
         srcTable[uint32_t(mode)] = {RenderFunc::Type::Src, f};
     }
+    void updateGradient(GradientFunc::Linear linear,
+                        GradientFunc::Radial radial)
+    {
+        if (linear) linearFunc = linear;
+        if (radial) radialFunc = radial;
+    }
 private:
     std::array<RenderFunc, uint32_t(BlendMode::Last)> colorTable;
     std::array<RenderFunc, uint32_t(BlendMode::Last)> srcTable;
+    GradientFunc::Linear                              linearFunc{nullptr};
+    GradientFunc::Radial                              radialFunc{nullptr};
 };
 
 typedef void (*SourceFetchProc)(uint32_t *buffer, const Operator *o,
@@ -91,6 +140,9 @@ typedef void (*ProcessRleSpan)(size_t count, const VRle::Span *spans,
                                void *userData);
 
 extern void memfill32(uint32_t *dest, uint32_t value, int count);
+#if defined(VDRAWHELPER_AVX2)
+extern void memfill32_avx2(uint32_t *dest, uint32_t value, int count);
+#endif
 
 struct LinearGradientValues {
     float dx;
@@ -169,6 +221,96 @@ struct VGradientData {
     bool            mColorTableAlpha;
 };
 
+#define FIXPT_BITS 8
+#define FIXPT_SIZE (1 << FIXPT_BITS)
+
+// the simd fetchers wrap positions into the table with a mask.
+static_assert((VGradient::colorTableSize & (VGradient::colorTableSize - 1)) ==
+                  0,
+              "color table size must be a power of two");
+
+static inline int gradientClamp(const VGradientData *grad, int ipos)
+{
+    int limit;
+
+    if (grad->mSpread == VGradient::Spread::Repeat) {
+        ipos = ipos % VGradient::colorTableSize;
+        ipos = ipos < 0 ? VGradient::colorTableSize + ipos : ipos;
+    } else if (grad->mSpread == VGradient::Spread::Reflect) {
+        limit = VGradient::colorTableSize * 2;
+        ipos = ipos % limit;
+        ipos = ipos < 0 ? limit + ipos : ipos;
+        ipos = ipos >= VGradient::colorTableSize ? limit - 1 - ipos : ipos;
+    } else {
+        if (ipos < 0)
+            ipos = 0;
+        else if (ipos >= VGradient::colorTableSize)
+            ipos = VGradient::colorTableSize - 1;
+    }
+    return ipos;
+}
+
+static inline uint32_t gradientPixelFixed(const VGradientData *grad,
+                                          int                  fixed_pos)
+{
+    int ipos = (fixed_pos + (FIXPT_SIZE / 2)) >> FIXPT_BITS;
+
+    return grad->mColorTable[gradientClamp(grad, ipos)];
+}
+
+static inline uint32_t gradientPixel(const VGradientData *grad, float pos)
+{
+    int ipos = (int)(pos * (VGradient::colorTableSize - 1) + (float)(0.5));
+
+    return grad->mColorTable[gradientClamp(grad, ipos)];
+}
+
+/*
+ * The scalar gradient span fetchers, the simd versions finish their spans
+ * with them.
+ */
+static inline void linearGradientSpan(uint32_t *buffer, int length,
+                                      const VGradientData *gradient, int t,
+                                      int inc)
+{
+    for (int i = 0; i < length; ++i) {
+        buffer[i] = gradientPixelFixed(gradient, t);
+        t += inc;
+    }
+}
+
+static inline void radialGradientSpan(uint32_t *buffer, int length,
+                                      const VGradientData *       gradient,
+                                      const RadialGradientValues *v, float det,
+                                      float delta_det, float delta_delta_det,
+                                      float b, float delta_b)
+{
+    if (v->extended) {
+        for (int i = 0; i < length; ++i) {
+            uint32_t result = 0;
+            if (det >= 0) {
+                float w = std::sqrt(det) - b;
+                if (gradient->radial.fradius + v->dr * w >= 0)
+                    result = gradientPixel(gradient, w);
+            }
+
+            buffer[i] = result;
+
+            det += delta_det;
+            delta_det += delta_delta_det;
+            b += delta_b;
+        }
+    } else {
+        for (int i = 0; i < length; ++i) {
+            buffer[i] = gradientPixel(gradient, std::sqrt(det) - b);
+
+            det += delta_det;
+            delta_det += delta_delta_det;
+            b += delta_b;
+        }
+    }
+}
+
 struct VTextureData : public VRasterBuffer {
     uint32_t pixel(int x, int y) const { return *pixelRef(x, y); };
     uint8_t  alpha() const { return mAlpha; }
@@ -192,20 +334,27 @@ struct VSpanData {
     enum class Type { None, Solid, LinearGradient, RadialGradient, Texture };
 
     void updateSpanFunc();
+    void updateAlpha8SpanFunc();
     void init(VRasterBuffer *image);
     void setup(const VBrush &brush, BlendMode mode = BlendMode::SrcOver,
                int alpha = 255);
     void setupMatrix(const VMatrix &matrix);
 
-    VRect clipRect() const
-    {
-        return VRect(0, 0, mDrawableSize.width(), mDrawableSize.height());
-    }
+    VRect clipRect() const { return VRect(mOrigin, mDrawableSize); }
 
     void setDrawRegion(const VRect &region)
     {
         mOffset = VPoint(region.left(), region.top());
         mDrawableSize = VSize(region.width(), region.height());
+        mOrigin = VPoint();
+    }
+
+    // moves the draw region to origin in span coordinates.
+    void setOrigin(const VPoint &origin)
+    {
+        mOffset = VPoint(mOffset.x() + mOrigin.x() - origin.x(),
+                         mOffset.y() + mOrigin.y() - origin.y());
+        mOrigin = origin;
     }
 
     uint32_t *buffer(int x, int y) const
@@ -216,13 +365,14 @@ struct VSpanData {
     const VTextureData &texture() const { return mTexture; }
 
     BlendMode                          mBlendMode{BlendMode::SrcOver};
-    VRasterBuffer *                    mRasterBuffer;
+    VRasterBuffer *                    mRasterBuffer{nullptr};
     ProcessRleSpan                     mBlendFunc;
     ProcessRleSpan                     mUnclippedBlendFunc;
     VSpanData::Type                    mType;
     std::shared_ptr<const VColorTable> mColorTable{nullptr};
     VPoint                             mOffset;  // offset to the subsurface
     VSize                              mDrawableSize;  // suburface size
+    VPoint                             mOrigin;  // span coordinate of the subsurface
     uint32_t                           mSolid;
     VGradientData                      mGradient;
     VTextureData                       mTexture;
@@ -256,6 +406,34 @@ inline constexpr int vAlpha(uint32_t c)
     return c >> 24;
 }
 
+/*
+ * Luminance of the unpremultiplied color, the alpha a luma matte masks
+ * with. The simd versions divide in float, which gives the same quotient
+ * as the integer division for 8 bit channels, and weight in the same
+ * order.
+ */
+constexpr float vLumaRed = 0.299f;
+constexpr float vLumaGreen = 0.587f;
+constexpr float vLumaBlue = 0.114f;
+
+inline uint32_t vLuma(uint32_t c)
+{
+    int alpha = vAlpha(c);
+    if (alpha == 0) return 0;
+
+    int red = vRed(c);
+    int green = vGreen(c);
+    int blue = vBlue(c);
+    if (alpha != 255) {
+        // un multiply
+        red = (red * 255) / alpha;
+        green = (green * 255) / alpha;
+        blue = (blue * 255) / alpha;
+    }
+    float luma = vLumaRed * red + vLumaGreen * green + vLumaBlue * blue;
+    return uint32_t(luma < 255 ? luma : 255);
+}
+
 static inline uint32_t interpolate_pixel(uint32_t x, uint32_t a, uint32_t y,
                                          uint32_t b)
 {
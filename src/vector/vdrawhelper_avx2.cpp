@@ -0,0 +1,515 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "vdrawhelper.h"
+
+#if defined(VDRAWHELPER_AVX2)
+
+#include <cstring>
+#include <immintrin.h>
+
+/*
+ * The library is built for the baseline instruction set, so the avx2 code
+ * is enabled per function and only reached after RenderFuncTable or
+ * memfill32 saw it in vCpuFeatures(). All kernels give the same result as
+ * their scalar versions.
+ */
+#define V_TARGET_AVX2 __attribute__((target("avx2")))
+
+// Each 32bits components of a must be in the form 0x00AA00AA
+V_TARGET_AVX2 static inline __m256i v8_byte_mul_avx2(__m256i c, __m256i a)
+{
+    const __m256i rb_mask = _mm256_set1_epi32(0x00FF00FF);
+
+    /* for AG */
+    __m256i v_ag = _mm256_srli_epi16(c, 8);
+    v_ag = _mm256_mullo_epi16(v_ag, a);
+    v_ag = _mm256_andnot_si256(rb_mask, v_ag);
+
+    /* for RB */
+    __m256i v_rb = _mm256_and_si256(c, rb_mask);
+    v_rb = _mm256_mullo_epi16(v_rb, a);
+    v_rb = _mm256_srli_epi16(v_rb, 8);
+
+    /* combine */
+    return _mm256_or_si256(v_ag, v_rb);
+}
+
+// x * a + y * b, a + b must not exceed 255
+V_TARGET_AVX2 static inline __m256i v8_interpolate_avx2(__m256i x, __m256i a,
+                                                       __m256i y, __m256i b)
+{
+    const __m256i rb_mask = _mm256_set1_epi32(0x00FF00FF);
+
+    __m256i v_ag = _mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_srli_epi16(x, 8), a),
+        _mm256_mullo_epi16(_mm256_srli_epi16(y, 8), b));
+    v_ag = _mm256_andnot_si256(rb_mask, v_ag);
+
+    __m256i v_rb = _mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_and_si256(x, rb_mask), a),
+        _mm256_mullo_epi16(_mm256_and_si256(y, rb_mask), b));
+    v_rb = _mm256_srli_epi16(v_rb, 8);
+
+    return _mm256_or_si256(v_ag, v_rb);
+}
+
+// alpha of each pixel in the form 0x00AA00AA
+V_TARGET_AVX2 static inline __m256i v8_alpha_avx2(__m256i c)
+{
+    const __m256i shuffle =
+        _mm256_setr_epi8(3, -1, 3, -1, 7, -1, 7, -1, 11, -1, 11, -1, 15, -1,
+                         15, -1, 3, -1, 3, -1, 7, -1, 7, -1, 11, -1, 11, -1,
+                         15, -1, 15, -1);
+    return _mm256_shuffle_epi8(c, shuffle);
+}
+
+// BYTE_MUL(alpha(c), const_alpha) + 255 - const_alpha in the form 0x00AA00AA
+V_TARGET_AVX2 static inline __m256i v8_dest_alpha_avx2(__m256i c,
+                                                      __m256i const_alpha,
+                                                      __m256i cia)
+{
+    __m256i a = _mm256_srli_epi32(c, 24);
+    a = _mm256_srli_epi32(_mm256_mullo_epi16(a, const_alpha), 8);
+    a = _mm256_add_epi32(a, cia);
+    return _mm256_or_si256(a, _mm256_slli_epi32(a, 16));
+}
+
+V_TARGET_AVX2 void memfill32_avx2(uint32_t *dest, uint32_t value, int length)
+{
+    const __m256i v_value = _mm256_set1_epi32(value);
+
+    // run till memory alligned to 32byte memory
+    while (length && ((uintptr_t)dest & 0x1f)) {
+        *dest++ = value;
+        length--;
+    }
+
+    while (length >= 32) {
+        _mm256_store_si256((__m256i *)(dest), v_value);
+        _mm256_store_si256((__m256i *)(dest + 8), v_value);
+        _mm256_store_si256((__m256i *)(dest + 16), v_value);
+        _mm256_store_si256((__m256i *)(dest + 24), v_value);
+
+        dest += 32;
+        length -= 32;
+    }
+
+    while (length >= 8) {
+        _mm256_store_si256((__m256i *)(dest), v_value);
+
+        dest += 8;
+        length -= 8;
+    }
+
+    while (length) {
+        *dest++ = value;
+        length--;
+    }
+}
+
+// dest = color + (dest * alpha)
+V_TARGET_AVX2 static void copy_helper_avx2(uint32_t *dest, int length,
+                                           uint32_t color, uint32_t alpha)
+{
+    const __m256i v_color = _mm256_set1_epi32(color);
+    const __m256i v_a = _mm256_set1_epi16(alpha);
+
+    for (; length >= 8; length -= 8, dest += 8) {
+        __m256i v_dest = _mm256_loadu_si256((const __m256i *)dest);
+        v_dest = _mm256_add_epi32(v8_byte_mul_avx2(v_dest, v_a), v_color);
+        _mm256_storeu_si256((__m256i *)dest, v_dest);
+    }
+
+    for (; length; --length, ++dest) *dest = color + BYTE_MUL(*dest, alpha);
+}
+
+V_TARGET_AVX2 static void color_Source(uint32_t *dest, int length,
+                                       uint32_t color, uint32_t const_alpha)
+{
+    if (const_alpha == 255) {
+        memfill32_avx2(dest, color, length);
+    } else {
+        color = BYTE_MUL(color, const_alpha);
+        copy_helper_avx2(dest, length, color, 255 - const_alpha);
+    }
+}
+
+V_TARGET_AVX2 static void color_SourceOver(uint32_t *dest, int length,
+                                           uint32_t color,
+                                           uint32_t const_alpha)
+{
+    if (const_alpha != 255) color = BYTE_MUL(color, const_alpha);
+    copy_helper_avx2(dest, length, color, 255 - vAlpha(color));
+}
+
+V_TARGET_AVX2 static void color_DestinationIn(uint32_t *dest, int length,
+                                              uint32_t color,
+                                              uint32_t const_alpha)
+{
+    uint32_t a = vAlpha(color);
+    if (const_alpha != 255) a = BYTE_MUL(a, const_alpha) + 255 - const_alpha;
+    copy_helper_avx2(dest, length, 0, a);
+}
+
+V_TARGET_AVX2 static void color_DestinationOut(uint32_t *dest, int length,
+                                               uint32_t color,
+                                               uint32_t const_alpha)
+{
+    uint32_t a = vAlpha(~color);
+    if (const_alpha != 255) a = BYTE_MUL(a, const_alpha) + 255 - const_alpha;
+    copy_helper_avx2(dest, length, 0, a);
+}
+
+V_TARGET_AVX2 static void src_Source(uint32_t *dest, int length,
+                                     const uint32_t *src, uint32_t const_alpha)
+{
+    if (const_alpha == 255) {
+        memcpy(dest, src, size_t(length) * sizeof(uint32_t));
+        return;
+    }
+
+    uint32_t      ialpha = 255 - const_alpha;
+    const __m256i v_a = _mm256_set1_epi16(const_alpha);
+    const __m256i v_ia = _mm256_set1_epi16(ialpha);
+
+    for (; length >= 8; length -= 8, src += 8, dest += 8) {
+        __m256i v_src = _mm256_loadu_si256((const __m256i *)src);
+        __m256i v_dest = _mm256_loadu_si256((const __m256i *)dest);
+        v_dest = v8_interpolate_avx2(v_src, v_a, v_dest, v_ia);
+        _mm256_storeu_si256((__m256i *)dest, v_dest);
+    }
+
+    for (; length; --length, ++src, ++dest)
+        *dest = interpolate_pixel(*src, const_alpha, *dest, ialpha);
+}
+
+/* s' = s * ca
+ * d' = s' + d (1 - s'a)
+ */
+V_TARGET_AVX2 static void src_SourceOver(uint32_t *dest, int length,
+                                         const uint32_t *src,
+                                         uint32_t const_alpha)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi32(-1);
+    const __m256i amask = _mm256_set1_epi32(0xff000000);
+    const __m256i v_a = _mm256_set1_epi16(const_alpha);
+
+    for (; length >= 8; length -= 8, src += 8, dest += 8) {
+        __m256i v_src = _mm256_loadu_si256((const __m256i *)src);
+        if (const_alpha != 255) v_src = v8_byte_mul_avx2(v_src, v_a);
+
+        // fully transparent source leaves dest as is.
+        if (_mm256_testz_si256(v_src, v_src)) continue;
+
+        // fully opaque source replaces dest.
+        __m256i opaque =
+            _mm256_cmpeq_epi32(_mm256_and_si256(v_src, amask), amask);
+        if (_mm256_movemask_epi8(opaque) == -1) {
+            _mm256_storeu_si256((__m256i *)dest, v_src);
+            continue;
+        }
+
+        __m256i v_dest = _mm256_loadu_si256((const __m256i *)dest);
+        __m256i v_sia = v8_alpha_avx2(_mm256_xor_si256(v_src, ones));
+        __m256i v_res =
+            _mm256_add_epi32(v_src, v8_byte_mul_avx2(v_dest, v_sia));
+
+        // BYTE_MUL(dest, 255) is not exact, keep dest where s' is 0.
+        v_res = _mm256_blendv_epi8(v_res, v_dest,
+                                   _mm256_cmpeq_epi32(v_src, zero));
+        _mm256_storeu_si256((__m256i *)dest, v_res);
+    }
+
+    for (; length; --length, ++src, ++dest) {
+        uint32_t s = *src;
+        if (const_alpha != 255) s = BYTE_MUL(s, const_alpha);
+        if (s >= 0xff000000)
+            *dest = s;
+        else if (s != 0)
+            *dest = s + BYTE_MUL(*dest, vAlpha(~s));
+    }
+}
+
+V_TARGET_AVX2 static void src_DestinationIn(uint32_t *dest, int length,
+                                            const uint32_t *src,
+                                            uint32_t const_alpha)
+{
+    const __m256i v_a = _mm256_set1_epi16(const_alpha);
+    const __m256i v_cia = _mm256_set1_epi32(255 - const_alpha);
+
+    for (; length >= 8; length -= 8, src += 8, dest += 8) {
+        __m256i v_src = _mm256_loadu_si256((const __m256i *)src);
+        __m256i v_dest = _mm256_loadu_si256((const __m256i *)dest);
+        __m256i v_sa = const_alpha == 255
+                           ? v8_alpha_avx2(v_src)
+                           : v8_dest_alpha_avx2(v_src, v_a, v_cia);
+        _mm256_storeu_si256((__m256i *)dest, v8_byte_mul_avx2(v_dest, v_sa));
+    }
+
+    for (; length; --length, ++src, ++dest) {
+        uint32_t a = vAlpha(*src);
+        if (const_alpha != 255)
+            a = BYTE_MUL(a, const_alpha) + 255 - const_alpha;
+        *dest = BYTE_MUL(*dest, a);
+    }
+}
+
+V_TARGET_AVX2 static void src_DestinationOut(uint32_t *dest, int length,
+                                             const uint32_t *src,
+                                             uint32_t const_alpha)
+{
+    const __m256i ones = _mm256_set1_epi32(-1);
+    const __m256i v_a = _mm256_set1_epi16(const_alpha);
+    const __m256i v_cia = _mm256_set1_epi32(255 - const_alpha);
+
+    for (; length >= 8; length -= 8, src += 8, dest += 8) {
+        __m256i v_src =
+            _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)src), ones);
+        __m256i v_dest = _mm256_loadu_si256((const __m256i *)dest);
+        __m256i v_sia = const_alpha == 255
+                            ? v8_alpha_avx2(v_src)
+                            : v8_dest_alpha_avx2(v_src, v_a, v_cia);
+        _mm256_storeu_si256((__m256i *)dest, v8_byte_mul_avx2(v_dest, v_sia));
+    }
+
+    for (; length; --length, ++src, ++dest) {
+        uint32_t a = vAlpha(~*src);
+        if (const_alpha != 255)
+            a = BYTE_MUL(a, const_alpha) + 255 - const_alpha;
+        *dest = BYTE_MUL(*dest, a);
+    }
+}
+
+// vLuma() of 8 pixels, each in the form 0x00LL00LL
+V_TARGET_AVX2 static inline __m256i v8_luma_avx2(__m256i c)
+{
+    const __m256i mask = _mm256_set1_epi32(0xff);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i max = _mm256_set1_epi32(255);
+
+    __m256i a = _mm256_srli_epi32(c, 24);
+    __m256i r = _mm256_mullo_epi16(
+        _mm256_and_si256(_mm256_srli_epi32(c, 16), mask), max);
+    __m256i g = _mm256_mullo_epi16(
+        _mm256_and_si256(_mm256_srli_epi32(c, 8), mask), max);
+    __m256i b = _mm256_mullo_epi16(_mm256_and_si256(c, mask), max);
+
+    // un multiply
+    __m256 fa = _mm256_cvtepi32_ps(_mm256_max_epi16(a, one));
+    __m256 fr = _mm256_cvtepi32_ps(
+        _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(r), fa)));
+    __m256 fg = _mm256_cvtepi32_ps(
+        _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(g), fa)));
+    __m256 fb = _mm256_cvtepi32_ps(
+        _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(b), fa)));
+
+    __m256 l = _mm256_add_ps(
+        _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(vLumaRed), fr),
+                      _mm256_mul_ps(_mm256_set1_ps(vLumaGreen), fg)),
+        _mm256_mul_ps(_mm256_set1_ps(vLumaBlue), fb));
+    __m256i luma =
+        _mm256_cvttps_epi32(_mm256_min_ps(l, _mm256_set1_ps(255)));
+    luma = _mm256_andnot_si256(_mm256_cmpeq_epi32(a, _mm256_setzero_si256()),
+                               luma);
+    return _mm256_or_si256(luma, _mm256_slli_epi32(luma, 16));
+}
+
+template <bool inverted>
+V_TARGET_AVX2 static void src_Luma(uint32_t *dest, int length,
+                                   const uint32_t *src, uint32_t const_alpha)
+{
+    const __m256i v_ones = _mm256_set1_epi32(0x00ff00ff);
+    const __m256i v_a = _mm256_set1_epi16(const_alpha);
+    const __m256i v_cia = _mm256_set1_epi16(255 - const_alpha);
+    const uint32_t cia = 255 - const_alpha;
+
+    for (; length >= 8; length -= 8, src += 8, dest += 8) {
+        __m256i v_luma =
+            v8_luma_avx2(_mm256_loadu_si256((const __m256i *)src));
+        if (inverted) v_luma = _mm256_sub_epi16(v_ones, v_luma);
+        if (const_alpha != 255)
+            v_luma = _mm256_add_epi16(
+                _mm256_srli_epi16(_mm256_mullo_epi16(v_luma, v_a), 8), v_cia);
+        __m256i v_dest = _mm256_loadu_si256((const __m256i *)dest);
+        _mm256_storeu_si256((__m256i *)dest, v8_byte_mul_avx2(v_dest, v_luma));
+    }
+
+    for (; length; --length, ++src, ++dest) {
+        uint32_t a = vLuma(*src);
+        if (inverted) a = 255 - a;
+        if (const_alpha != 255) a = BYTE_MUL(a, const_alpha) + cia;
+        *dest = BYTE_MUL(*dest, a);
+    }
+}
+
+// wraps or clamps positions into the color table like gradientClamp()
+template <VGradient::Spread spread>
+V_TARGET_AVX2 static inline __m256i v8_gradient_clamp_avx2(__m256i ipos)
+{
+    const __m256i size_mask = _mm256_set1_epi32(VGradient::colorTableSize - 1);
+
+    if (spread == VGradient::Spread::Repeat) {
+        return _mm256_and_si256(ipos, size_mask);
+    } else if (spread == VGradient::Spread::Reflect) {
+        const __m256i limit_mask =
+            _mm256_set1_epi32(VGradient::colorTableSize * 2 - 1);
+        ipos = _mm256_and_si256(ipos, limit_mask);
+        __m256i reflect = _mm256_cmpgt_epi32(ipos, size_mask);
+        return _mm256_xor_si256(ipos, _mm256_and_si256(reflect, limit_mask));
+    } else {
+        ipos = _mm256_max_epi32(ipos, _mm256_setzero_si256());
+        return _mm256_min_epi32(ipos, size_mask);
+    }
+}
+
+template <VGradient::Spread spread>
+V_TARGET_AVX2 static void gradient_linear_avx2(uint32_t *buffer, int length,
+                                               const VGradientData *gradient,
+                                               int t, int inc)
+{
+    const int *   table = (const int *)gradient->mColorTable;
+    const __m256i v_inc = _mm256_set1_epi32(8 * inc);
+    __m256i       v_t = _mm256_add_epi32(
+        _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                           _mm256_set1_epi32(inc)),
+        _mm256_set1_epi32(t + FIXPT_SIZE / 2));
+
+    for (; length >= 8; length -= 8, buffer += 8, t += 8 * inc) {
+        __m256i v_pos = _mm256_srai_epi32(v_t, FIXPT_BITS);
+        v_pos = v8_gradient_clamp_avx2<spread>(v_pos);
+        _mm256_storeu_si256((__m256i *)buffer,
+                            _mm256_i32gather_epi32(table, v_pos, 4));
+        v_t = _mm256_add_epi32(v_t, v_inc);
+    }
+
+    linearGradientSpan(buffer, length, gradient, t, inc);
+}
+
+template <VGradient::Spread spread>
+V_TARGET_AVX2 static void gradient_radial_avx2(
+    uint32_t *buffer, int length, const VGradientData *gradient,
+    const RadialGradientValues *v, float det, float delta_det,
+    float delta_delta_det, float b, float delta_b)
+{
+    const int *  table = (const int *)gradient->mColorTable;
+    const __m256 v_zero = _mm256_setzero_ps();
+    const __m256 v_scale = _mm256_set1_ps(VGradient::colorTableSize - 1);
+    const __m256 v_half = _mm256_set1_ps(0.5f);
+    const __m256 v_fr = _mm256_set1_ps(gradient->radial.fradius);
+    const __m256 v_dr = _mm256_set1_ps(v->dr);
+    alignas(32) float dets[8], bs[8];
+
+    for (; length >= 8; length -= 8, buffer += 8) {
+        // keep the per pixel steps of the scalar version to get its rounding
+        for (int i = 0; i < 8; i++) {
+            dets[i] = det;
+            bs[i] = b;
+            det += delta_det;
+            delta_det += delta_delta_det;
+            b += delta_b;
+        }
+
+        __m256  v_det = _mm256_load_ps(dets);
+        __m256  v_w = _mm256_sub_ps(_mm256_sqrt_ps(v_det), _mm256_load_ps(bs));
+        __m256i v_pos = _mm256_cvttps_epi32(
+            _mm256_add_ps(_mm256_mul_ps(v_w, v_scale), v_half));
+        v_pos = v8_gradient_clamp_avx2<spread>(v_pos);
+        __m256i v_color = _mm256_i32gather_epi32(table, v_pos, 4);
+
+        if (v->extended) {
+            __m256 v_r = _mm256_add_ps(v_fr, _mm256_mul_ps(v_dr, v_w));
+            __m256 valid =
+                _mm256_and_ps(_mm256_cmp_ps(v_det, v_zero, _CMP_GE_OQ),
+                              _mm256_cmp_ps(v_r, v_zero, _CMP_GE_OQ));
+            v_color = _mm256_and_si256(v_color, _mm256_castps_si256(valid));
+        }
+        _mm256_storeu_si256((__m256i *)buffer, v_color);
+    }
+
+    radialGradientSpan(buffer, length, gradient, v, det, delta_det,
+                       delta_delta_det, b, delta_b);
+}
+
+static void gradient_Linear(uint32_t *buffer, int length,
+                            const VGradientData *gradient, int t, int inc)
+{
+    switch (gradient->mSpread) {
+    case VGradient::Spread::Repeat:
+        gradient_linear_avx2<VGradient::Spread::Repeat>(buffer, length,
+                                                        gradient, t, inc);
+        break;
+    case VGradient::Spread::Reflect:
+        gradient_linear_avx2<VGradient::Spread::Reflect>(buffer, length,
+                                                         gradient, t, inc);
+        break;
+    default:
+        gradient_linear_avx2<VGradient::Spread::Pad>(buffer, length, gradient,
+                                                     t, inc);
+        break;
+    }
+}
+
+static void gradient_Radial(uint32_t *buffer, int length,
+                            const VGradientData *       gradient,
+                            const RadialGradientValues *v, float det,
+                            float delta_det, float delta_delta_det, float b,
+                            float delta_b)
+{
+    switch (gradient->mSpread) {
+    case VGradient::Spread::Repeat:
+        gradient_radial_avx2<VGradient::Spread::Repeat>(
+            buffer, length, gradient, v, det, delta_det, delta_delta_det, b,
+            delta_b);
+        break;
+    case VGradient::Spread::Reflect:
+        gradient_radial_avx2<VGradient::Spread::Reflect>(
+            buffer, length, gradient, v, det, delta_det, delta_delta_det, b,
+            delta_b);
+        break;
+    default:
+        gradient_radial_avx2<VGradient::Spread::Pad>(
+            buffer, length, gradient, v, det, delta_det, delta_delta_det, b,
+            delta_b);
+        break;
+    }
+}
+
+void RenderFuncTable::avx2()
+{
+    updateColor(BlendMode::Src, color_Source);
+    updateColor(BlendMode::SrcOver, color_SourceOver);
+    updateColor(BlendMode::DestIn, color_DestinationIn);
+    updateColor(BlendMode::DestOut, color_DestinationOut);
+
+    updateSrc(BlendMode::Src, src_Source);
+    updateSrc(BlendMode::SrcOver, src_SourceOver);
+    updateSrc(BlendMode::DestIn, src_DestinationIn);
+    updateSrc(BlendMode::DestOut, src_DestinationOut);
+    updateSrc(BlendMode::DestInLuma, src_Luma<false>);
+    updateSrc(BlendMode::DestOutLuma, src_Luma<true>);
+
+    updateGradient(gradient_Linear, gradient_Radial);
+}
+
+#endif
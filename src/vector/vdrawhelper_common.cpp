@@ -130,6 +130,8 @@ static void src_SourceOver(uint32_t *dest, int length, const uint32_t *src,
          */
         for (int i = 0; i < length; ++i) {
             s = BYTE_MUL(src[i], alpha);
+            // BYTE_MUL(dest, 255) is not exact, keep dest as is.
+            if (s == 0) continue;
             sia = vAlpha(~s);
             dest[i] = s + BYTE_MUL(dest[i], sia);
         }
@@ -168,22 +170,101 @@ static void src_DestinationOut(uint32_t *dest, int length, const uint32_t *src,
     }
 }
 
-RenderFuncTable::RenderFuncTable()
+/*
+  luma matte, the luminance of s is its alpha
+  dest = d * luma(s) * ca + d * cia
+*/
+static void color_DestinationInLuma(uint32_t *dest, int length, uint32_t color,
+                                    uint32_t alpha)
+{
+    color_DestinationIn(dest, length, vLuma(color) << 24, alpha);
+}
+
+static void color_DestinationOutLuma(uint32_t *dest, int length,
+                                     uint32_t color, uint32_t alpha)
+{
+    color_DestinationOut(dest, length, vLuma(color) << 24, alpha);
+}
+
+static void src_DestinationInLuma(uint32_t *dest, int length,
+                                  const uint32_t *src, uint32_t alpha)
+{
+    uint32_t cia = 255 - alpha;
+    for (int i = 0; i < length; ++i) {
+        uint32_t a = vLuma(src[i]);
+        if (alpha != 255) a = BYTE_MUL(a, alpha) + cia;
+        dest[i] = BYTE_MUL(dest[i], a);
+    }
+}
+
+static void src_DestinationOutLuma(uint32_t *dest, int length,
+                                   const uint32_t *src, uint32_t alpha)
+{
+    uint32_t cia = 255 - alpha;
+    for (int i = 0; i < length; ++i) {
+        uint32_t a = 255 - vLuma(src[i]);
+        if (alpha != 255) a = BYTE_MUL(a, alpha) + cia;
+        dest[i] = BYTE_MUL(dest[i], a);
+    }
+}
+
+#if !defined(__SSE2__) && !defined(__ARM_NEON__)
+void memfill32(uint32_t *dest, uint32_t value, int length)
+{
+    // let compiler do the auto vectorization.
+    for (int i = 0 ; i < length; i++) {
+        *dest++ = value;
+    }
+}
+#endif
+
+uint32_t vCpuFeatures()
+{
+    static const uint32_t features = [] {
+        uint32_t f = 0;
+#if defined(__ARM_NEON__)
+        f |= CpuFeature::NEON;
+#endif
+#if defined(__SSE2__)
+        f |= CpuFeature::SSE2;
+#endif
+#if defined(VDRAWHELPER_AVX2)
+        // runs cpuid and checks that the os saves the ymm registers.
+        // may be called from a static constructor, so init explicitly.
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) f |= CpuFeature::AVX2;
+#endif
+        return f;
+    }();
+    return features;
+}
+
+RenderFuncTable::RenderFuncTable(uint32_t features)
 {
     updateColor(BlendMode::Src, color_Source);
     updateColor(BlendMode::SrcOver, color_SourceOver);
     updateColor(BlendMode::DestIn, color_DestinationIn);
     updateColor(BlendMode::DestOut, color_DestinationOut);
+    updateColor(BlendMode::DestInLuma, color_DestinationInLuma);
+    updateColor(BlendMode::DestOutLuma, color_DestinationOutLuma);
 
     updateSrc(BlendMode::Src, src_Source);
     updateSrc(BlendMode::SrcOver, src_SourceOver);
     updateSrc(BlendMode::DestIn, src_DestinationIn);
     updateSrc(BlendMode::DestOut, src_DestinationOut);
+    updateSrc(BlendMode::DestInLuma, src_DestinationInLuma);
+    updateSrc(BlendMode::DestOutLuma, src_DestinationOutLuma);
+
+    updateGradient(linearGradientSpan, radialGradientSpan);
 
 #if defined(__ARM_NEON__)
-    neon();
+    if (features & CpuFeature::NEON) neon();
 #endif
 #if defined(__SSE2__)
-    sse();
+    if (features & CpuFeature::SSE2) sse();
+#endif
+#if defined(VDRAWHELPER_AVX2)
+    if (features & CpuFeature::AVX2) avx2();
 #endif
+    (void)features;
 }
@@ -120,8 +120,17 @@ static inline __m128i v4_interpolate_color_sse2(__m128i a, __m128i c0,
             }                                       \
     }
 
+#if defined(VDRAWHELPER_AVX2)
+// zero until static initialization runs, which falls back to sse2.
+static const bool hasAvx2 = vCpuFeatures() & CpuFeature::AVX2;
+#endif
+
 void memfill32(uint32_t* dest, uint32_t value, int length)
 {
+#if defined(VDRAWHELPER_AVX2)
+    if (hasAvx2) return memfill32_avx2(dest, value, length);
+#endif
+
     __m128i vector_data = _mm_set_epi32(value, value, value, value);
 
     // run till memory alligned to 16byte memory
@@ -250,12 +259,205 @@ static void src_Source(uint32_t* dest, int length, const uint32_t* src,
     }
 }
 
+// vLuma() of 4 pixels, each in the form 0x00LL00LL
+static inline __m128i v4_luma_sse2(__m128i c)
+{
+    const __m128i mask = _mm_set1_epi32(0xff);
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i max = _mm_set1_epi32(255);
+
+    __m128i a = _mm_srli_epi32(c, 24);
+    // the channels fit in 16 bits, so does channel * 255
+    __m128i r = _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi32(c, 16), mask), max);
+    __m128i g = _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi32(c, 8), mask), max);
+    __m128i b = _mm_mullo_epi16(_mm_and_si128(c, mask), max);
+
+    // un multiply
+    __m128 fa = _mm_cvtepi32_ps(_mm_max_epi16(a, one));
+    __m128 fr = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(r), fa)));
+    __m128 fg = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(g), fa)));
+    __m128 fb = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(b), fa)));
+
+    __m128 l = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(vLumaRed), fr),
+                                     _mm_mul_ps(_mm_set1_ps(vLumaGreen), fg)),
+                          _mm_mul_ps(_mm_set1_ps(vLumaBlue), fb));
+    __m128i luma = _mm_cvttps_epi32(_mm_min_ps(l, _mm_set1_ps(255)));
+    luma = _mm_andnot_si128(_mm_cmpeq_epi32(a, _mm_setzero_si128()), luma);
+    return _mm_or_si128(luma, _mm_slli_epi32(luma, 16));
+}
+
+template <bool inverted>
+static void src_Luma(uint32_t* dest, int length, const uint32_t* src,
+                     uint32_t const_alpha)
+{
+    const __m128i v_ones = _mm_set1_epi32(0x00ff00ff);
+    const __m128i v_a = _mm_set1_epi16(const_alpha);
+    const __m128i v_cia = _mm_set1_epi16(255 - const_alpha);
+    const uint32_t cia = 255 - const_alpha;
+
+    for (; length >= 4; length -= 4, src += 4, dest += 4) {
+        __m128i v_luma = v4_luma_sse2(_mm_loadu_si128((const __m128i*)src));
+        if (inverted) v_luma = _mm_sub_epi16(v_ones, v_luma);
+        if (const_alpha != 255)
+            v_luma = _mm_add_epi16(
+                _mm_srli_epi16(_mm_mullo_epi16(v_luma, v_a), 8), v_cia);
+        __m128i v_dest = _mm_loadu_si128((const __m128i*)dest);
+        _mm_storeu_si128((__m128i*)dest, v4_byte_mul_sse2(v_dest, v_luma));
+    }
+
+    for (; length; --length, ++src, ++dest) {
+        uint32_t a = vLuma(*src);
+        if (inverted) a = 255 - a;
+        if (const_alpha != 255) a = BYTE_MUL(a, const_alpha) + cia;
+        *dest = BYTE_MUL(*dest, a);
+    }
+}
+
+// wraps or clamps positions into the color table like gradientClamp()
+template <VGradient::Spread spread>
+static inline __m128i v4_gradient_clamp_sse2(__m128i ipos)
+{
+    const __m128i size_mask = _mm_set1_epi32(VGradient::colorTableSize - 1);
+
+    if (spread == VGradient::Spread::Repeat) {
+        return _mm_and_si128(ipos, size_mask);
+    } else if (spread == VGradient::Spread::Reflect) {
+        const __m128i limit_mask =
+            _mm_set1_epi32(VGradient::colorTableSize * 2 - 1);
+        ipos = _mm_and_si128(ipos, limit_mask);
+        __m128i reflect = _mm_cmpgt_epi32(ipos, size_mask);
+        return _mm_xor_si128(ipos, _mm_and_si128(reflect, limit_mask));
+    } else {
+        ipos = _mm_and_si128(ipos, _mm_cmpgt_epi32(ipos, _mm_setzero_si128()));
+        __m128i over = _mm_cmpgt_epi32(ipos, size_mask);
+        return _mm_or_si128(_mm_andnot_si128(over, ipos),
+                            _mm_and_si128(over, size_mask));
+    }
+}
+
+template <VGradient::Spread spread>
+static void gradient_linear_sse2(uint32_t *buffer, int length,
+                                 const VGradientData *gradient, int t, int inc)
+{
+    const uint32_t *table = gradient->mColorTable;
+    const __m128i   v_inc = _mm_set1_epi32(4 * inc);
+    __m128i         v_t = _mm_add_epi32(_mm_setr_epi32(0, inc, 2 * inc, 3 * inc),
+                                        _mm_set1_epi32(t + FIXPT_SIZE / 2));
+    alignas(16) int32_t ipos[4];
+
+    for (; length >= 4; length -= 4, buffer += 4, t += 4 * inc) {
+        __m128i v_pos = _mm_srai_epi32(v_t, FIXPT_BITS);
+        _mm_store_si128((__m128i *)ipos, v4_gradient_clamp_sse2<spread>(v_pos));
+        buffer[0] = table[ipos[0]];
+        buffer[1] = table[ipos[1]];
+        buffer[2] = table[ipos[2]];
+        buffer[3] = table[ipos[3]];
+        v_t = _mm_add_epi32(v_t, v_inc);
+    }
+
+    linearGradientSpan(buffer, length, gradient, t, inc);
+}
+
+template <VGradient::Spread spread>
+static void gradient_radial_sse2(uint32_t *buffer, int length,
+                                 const VGradientData *       gradient,
+                                 const RadialGradientValues *v, float det,
+                                 float delta_det, float delta_delta_det,
+                                 float b, float delta_b)
+{
+    const uint32_t *table = gradient->mColorTable;
+    const __m128    v_zero = _mm_setzero_ps();
+    const __m128    v_scale = _mm_set1_ps(VGradient::colorTableSize - 1);
+    const __m128    v_half = _mm_set1_ps(0.5f);
+    const __m128    v_fr = _mm_set1_ps(gradient->radial.fradius);
+    const __m128    v_dr = _mm_set1_ps(v->dr);
+    alignas(16) float   dets[4], bs[4];
+    alignas(16) int32_t ipos[4];
+
+    for (; length >= 4; length -= 4, buffer += 4) {
+        // keep the per pixel steps of the scalar version to get its rounding
+        for (int i = 0; i < 4; i++) {
+            dets[i] = det;
+            bs[i] = b;
+            det += delta_det;
+            delta_det += delta_delta_det;
+            b += delta_b;
+        }
+
+        __m128 v_det = _mm_load_ps(dets);
+        __m128 v_w = _mm_sub_ps(_mm_sqrt_ps(v_det), _mm_load_ps(bs));
+        __m128i v_pos =
+            _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v_w, v_scale), v_half));
+        _mm_store_si128((__m128i *)ipos, v4_gradient_clamp_sse2<spread>(v_pos));
+
+        int valid = 0xf;
+        if (v->extended) {
+            __m128 v_r = _mm_add_ps(v_fr, _mm_mul_ps(v_dr, v_w));
+            valid = _mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(v_det, v_zero),
+                                               _mm_cmpge_ps(v_r, v_zero)));
+        }
+        for (int i = 0; i < 4; i++)
+            buffer[i] = (valid & (1 << i)) ? table[ipos[i]] : 0;
+    }
+
+    radialGradientSpan(buffer, length, gradient, v, det, delta_det,
+                       delta_delta_det, b, delta_b);
+}
+
+static void gradient_Linear(uint32_t *buffer, int length,
+                            const VGradientData *gradient, int t, int inc)
+{
+    switch (gradient->mSpread) {
+    case VGradient::Spread::Repeat:
+        gradient_linear_sse2<VGradient::Spread::Repeat>(buffer, length,
+                                                        gradient, t, inc);
+        break;
+    case VGradient::Spread::Reflect:
+        gradient_linear_sse2<VGradient::Spread::Reflect>(buffer, length,
+                                                         gradient, t, inc);
+        break;
+    default:
+        gradient_linear_sse2<VGradient::Spread::Pad>(buffer, length, gradient,
+                                                     t, inc);
+        break;
+    }
+}
+
+static void gradient_Radial(uint32_t *buffer, int length,
+                            const VGradientData *       gradient,
+                            const RadialGradientValues *v, float det,
+                            float delta_det, float delta_delta_det, float b,
+                            float delta_b)
+{
+    switch (gradient->mSpread) {
+    case VGradient::Spread::Repeat:
+        gradient_radial_sse2<VGradient::Spread::Repeat>(
+            buffer, length, gradient, v, det, delta_det, delta_delta_det, b,
+            delta_b);
+        break;
+    case VGradient::Spread::Reflect:
+        gradient_radial_sse2<VGradient::Spread::Reflect>(
+            buffer, length, gradient, v, det, delta_det, delta_delta_det, b,
+            delta_b);
+        break;
+    default:
+        gradient_radial_sse2<VGradient::Spread::Pad>(
+            buffer, length, gradient, v, det, delta_det, delta_delta_det, b,
+            delta_b);
+        break;
+    }
+}
+
 void RenderFuncTable::sse()
 {
     updateColor(BlendMode::Src , color_Source);
     updateColor(BlendMode::SrcOver , color_SourceOver);
 
     updateSrc(BlendMode::Src , src_Source);
+    updateSrc(BlendMode::DestInLuma, src_Luma<false>);
+    updateSrc(BlendMode::DestOutLuma, src_Luma<true>);
+
+    updateGradient(gradient_Linear, gradient_Radial);
 }
 
 #endif
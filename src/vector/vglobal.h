@@ -288,6 +288,8 @@ enum class BlendMode {
     SrcOver,
     DestIn,
     DestOut,
+    DestInLuma,   // DestIn with the luminance of the source as its alpha
+    DestOutLuma,  // DestOut with the luminance of the source as its alpha
     Last,
 };
 
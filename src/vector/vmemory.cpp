@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "vmemory.h"
+#include <algorithm>
+
+V_BEGIN_NAMESPACE
+
+std::atomic<size_t> VMemoryBudget::mRleBytes{0};
+
+VMemoryBudget &VMemoryBudget::instance()
+{
+    static VMemoryBudget singleton;
+    return singleton;
+}
+
+void VMemoryBudget::add(VMemoryClient *client)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mClients.push_back(client);
+}
+
+void VMemoryBudget::remove(VMemoryClient *client)
+{
+    // a running trim may still call the client.
+    std::lock_guard<std::mutex> trimLock(mTrimMutex);
+    std::lock_guard<std::mutex> lock(mMutex);
+    mClients.erase(std::remove(mClients.begin(), mClients.end(), client),
+                   mClients.end());
+}
+
+void VMemoryBudget::setBudget(size_t bytes)
+{
+    mBudget = bytes;
+    grew();
+    enforce();
+}
+
+VMemoryUsage VMemoryBudget::usage() const
+{
+    VMemoryUsage usage;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto client : mClients) client->usage(usage);
+    }
+    usage.rle = mRleBytes.load(std::memory_order_relaxed);
+    return usage;
+}
+
+/*
+ * A client trim can wait for threads that report to the registry (e.g. a
+ * render tree waiting for its rle tasks), so the clients are trimmed
+ * without holding mMutex. mTrimMutex keeps them from being removed
+ * meanwhile.
+ */
+void VMemoryBudget::trim(VTrimLevel level)
+{
+    std::lock_guard<std::mutex>  trimLock(mTrimMutex);
+    std::vector<VMemoryClient *> clients;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        clients = mClients;
+    }
+    for (auto client : clients) client->trim(level);
+}
+
+void VMemoryBudget::enforce()
+{
+    size_t budget = mBudget.load();
+    if (!budget || !mGrew.exchange(false)) return;
+
+    auto   current = usage();
+    size_t total = current.total();
+    if (total <= budget) return;
+
+    // memory each level releases, deferred trims make it an estimate.
+    size_t scratch = current.gradient + current.rasterizer + current.surface;
+
+    // the live render trees may alone be over the budget, rebuilding them
+    // every frame wouldn't bring it down for long.
+    if (total - scratch <= budget)
+        trim(VTrimLevel::Scratch);
+    else
+        trim(VTrimLevel::Caches);
+}
+
+V_END_NAMESPACE
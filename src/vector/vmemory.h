@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef VMEMORY_H
+#define VMEMORY_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "vglobal.h"
+
+V_BEGIN_NAMESPACE
+
+/*
+ * Memory held by the caches of the library, in bytes.
+ */
+struct VMemoryUsage {
+    size_t model{0};        // parsed models in the model cache
+    size_t gradient{0};     // gradient color tables
+    size_t rasterizer{0};   // outline and stroker buffers of the rle workers
+    size_t surface{0};      // pooled offscreen surfaces
+    size_t rasterCache{0};  // rasterized static layers
+    size_t frameCache{0};   // encoded frames
+    size_t rle{0};          // span storage of all rles
+
+    size_t total() const
+    {
+        return model + gradient + rasterizer + surface + rasterCache +
+               frameCache + rle;
+    }
+};
+
+/*
+ * What a trim releases, every level includes the previous ones.
+ * Scratch : buffers that are reused between frames.
+ * Caches  : cached results, they are rebuilt when needed again.
+ * All     : also the render trees, rebuilt on the next render.
+ */
+enum class VTrimLevel { Scratch, Caches, All };
+
+/*
+ * A cache that reports its memory to VMemoryBudget. Both functions can be
+ * called from any thread. A cache that is only safe to touch from its own
+ * thread may defer the trim until it runs next.
+ */
+class VMemoryClient {
+public:
+    virtual ~VMemoryClient() = default;
+    virtual void usage(VMemoryUsage &usage) const = 0;
+    virtual void trim(VTrimLevel level) = 0;
+};
+
+/*
+ * Process wide registry of the caches. A cache that grew calls grew(),
+ * which only takes note of it, so any thread can call it. The budget is
+ * enforced by enforce() at the end of a render call, it trims everybody
+ * at the lowest level that brings the total back within the budget. It
+ * never goes further than VTrimLevel::Caches, dropping the render trees
+ * is left to an explicit trim().
+ */
+class VMemoryBudget {
+public:
+    static VMemoryBudget &instance();
+
+    // clients add themselves once constructed and remove themselves
+    // before they start to tear down.
+    void add(VMemoryClient *client);
+    void remove(VMemoryClient *client);
+
+    void         setBudget(size_t bytes);
+    size_t       budget() const { return mBudget.load(); }
+    VMemoryUsage usage() const;
+    void         trim(VTrimLevel level);
+    void         grew() { mGrew.store(true, std::memory_order_relaxed); }
+    // must not be called with a lock of a client held.
+    void         enforce();
+
+    static void rleAllocated(size_t bytes) { mRleBytes += bytes; }
+    static void rleReleased(size_t bytes) { mRleBytes -= bytes; }
+
+private:
+    VMemoryBudget() = default;
+
+    mutable std::mutex           mMutex;
+    std::mutex                   mTrimMutex;
+    std::vector<VMemoryClient *> mClients;
+    std::atomic<size_t>          mBudget{0};
+    std::atomic<bool>            mGrew{false};
+    static std::atomic<size_t>   mRleBytes;
+};
+
+/*
+ * Allocator of the rle span storage, it is spread over too many objects
+ * to be reported by an owner.
+ */
+template <typename T>
+struct VRleAllocator {
+    using value_type = T;
+
+    VRleAllocator() = default;
+    template <typename U>
+    VRleAllocator(const VRleAllocator<U> &) noexcept
+    {
+    }
+
+    T *allocate(size_t n)
+    {
+        VMemoryBudget::rleAllocated(n * sizeof(T));
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T *p, size_t n) noexcept
+    {
+        VMemoryBudget::rleReleased(n * sizeof(T));
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template <typename U>
+    bool operator==(const VRleAllocator<U> &) const noexcept
+    {
+        return true;
+    }
+    template <typename U>
+    bool operator!=(const VRleAllocator<U> &) const noexcept
+    {
+        return false;
+    }
+};
+
+V_END_NAMESPACE
+
+#endif  // VMEMORY_H
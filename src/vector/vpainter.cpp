@@ -22,10 +22,104 @@
 
 #include "vpainter.h"
 #include <algorithm>
+#include <cstring>
+#include "vprofile.h"
+#include "vtaskpool.h"
 
 
 V_BEGIN_NAMESPACE
 
+/*
+ * Blending fewer pixels than this is not worth waking up other threads.
+ */
+static constexpr size_t ParallelThreshold = 16 * 1024;
+
+#ifdef LOTTIE_PROFILE_SUPPORT
+
+// the blend function can't count the pixels, count them on the way.
+VRle::VRleSpanCb VPainter::blendFunc()
+{
+    return mThreadCount > 1 ? &VPainter::collectSpans : &VPainter::countSpans;
+}
+
+void *VPainter::blendData()
+{
+    return static_cast<void *>(this);
+}
+
+void VPainter::countSpans(size_t count, const VRle::Span *spans,
+                          void *userData)
+{
+    auto painter = reinterpret_cast<VPainter *>(userData);
+    for (size_t i = 0; i < count; i++) painter->mPixels += spans[i].len;
+    painter->mSpanData.mUnclippedBlendFunc(count, spans, &painter->mSpanData);
+}
+
+#else
+
+VRle::VRleSpanCb VPainter::blendFunc()
+{
+    return mThreadCount > 1 ? &VPainter::collectSpans
+                            : mSpanData.mUnclippedBlendFunc;
+}
+
+void *VPainter::blendData()
+{
+    return mThreadCount > 1 ? static_cast<void *>(this)
+                            : static_cast<void *>(&mSpanData);
+}
+
+#endif
+
+void VPainter::collectSpans(size_t count, const VRle::Span *spans,
+                            void *userData)
+{
+    auto painter = reinterpret_cast<VPainter *>(userData);
+    painter->mSpans.insert(painter->mSpans.end(), spans, spans + count);
+    for (size_t i = 0; i < count; i++) painter->mPixels += spans[i].len;
+}
+
+/*
+ * Blends the collected spans. They come sorted by scanline, so they are
+ * split in bands of whole scanlines and every band is blended by its own
+ * thread. Spans are never cut, so the result is the same as blending
+ * them in one go.
+ */
+void VPainter::flush()
+{
+    VPROFILE_COUNT(mPixels, mPixels);
+    if (mSpans.empty()) {
+        mPixels = 0;
+        return;
+    }
+
+    auto   spans = mSpans.data();
+    size_t count = mSpans.size();
+    auto   func = mSpanData.mUnclippedBlendFunc;
+
+    size_t bands = std::min(mThreadCount, count);
+    if (bands < 2 || mPixels < ParallelThreshold) {
+        func(count, spans, &mSpanData);
+    } else {
+        std::vector<size_t> offsets(bands + 1, count);
+        offsets[0] = 0;
+        for (size_t i = 1; i < bands; i++) {
+            size_t offset = std::max(count * i / bands, offsets[i - 1]);
+            while (offset > 0 && offset < count &&
+                   spans[offset].y == spans[offset - 1].y)
+                offset++;
+            offsets[i] = offset;
+        }
+        VTaskPool::run(bands, [&](size_t i) {
+            if (offsets[i + 1] > offsets[i])
+                func(offsets[i + 1] - offsets[i], spans + offsets[i],
+                     &mSpanData);
+        });
+    }
+
+    mSpans.clear();
+    mPixels = 0;
+}
 
 void VPainter::drawRle(const VPoint &, const VRle &rle)
 {
@@ -34,9 +128,49 @@ void VPainter::drawRle(const VPoint &, const VRle &rle)
 
     if (!mSpanData.mUnclippedBlendFunc) return;
 
+    VPROFILE_SCOPE(Blend);
+    VTRACE_SCOPE("blend");
     // do draw after applying clip.
-    rle.intersect(mSpanData.clipRect(), mSpanData.mUnclippedBlendFunc,
-                  &mSpanData);
+    VRect clip = mSpanData.clipRect();
+    if (!mClipRect.empty()) clip = clip & mClipRect;
+    rle.intersect(clip, blendFunc(), blendData());
+    flush();
+}
+
+struct ClipRectData {
+    VRect            mRect;
+    VRle::VRleSpanCb mFunc;
+    void *           mData;
+};
+
+static void clipRectSpans(size_t count, const VRle::Span *spans,
+                          void *userData)
+{
+    const auto data = reinterpret_cast<ClipRectData *>(userData);
+    const int  x1 = data->mRect.left();
+    const int  x2 = data->mRect.right();
+    const int  y1 = data->mRect.top();
+    const int  y2 = data->mRect.bottom();
+
+    const int  nspans = 256;
+    VRle::Span out[nspans];
+    int        n = 0;
+    for (size_t i = 0; i < count; i++) {
+        const auto &span = spans[i];
+        if (span.y < y1 || span.y >= y2) continue;
+        int sx1 = std::max(int(span.x), x1);
+        int sx2 = std::min(span.x + span.len, x2);
+        if (sx2 <= sx1) continue;
+
+        out[n] = span;
+        out[n].x = short(sx1);
+        out[n].len = uint16_t(sx2 - sx1);
+        if (++n == nspans) {
+            data->mFunc(n, out, data->mData);
+            n = 0;
+        }
+    }
+    if (n) data->mFunc(n, out, data->mData);
 }
 
 void VPainter::drawRle(const VRle &rle, const VRle &clip)
@@ -45,15 +179,30 @@ void VPainter::drawRle(const VRle &rle, const VRle &clip)
 
     if (!mSpanData.mUnclippedBlendFunc) return;
 
-    rle.intersect(clip, mSpanData.mUnclippedBlendFunc, &mSpanData);
+    VPROFILE_SCOPE(Blend);
+    VTRACE_SCOPE("blend");
+    // the spans only need clipping if they can fall outside of the draw
+    // region, an offscreen buffer may cover only a part of the content.
+    VRect area = mSpanData.clipRect();
+    if (mClipRect.empty() &&
+        area.contains(rle.boundingRect() & clip.boundingRect())) {
+        rle.intersect(clip, blendFunc(), blendData());
+    } else {
+        if (!mClipRect.empty()) area = area & mClipRect;
+        ClipRectData data{area, blendFunc(), blendData()};
+        rle.intersect(clip, clipRectSpans, &data);
+    }
+    flush();
 }
 
-static void fillRect(const VRect &r, VSpanData *data)
+static void fillRect(const VRect &r, VSpanData *data, VRle::VRleSpanCb func,
+                     void *userData)
 {
-    auto x1 = std::max(r.x(), 0);
-    auto x2 = std::min(r.x() + r.width(), data->mDrawableSize.width());
-    auto y1 = std::max(r.y(), 0);
-    auto y2 = std::min(r.y() + r.height(), data->mDrawableSize.height());
+    VRect clip = data->clipRect();
+    auto x1 = std::max(r.x(), clip.left());
+    auto x2 = std::min(r.x() + r.width(), clip.right());
+    auto y1 = std::max(r.y(), clip.top());
+    auto y2 = std::min(r.y() + r.height(), clip.bottom());
 
     if (x2 <= x1 || y2 <= y1) return;
 
@@ -72,7 +221,7 @@ static void fillRect(const VRect &r, VSpanData *data)
             ++i;
         }
 
-        data->mUnclippedBlendFunc(n, spans, data);
+        func(n, spans, userData);
         y += n;
     }
 }
@@ -82,26 +231,33 @@ void VPainter::drawBitmapUntransform(const VRect &  target,
                                          const VRect &  source,
                                          uint8_t        const_alpha)
 {
+    VPROFILE_SCOPE(Blend);
+    VTRACE_SCOPE("blend");
     mSpanData.initTexture(&bitmap, const_alpha, source);
     if (!mSpanData.mUnclippedBlendFunc) return;
 
     // update translation matrix for source texture.
-    mSpanData.dx = float(target.x() - source.x());
-    mSpanData.dy = float(target.y() - source.y());
-
-    fillRect(target, &mSpanData);
+    mSpanData.dx = float(source.x() - target.x());
+    mSpanData.dy = float(source.y() - target.y());
+
+    if (mClipRect.empty())
+        fillRect(target, &mSpanData, blendFunc(), blendData());
+    else
+        fillRect(target & mClipRect, &mSpanData, blendFunc(), blendData());
+    flush();
 }
 
 VPainter::VPainter(VBitmap *buffer)
 {
     begin(buffer);
 }
-bool VPainter::begin(VBitmap *buffer)
+bool VPainter::begin(VBitmap *buffer, bool clearBuffer)
 {
     mBuffer.prepare(buffer);
     mSpanData.init(&mBuffer);
     // TODO find a better api to clear the surface
-    mBuffer.clear();
+    if (clearBuffer) mBuffer.clear();
+    mClipRect = VRect();
     return true;
 }
 void VPainter::end() {}
@@ -111,6 +267,27 @@ void VPainter::setDrawRegion(const VRect &region)
     mSpanData.setDrawRegion(region);
 }
 
+void VPainter::setOrigin(const VPoint &origin)
+{
+    mSpanData.setOrigin(origin);
+}
+
+void VPainter::setClipRect(const VRect &rect)
+{
+    mClipRect = rect;
+}
+
+void VPainter::clear(const VRect &rect)
+{
+    VRect r = rect & mSpanData.clipRect();
+    if (r.empty()) return;
+
+    size_t length = size_t(r.width()) * mBuffer.bytesPerPixel();
+    for (int y = r.top(); y < r.bottom(); y++) {
+        memset(mSpanData.buffer(r.left(), y), 0, length);
+    }
+}
+
 void VPainter::setBrush(const VBrush &brush)
 {
     mSpanData.setup(brush);
@@ -121,6 +298,11 @@ void VPainter::setBlendMode(BlendMode mode)
     mSpanData.mBlendMode = mode;
 }
 
+void VPainter::setThreadCount(size_t count)
+{
+    mThreadCount = count ? count : 1;
+}
+
 VRect VPainter::clipBoundingRect() const
 {
     return mSpanData.clipRect();
@@ -27,6 +27,7 @@
 #include "vpoint.h"
 #include "vrle.h"
 #include "vdrawhelper.h"
+#include <vector>
 
 V_BEGIN_NAMESPACE
 
@@ -35,11 +36,16 @@ class VPainter {
 public:
     VPainter() = default;
     explicit VPainter(VBitmap *buffer);
-    bool  begin(VBitmap *buffer);
+    bool  begin(VBitmap *buffer, bool clearBuffer = true);
     void  end();
     void  setDrawRegion(const VRect &region); // sub surface rendering area.
+    void  setOrigin(const VPoint &origin); // drawing position of the draw region.
+    void  clear(const VRect &rect); // clears the area of the draw region.
+    void  setClipRect(const VRect &rect); // limits drawing to the area.
     void  setBrush(const VBrush &brush);
     void  setBlendMode(BlendMode mode);
+    void  setThreadCount(size_t count); // blends in bands on count threads.
+    size_t threadCount() const { return mThreadCount; }
     void  drawRle(const VPoint &pos, const VRle &rle);
     void  drawRle(const VRle &rle, const VRle &clip);
     VRect clipBoundingRect() const;
@@ -51,8 +57,20 @@ public:
 private:
     void drawBitmapUntransform(const VRect &target, const VBitmap &bitmap,
                                const VRect &source, uint8_t const_alpha);
-    VRasterBuffer mBuffer;
-    VSpanData     mSpanData;
+    VRle::VRleSpanCb blendFunc();
+    void *           blendData();
+    void             flush();
+    static void      collectSpans(size_t count, const VRle::Span *spans,
+                                  void *userData);
+    static void      countSpans(size_t count, const VRle::Span *spans,
+                                void *userData);
+
+    VRasterBuffer           mBuffer;
+    VSpanData               mSpanData;
+    VRect                   mClipRect;
+    std::vector<VRle::Span> mSpans;
+    size_t                  mPixels{0};
+    size_t                  mThreadCount{1};
 };
 
 V_END_NAMESPACE
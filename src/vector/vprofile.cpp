@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "vprofile.h"
+
+#ifdef LOTTIE_PROFILE_SUPPORT
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "vdebug.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+V_BEGIN_NAMESPACE
+
+std::atomic<bool> VTrace::mEnabled{false};
+
+namespace {
+
+struct TraceEvent {
+    const char *mName;
+    uint64_t    mBegin;
+    uint64_t    mEnd;
+};
+
+/*
+ * Events of one thread. Only the owning thread writes, it publishes an
+ * event by moving mHead past it. A ring is created by the first span the
+ * thread records while tracing and freed when the thread exits, 16K
+ * events take 384KB.
+ */
+struct TraceRing {
+    static constexpr size_t Capacity = 1 << 14;
+
+    void push(const char *name, uint64_t begin, uint64_t end)
+    {
+        size_t head = mHead.load(std::memory_order_relaxed);
+        mEvents[head & (Capacity - 1)] = {name, begin, end};
+        mHead.store(head + 1, std::memory_order_release);
+    }
+
+    std::unique_ptr<TraceEvent[]> mEvents{new TraceEvent[Capacity]};
+    std::atomic<size_t>           mHead{0};
+    std::string                   mThreadName;
+    size_t                        mTid{0};
+    bool                          mExited{false};
+};
+
+class TraceRegistry {
+public:
+    static TraceRegistry &instance()
+    {
+        static TraceRegistry singleton;
+        return singleton;
+    }
+
+    TraceRing *ring()
+    {
+        // hands the ring back when the thread exits.
+        struct Owner {
+            TraceRing *mRing{nullptr};
+            ~Owner()
+            {
+                if (mRing) TraceRegistry::instance().remove(mRing);
+            }
+        };
+        static thread_local Owner owner;
+        if (!owner.mRing) owner.mRing = add();
+        return owner.mRing;
+    }
+
+    bool start(const std::string &path)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mRunning) return false;
+        mPath = path;
+        mStart = VTraceScope::now();
+        mRunning = true;
+        return true;
+    }
+
+    bool stop();
+
+private:
+    TraceRing *add()
+    {
+        auto ring = std::make_unique<TraceRing>();
+        std::lock_guard<std::mutex> lock(mMutex);
+        ring->mTid = ++mLastTid;
+#ifdef __linux__
+        char name[16] = {};
+        if (!pthread_getname_np(pthread_self(), name, sizeof(name)))
+            ring->mThreadName = name;
+#endif
+        if (ring->mThreadName.empty())
+            ring->mThreadName = "thread-" + std::to_string(ring->mTid);
+        mRings.push_back(std::move(ring));
+        return mRings.back().get();
+    }
+
+    // a running trace still has to write the events of an exited thread.
+    void remove(TraceRing *ring)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mRunning)
+            ring->mExited = true;
+        else
+            erase([ring](const TraceRing &r) { return &r == ring; });
+    }
+
+    template <typename Pred>
+    void erase(Pred pred)
+    {
+        mRings.erase(std::remove_if(mRings.begin(), mRings.end(),
+                                    [&](const std::unique_ptr<TraceRing> &r) {
+                                        return pred(*r);
+                                    }),
+                     mRings.end());
+    }
+
+    std::mutex                              mMutex;
+    std::vector<std::unique_ptr<TraceRing>> mRings;
+    std::string                             mPath;
+    uint64_t                                mStart{0};
+    size_t                                  mLastTid{0};
+    bool                                    mRunning{false};
+};
+
+/*
+ * Writes the events recorded since start(). A thread that was recording
+ * while tracing got disabled may still overwrite the oldest slots of a
+ * full ring, those events are skipped.
+ */
+bool TraceRegistry::stop()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mRunning) return false;
+    mRunning = false;
+
+    FILE *file = fopen(mPath.c_str(), "w");
+    if (!file) {
+        vWarning << "can't write the trace to " << mPath;
+        erase([](const TraceRing &r) { return r.mExited; });
+        return false;
+    }
+
+    fprintf(file, "{\"traceEvents\":[\n");
+    const char *sep = "";
+    for (const auto &ring : mRings) {
+        fprintf(file,
+                "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                "\"tid\":%zu,\"args\":{\"name\":\"%s\"}}",
+                sep, ring->mTid, ring->mThreadName.c_str());
+        sep = ",\n";
+
+        size_t head = ring->mHead.load(std::memory_order_acquire);
+        size_t window = TraceRing::Capacity - TraceRing::Capacity / 16;
+        size_t first = head > window ? head - window : 0;
+        for (size_t i = first; i < head; i++) {
+            const auto &e = ring->mEvents[i & (TraceRing::Capacity - 1)];
+            if (e.mBegin < mStart) continue;
+            fprintf(file,
+                    "%s{\"name\":\"%s\",\"cat\":\"rlottie\",\"ph\":\"X\","
+                    "\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f}",
+                    sep, e.mName, ring->mTid,
+                    double(e.mBegin - mStart) / 1000.0,
+                    double(e.mEnd - e.mBegin) / 1000.0);
+        }
+    }
+    fprintf(file, "\n],\"displayTimeUnit\":\"ns\"}\n");
+    fclose(file);
+
+    erase([](const TraceRing &r) { return r.mExited; });
+    return true;
+}
+
+// RLOTTIE_TRACE=<file> traces from the load of the library to the exit.
+struct TraceFromEnv {
+    TraceFromEnv()
+    {
+        if (auto path = getenv("RLOTTIE_TRACE")) VTrace::start(path);
+    }
+    ~TraceFromEnv() { VTrace::stop(); }
+} traceFromEnv;
+
+}  // namespace
+
+bool VTrace::start(const std::string &path)
+{
+    if (!TraceRegistry::instance().start(path)) return false;
+    mEnabled = true;
+    return true;
+}
+
+bool VTrace::stop()
+{
+    mEnabled = false;
+    return TraceRegistry::instance().stop();
+}
+
+void VTrace::record(const char *name, uint64_t begin, uint64_t end)
+{
+    TraceRegistry::instance().ring()->push(name, begin, end);
+}
+
+V_END_NAMESPACE
+
+#endif  // LOTTIE_PROFILE_SUPPORT
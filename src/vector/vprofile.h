@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef VPROFILE_H
+#define VPROFILE_H
+
+#include "config.h"
+
+#ifdef LOTTIE_PROFILE_SUPPORT
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include "vglobal.h"
+
+V_BEGIN_NAMESPACE
+
+/*
+ * Records spans of the rendering pipeline and writes them as Chrome trace
+ * events (chrome://tracing, ui.perfetto.dev). Every thread writes into its
+ * own ring buffer, recording a span never takes a lock. The rings keep
+ * the last events of every thread, older ones are overwritten.
+ * Setting RLOTTIE_TRACE=<file> traces the whole process.
+ */
+class VTrace {
+public:
+    static bool enabled() { return mEnabled.load(std::memory_order_relaxed); }
+    static bool start(const std::string &path);
+    static bool stop();
+    static void record(const char *name, uint64_t begin, uint64_t end);
+
+private:
+    static std::atomic<bool> mEnabled;
+};
+
+class VTraceScope {
+public:
+    explicit VTraceScope(const char *name)
+        : mName(VTrace::enabled() ? name : nullptr)
+    {
+        if (mName) mBegin = now();
+    }
+    ~VTraceScope()
+    {
+        if (mName) VTrace::record(mName, mBegin, now());
+    }
+    VTraceScope(const VTraceScope &) = delete;
+    VTraceScope &operator=(const VTraceScope &) = delete;
+
+    static uint64_t now()
+    {
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now().time_since_epoch())
+                            .count());
+    }
+
+private:
+    const char *mName;
+    uint64_t    mBegin{0};
+};
+
+/*
+ * Counters of one frame. The thread rendering the frame makes it current,
+ * work handed over to other threads carries the pointer along and makes
+ * it current there while it runs.
+ */
+struct VFrameProfile {
+    enum Stage { Update, Path, Raster, Blend, StageCount };
+
+    VFrameProfile() { reset(); }
+
+    void reset()
+    {
+        for (auto &t : mTime) t = 0;
+        mFrameTime = 0;
+        mDrawables = 0;
+        mSpans = 0;
+        mPixels = 0;
+        mSurfaces = 0;
+        mSurfaceAllocs = 0;
+        mSurfaceHits = 0;
+        mSurfaceReleases = 0;
+        mCulledLayers = 0;
+        mCulledDrawables = 0;
+        mRleMattes = 0;
+    }
+
+    static uint64_t now() { return VTraceScope::now(); }
+
+    static VFrameProfile *&current()
+    {
+        static thread_local VFrameProfile *profile = nullptr;
+        return profile;
+    }
+
+    // makes a profile current for the lifetime of the object.
+    class Current {
+    public:
+        explicit Current(VFrameProfile *profile) : mPrev(current())
+        {
+            current() = profile;
+        }
+        ~Current() { current() = mPrev; }
+
+    private:
+        VFrameProfile *mPrev;
+    };
+
+    std::atomic<uint64_t> mTime[StageCount];  // nanoseconds
+    std::atomic<uint64_t> mFrameTime;
+    std::atomic<size_t>   mDrawables;
+    std::atomic<size_t>   mSpans;
+    std::atomic<size_t>   mPixels;
+    std::atomic<size_t>   mSurfaces;
+    std::atomic<size_t>   mSurfaceAllocs;
+    std::atomic<size_t>   mSurfaceHits;
+    std::atomic<size_t>   mSurfaceReleases;
+    std::atomic<size_t>   mCulledLayers;
+    std::atomic<size_t>   mCulledDrawables;
+    std::atomic<size_t>   mRleMattes;
+};
+
+/*
+ * Adds the time spent in the enclosing block to a stage of the current
+ * profile. Nested scopes pause the outer one, so the stage times never
+ * count the same time twice on a thread.
+ */
+class VProfileScope {
+public:
+    explicit VProfileScope(VFrameProfile::Stage stage)
+        : mProfile(VFrameProfile::current()), mStage(stage)
+    {
+        if (!mProfile) return;
+        mStart = VFrameProfile::now();
+        mParent = active();
+        if (mParent) mParent->pause(mStart);
+        active() = this;
+    }
+    ~VProfileScope()
+    {
+        if (!mProfile) return;
+        uint64_t end = VFrameProfile::now();
+        pause(end);
+        active() = mParent;
+        if (mParent) mParent->mStart = end;
+    }
+    VProfileScope(const VProfileScope &) = delete;
+    VProfileScope &operator=(const VProfileScope &) = delete;
+
+private:
+    void pause(uint64_t time) { mProfile->mTime[mStage] += time - mStart; }
+
+    static VProfileScope *&active()
+    {
+        static thread_local VProfileScope *scope = nullptr;
+        return scope;
+    }
+
+    VFrameProfile *     mProfile;
+    VFrameProfile::Stage mStage;
+    uint64_t            mStart{0};
+    VProfileScope *     mParent{nullptr};
+};
+
+V_END_NAMESPACE
+
+#define VPROFILE_SCOPE(stage) \
+    VProfileScope vProfileScope_(VFrameProfile::stage)
+
+#define VPROFILE_COUNT(counter, n)                                   \
+    do {                                                             \
+        if (auto vProfile_ = VFrameProfile::current())               \
+            vProfile_->counter += (n);                               \
+    } while (0)
+
+#define VTRACE_SCOPE(name) VTraceScope vTraceScope_(name)
+
+#else
+
+#define VPROFILE_SCOPE(stage)
+#define VPROFILE_COUNT(counter, n)
+#define VTRACE_SCOPE(name)
+
+#endif  // LOTTIE_PROFILE_SUPPORT
+
+#endif  // VPROFILE_H
@@ -20,6 +20,7 @@
  * SOFTWARE.
  */
 #include "vraster.h"
+#include <algorithm>
 #include <climits>
 #include <cstring>
 #include <memory>
@@ -28,7 +29,9 @@
 #include "v_ft_stroker.h"
 #include "vdebug.h"
 #include "vmatrix.h"
+#include "vmemory.h"
 #include "vpath.h"
+#include "vprofile.h"
 #include "vrle.h"
 
 V_BEGIN_NAMESPACE
@@ -46,7 +49,13 @@ public:
         mCapacity = size;
         mData = std::make_unique<T[]>(mCapacity);
     }
+    void release(size_t size)
+    {
+        mCapacity = size;
+        mData = std::make_unique<T[]>(mCapacity);
+    }
     T *        data() const { return mData.get(); }
+    size_t     capacity() const { return mCapacity; }
     dyn_array &operator=(dyn_array &&) noexcept = delete;
 
 private:
@@ -58,6 +67,8 @@ struct FTOutline {
 public:
     void reset();
     void grow(size_t, size_t);
+    void release();
+    size_t memoryUsage() const;
     void convert(const VPath &path);
     void convert(CapStyle, JoinStyle, float, float);
     void moveTo(const VPointF &pt);
@@ -88,6 +99,22 @@ void FTOutline::reset()
     ft.flags = 0x0;
 }
 
+void FTOutline::release()
+{
+    reset();
+    mPointMemory.release(100);
+    mTagMemory.release(100);
+    mContourMemory.release(10);
+    mContourFlagMemory.release(10);
+}
+
+size_t FTOutline::memoryUsage() const
+{
+    return mPointMemory.capacity() * sizeof(SW_FT_Vector) +
+           mTagMemory.capacity() + mContourMemory.capacity() * sizeof(int) +
+           mContourFlagMemory.capacity();
+}
+
 void FTOutline::grow(size_t points, size_t segments)
 {
     reset();
@@ -258,6 +285,7 @@ static void rleGenerationCb(int count, const SW_FT_Span *spans, void *user)
     VRle *rle = static_cast<VRle *>(user);
     auto *rleSpan = reinterpret_cast<const VRle::Span *>(spans);
     rle->addSpan(rleSpan, count);
+    VPROFILE_COUNT(mSpans, size_t(count));
 }
 
 static void bboxCb(int x, int y, int w, int h, void *user)
@@ -272,10 +300,10 @@ public:
     VRle &unsafe() { return _rle; }
     void  notify()
     {
-        {
-            std::lock_guard<std::mutex> lock(_mutex);
-            _ready = true;
-        }
+        // notify while holding the lock, once wait() returns the owner
+        // is free to destroy this object.
+        std::lock_guard<std::mutex> lock(_mutex);
+        _ready = true;
         _cv.notify_one();
     }
     void wait()
@@ -284,7 +312,10 @@ public:
 
         {
             std::unique_lock<std::mutex> lock(_mutex);
-            while (!_ready) _cv.wait(lock);
+            if (!_ready) {
+                VTRACE_SCOPE("rle wait");
+                while (!_ready) _cv.wait(lock);
+            }
         }
 
         _pending = false;
@@ -311,7 +342,91 @@ private:
     bool                    _pending{false};
 };
 
+/*
+ * Reports the scratch buffers of all the rle workers. The buffers belong
+ * to the worker threads, so a trim only bumps the epoch and every worker
+ * drops its buffers before it runs the next task.
+ */
+class RasterizerMemory : public VMemoryClient {
+public:
+    static RasterizerMemory &instance()
+    {
+        static RasterizerMemory singleton;
+        return singleton;
+    }
+
+    void usage(VMemoryUsage &usage) const override
+    {
+        usage.rasterizer += mBytes.load(std::memory_order_relaxed);
+    }
+    void     trim(VTrimLevel) override { ++mEpoch; }
+    uint32_t epoch() const { return mEpoch.load(std::memory_order_relaxed); }
+    // called by the rle threads, only takes note for the next enforce().
+    void     update(size_t oldBytes, size_t newBytes)
+    {
+        mBytes += newBytes;
+        mBytes -= oldBytes;
+        if (newBytes > oldBytes) VMemoryBudget::instance().grew();
+    }
+
+private:
+    RasterizerMemory() { VMemoryBudget::instance().add(this); }
+    ~RasterizerMemory() override { VMemoryBudget::instance().remove(this); }
+
+    std::atomic<size_t>   mBytes{0};
+    std::atomic<uint32_t> mEpoch{0};
+};
+
+/*
+ * per thread scratch objects used to generate the rle.
+ */
+struct RleWorker {
+    FTOutline     mOutline;
+    SW_FT_Stroker mStroker;
+    size_t        mStrokerPoints{0};
+    size_t        mBytes{0};
+    uint32_t      mEpoch;
+
+    RleWorker() : mEpoch(RasterizerMemory::instance().epoch())
+    {
+        SW_FT_Stroker_New(&mStroker);
+        publish();
+    }
+    ~RleWorker()
+    {
+        SW_FT_Stroker_Done(mStroker);
+        RasterizerMemory::instance().update(mBytes, 0);
+    }
+    RleWorker(const RleWorker &) = delete;
+    RleWorker &operator=(const RleWorker &) = delete;
+
+    // drop the buffers if a trim happened since the last task.
+    void prepare()
+    {
+        uint32_t epoch = RasterizerMemory::instance().epoch();
+        if (epoch == mEpoch) return;
+        mEpoch = epoch;
+        mOutline.release();
+        SW_FT_Stroker_Done(mStroker);
+        SW_FT_Stroker_New(&mStroker);
+        mStrokerPoints = 0;
+        publish();
+    }
+
+    // the stroker keeps its border storage private, estimate it from the
+    // largest outline it exported.
+    void publish()
+    {
+        size_t bytes = mOutline.memoryUsage() +
+                       mStrokerPoints * (sizeof(SW_FT_Vector) + 1);
+        if (bytes == mBytes) return;
+        RasterizerMemory::instance().update(mBytes, bytes);
+        mBytes = bytes;
+    }
+};
+
 struct VRleTask {
+    VRleTask *mNext{nullptr};  // intrusive link used by the scheduler
     SharedRle mRle;
     VPath     mPath;
     float     mStrokeWidth;
@@ -321,6 +436,9 @@ struct VRleTask {
     CapStyle  mCap;
     JoinStyle mJoin;
     bool      mGenerateStroke;
+#ifdef LOTTIE_PROFILE_SUPPORT
+    VFrameProfile *mProfile{nullptr};  // profile of the frame that asked
+#endif
 
     VRle &rle() { return mRle.get(); }
 
@@ -369,10 +487,30 @@ struct VRleTask {
         sw_ft_grays_raster.raster_render(nullptr, &params);
     }
 
-    void operator()(FTOutline &outRef, SW_FT_Stroker &stroker)
+    void operator()(RleWorker &worker)
+    {
+        generate(worker);
+        // the task can go away as soon as it notified.
+        mRle.notify();
+        worker.publish();
+    }
+
+    void generate(RleWorker &worker)
     {
+#ifdef LOTTIE_PROFILE_SUPPORT
+        VFrameProfile::Current profile(mProfile);
+#endif
+        VPROFILE_SCOPE(Raster);
+        VTRACE_SCOPE(mGenerateStroke ? "stroke" : "rasterize");
+
+        worker.prepare();
+
+        FTOutline &    outRef = worker.mOutline;
+        SW_FT_Stroker &stroker = worker.mStroker;
+
         if (mPath.points().size() > SHRT_MAX ||
             mPath.points().size() + mPath.segments() > SHRT_MAX) {
+            mRle.unsafe().reset();
             return;
         }
 
@@ -388,6 +526,8 @@ struct VRleTask {
             SW_FT_Stroker_GetCounts(stroker, &points, &contors);
 
             outRef.grow(points, contors);
+            worker.mStrokerPoints =
+                std::max<size_t>(worker.mStrokerPoints, points);
 
             SW_FT_Stroker_Export(stroker, &outRef.ft);
 
@@ -408,74 +548,25 @@ struct VRleTask {
         render(outRef);
 
         mPath = VPath();
-
-        mRle.notify();
     }
 };
 
-using VTask = std::shared_ptr<VRleTask>;
-
 #ifdef LOTTIE_THREAD_SUPPORT
 
-#include <thread>
-#include "vtaskqueue.h"
-
-#ifdef __linux__
-#include <pthread.h>
-#include <sstream>
-#endif
+#include "vtaskscheduler.h"
 
+/*
+ * The tasks live inside VRasterizerImpl and are handed to the scheduler
+ * as raw pointers, VRasterizerImpl waits for its task to finish before it
+ * goes away so submitting a task never allocates.
+ */
 class RleTaskScheduler {
-    const unsigned                _count{std::thread::hardware_concurrency()};
-    std::vector<std::thread>      _threads;
-    std::vector<TaskQueue<VTask>> _q{_count};
-    std::atomic<unsigned>         _index{0};
-
-    void run(unsigned i)
-    {
-        /*
-         * initalize  per thread objects.
-         */
-        FTOutline     outlineRef;
-        SW_FT_Stroker stroker;
-        SW_FT_Stroker_New(&stroker);
-
-        // Create Thread Name for Debugging (Linux)
-#ifdef __linux__
-        std::ostringstream nameStream;
-        nameStream << "lottie-tsk-" << i;
-        pthread_setname_np(pthread_self(), nameStream.str().c_str());
-#endif
-
-        // Task Loop
-        VTask task;
-        while (true) {
-            bool success = false;
-
-            for (unsigned n = 0; n != _count * 2; ++n) {
-                if (_q[(i + n) % _count].try_pop(task)) {
-                    success = true;
-                    break;
-                }
-            }
+    // constructed first so it outlives the workers.
+    RasterizerMemory &_memory{RasterizerMemory::instance()};
+    VTaskScheduler<VRleTask, RleWorker> _scheduler{
+        std::thread::hardware_concurrency(), "lottie-tsk"};
 
-            if (!success && !_q[i].pop(task)) break;
-
-            (*task)(outlineRef, stroker);
-        }
-
-        // cleanup
-        SW_FT_Stroker_Done(stroker);
-    }
-
-    RleTaskScheduler()
-    {
-        for (unsigned n = 0; n != _count; ++n) {
-            _threads.emplace_back([&, n] { run(n); });
-        }
-
-        IsRunning = true;
-    }
+    RleTaskScheduler() { IsRunning = true; }
 
 public:
     static bool IsRunning;
@@ -492,32 +583,17 @@ public:
     {
         if (IsRunning) {
             IsRunning = false;
-
-            for (auto &e : _q) e.done();
-            for (auto &e : _threads) e.join();
+            _scheduler.stop();
         }
     }
 
-    void process(VTask task)
-    {
-        auto i = _index++;
-
-        for (unsigned n = 0; n != _count; ++n) {
-            if (_q[(i + n) % _count].try_push(std::move(task))) return;
-        }
-
-        if (_count > 0) {
-            _q[i % _count].push(std::move(task));
-        }
-    }
+    void process(VRleTask *task) { _scheduler.submit(task); }
 };
 
 #else
 
 class RleTaskScheduler {
-public:
-    FTOutline     outlineRef{};
-    SW_FT_Stroker stroker;
+    RleWorker worker;
 
 public:
     static bool IsRunning;
@@ -530,11 +606,7 @@ public:
 
     void stop() {}
 
-    RleTaskScheduler() { SW_FT_Stroker_New(&stroker); }
-
-    ~RleTaskScheduler() { SW_FT_Stroker_Done(stroker); }
-
-    void process(VTask task) { (*task)(outlineRef, stroker); }
+    void process(VRleTask *task) { (*task)(worker); }
 };
 #endif
 
@@ -543,6 +615,8 @@ bool RleTaskScheduler::IsRunning{false};
 struct VRasterizer::VRasterizerImpl {
     VRleTask mTask;
 
+    ~VRasterizerImpl() { mTask.mRle.wait(); }
+
     VRle &    rle() { return mTask.rle(); }
     VRleTask &task() { return mTask; }
 };
@@ -560,8 +634,10 @@ void VRasterizer::init()
 
 void VRasterizer::updateRequest()
 {
-    VTask taskObj = VTask(d, &d->task());
-    RleTaskScheduler::instance().process(std::move(taskObj));
+#ifdef LOTTIE_PROFILE_SUPPORT
+    d->task().mProfile = VFrameProfile::current();
+#endif
+    RleTaskScheduler::instance().process(&d->task());
 }
 
 void VRasterizer::rasterize(VPath path, FillRule fillRule, const VRect &clip)
@@ -22,6 +22,7 @@
 
 #ifndef VRECT_H
 #define VRECT_H
+#include <algorithm>
 #include "vglobal.h"
 #include "vpoint.h"
 
@@ -62,6 +63,7 @@ public:
 
     VRect intersected(const VRect &r) const;
     VRect operator&(const VRect &r) const;
+    VRect operator|(const VRect &r) const;
 
 private:
     int x1{0};
@@ -75,6 +77,16 @@ inline VRect VRect::intersected(const VRect &r) const
     return *this & r;
 }
 
+inline VRect VRect::operator|(const VRect &r) const
+{
+    if (empty()) return r;
+    if (r.empty()) return *this;
+
+    return {std::min(x1, r.x1), std::min(y1, r.y1),
+            std::max(x2, r.x2) - std::min(x1, r.x1),
+            std::max(y2, r.y2) - std::min(y1, r.y1)};
+}
+
 inline bool VRect::intersects(const VRect &r)
 {
     return (right() > r.left() && left() < r.right() && bottom() > r.top() &&
@@ -47,7 +47,7 @@ static inline uint8_t divBy255(int x)
 }
 
 inline static void copy(const VRle::Span *span, size_t count,
-                        std::vector<VRle::Span> &v)
+                        std::vector<VRle::Span, VRleAllocator<VRle::Span>> &v)
 {
     // make sure enough memory available
     if (v.capacity() < v.size() + count) v.reserve(v.size() + count);
@@ -119,6 +119,21 @@ void VRle::Data::addRect(const VRect &rect)
     mBbox = rect;
 }
 
+uint64_t VRle::Data::hash() const
+{
+    // hash the span fields one by one as Span has padding bytes.
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (const auto &span : mSpans) {
+        uint64_t v = uint64_t(uint16_t(span.x)) |
+                     (uint64_t(uint16_t(span.y)) << 16) |
+                     (uint64_t(span.len) << 32) |
+                     (uint64_t(span.coverage) << 48);
+        h = (h ^ v) * 0x9e3779b97f4a7c15ull;
+        h ^= h >> 32;
+    }
+    return h;
+}
+
 void VRle::Data::updateBbox() const
 {
     if (!mBboxDirty) return;
@@ -300,7 +315,7 @@ void VRle::Data::opIntersect(VRle::View a, VRle::View b)
         if (count) copy(result.data(), count, mSpans);
     }
 
-    updateBbox();
+    mBboxDirty = true;
 }
 
 static void _opIntersect(rle_view a, rle_view b, VRle::VRleSpanCb cb,
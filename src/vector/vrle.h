@@ -26,6 +26,7 @@
 #include <vector>
 #include "vcowptr.h"
 #include "vglobal.h"
+#include "vmemory.h"
 #include "vpoint.h"
 #include "vrect.h"
 
@@ -43,6 +44,7 @@ public:
                                 void *userData);
     bool  empty() const { return d->empty(); }
     VRect boundingRect() const { return d->bbox(); }
+    uint64_t hash() const { return d->hash(); }
     void  setBoundingRect(const VRect &bbox) { d->setBbox(bbox); }
     void  addSpan(const VRle::Span *span, size_t count)
     {
@@ -98,8 +100,9 @@ public:
         void  opIntersect(const VRect &, VRle::VRleSpanCb, void *) const;
         void  addRect(const VRect &rect);
         void  clone(const VRle::Data &);
+        uint64_t hash() const;
 
-        std::vector<VRle::Span> mSpans;
+        std::vector<VRle::Span, VRleAllocator<VRle::Span>> mSpans;
         VPoint                  mOffset;
         mutable VRect           mBbox;
         mutable bool            mBboxDirty = true;
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "vtaskpool.h"
+#include "config.h"
+
+#ifdef LOTTIE_THREAD_SUPPORT
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sstream>
+#endif
+
+namespace {
+
+struct Batch {
+    const std::function<void(size_t)> *mJob;
+    size_t                             mCount;
+    std::atomic<size_t>                mNext{0};
+    std::atomic<size_t>                mDone{0};
+    std::mutex                         mMutex;
+    std::condition_variable            mFinished;
+
+    Batch(const std::function<void(size_t)> &job, size_t count)
+        : mJob(&job), mCount(count)
+    {
+    }
+
+    // runs jobs till there is none left, returns false if it got none.
+    bool work()
+    {
+        bool worked = false;
+        size_t i;
+        while ((i = mNext++) < mCount) {
+            (*mJob)(i);
+            worked = true;
+            if (++mDone == mCount) {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mFinished.notify_all();
+            }
+        }
+        return worked;
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while (mDone != mCount) mFinished.wait(lock);
+    }
+};
+
+using BatchPtr = std::shared_ptr<Batch>;
+
+class TaskPool {
+    static constexpr size_t  MaxThreads = 64;
+    std::vector<std::thread> _threads;
+    std::deque<BatchPtr>     _q;
+    std::mutex               _mutex;
+    std::condition_variable  _ready;
+    bool                     _done{false};
+
+    void run(size_t i)
+    {
+#ifdef __linux__
+        std::ostringstream nameStream;
+        nameStream << "lottie-blend-" << i;
+        pthread_setname_np(pthread_self(), nameStream.str().c_str());
+#else
+        (void)i;
+#endif
+        while (true) {
+            BatchPtr batch;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                while (_q.empty() && !_done) _ready.wait(lock);
+                if (_q.empty()) return;
+                batch = _q.front();
+            }
+            // the batch is out of jobs, drop it from the queue.
+            if (!batch->work()) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (!_q.empty() && _q.front() == batch) _q.pop_front();
+            }
+        }
+    }
+
+    void grow(size_t count)
+    {
+        count = std::min(count, MaxThreads);
+        while (_threads.size() < count) {
+            auto n = _threads.size();
+            _threads.emplace_back([this, n] { run(n); });
+        }
+    }
+
+public:
+    static TaskPool &instance()
+    {
+        static TaskPool singleton;
+        return singleton;
+    }
+
+    ~TaskPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _done = true;
+        }
+        _ready.notify_all();
+        for (auto &e : _threads) e.join();
+    }
+
+    void process(size_t count, const std::function<void(size_t)> &job)
+    {
+        auto batch = std::make_shared<Batch>(job, count);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            grow(count - 1);
+            _q.push_back(batch);
+        }
+        _ready.notify_all();
+
+        batch->work();
+        batch->wait();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto it = _q.begin(); it != _q.end(); ++it) {
+            if (*it == batch) {
+                _q.erase(it);
+                break;
+            }
+        }
+    }
+};
+
+constexpr size_t TaskPool::MaxThreads;
+
+}  // namespace
+
+void VTaskPool::run(size_t count, const std::function<void(size_t)> &job)
+{
+    if (count == 0) return;
+
+    if (count == 1) {
+        job(0);
+        return;
+    }
+
+    TaskPool::instance().process(count, job);
+}
+
+#else
+
+void VTaskPool::run(size_t count, const std::function<void(size_t)> &job)
+{
+    for (size_t i = 0; i < count; i++) job(i);
+}
+
+#endif
@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef VTASKSCHEDULER_H
+#define VTASKSCHEDULER_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "vglobal.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <string>
+#endif
+
+V_BEGIN_NAMESPACE
+
+/*
+ * Fixed size Chase-Lev work stealing deque of task pointers.
+ * Only the owning thread calls push() and pop() which work on the bottom
+ * end, any thread may steal() from the top end.
+ */
+template <typename Task, size_t Capacity = 1024>
+class VWorkDeque {
+    static_assert((Capacity & (Capacity - 1)) == 0,
+                  "capacity must be a power of 2");
+    static constexpr int64_t Mask = Capacity - 1;
+
+public:
+    bool push(Task *task)
+    {
+        int64_t b = _bottom.load(std::memory_order_relaxed);
+        int64_t t = _top.load(std::memory_order_acquire);
+        if (b - t >= int64_t(Capacity)) return false;
+
+        _buf[b & Mask].store(task, std::memory_order_relaxed);
+        _bottom.store(b + 1, std::memory_order_release);
+        return true;
+    }
+
+    Task *pop()
+    {
+        int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+        _bottom.store(b, std::memory_order_seq_cst);
+        int64_t t = _top.load(std::memory_order_seq_cst);
+
+        if (t > b) {
+            _bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        Task *task = _buf[b & Mask].load(std::memory_order_relaxed);
+        if (t == b) {
+            // last element, race against the thieves for it.
+            if (!_top.compare_exchange_strong(t, t + 1,
+                                              std::memory_order_seq_cst,
+                                              std::memory_order_relaxed))
+                task = nullptr;
+            _bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return task;
+    }
+
+    Task *steal()
+    {
+        int64_t t = _top.load(std::memory_order_seq_cst);
+        int64_t b = _bottom.load(std::memory_order_seq_cst);
+        if (t >= b) return nullptr;
+
+        Task *task = _buf[t & Mask].load(std::memory_order_relaxed);
+        if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed))
+            return nullptr;
+        return task;
+    }
+
+    bool empty() const
+    {
+        return _top.load(std::memory_order_relaxed) >=
+               _bottom.load(std::memory_order_relaxed);
+    }
+
+private:
+    alignas(64) std::atomic<int64_t> _top{0};
+    alignas(64) std::atomic<int64_t> _bottom{0};
+    std::atomic<Task *> _buf[Capacity]{};
+};
+
+/*
+ * Lock free list where any thread can push a task and a worker takes the
+ * whole content at once, so there is no ABA problem. Tasks are linked
+ * through their mNext member.
+ */
+template <typename Task>
+class VTaskStack {
+public:
+    void push(Task *first, Task *last)
+    {
+        Task *head = _head.load(std::memory_order_relaxed);
+        do {
+            last->mNext = head;
+        } while (!_head.compare_exchange_weak(head, first,
+                                              std::memory_order_seq_cst,
+                                              std::memory_order_relaxed));
+    }
+
+    // returns the tasks in the order they were pushed.
+    Task *takeAll()
+    {
+        if (empty()) return nullptr;
+        Task *head = _head.exchange(nullptr, std::memory_order_seq_cst);
+        Task *list = nullptr;
+        while (head) {
+            Task *next = head->mNext;
+            head->mNext = list;
+            list = head;
+            head = next;
+        }
+        return list;
+    }
+
+    bool empty() const
+    {
+        return _head.load(std::memory_order_seq_cst) == nullptr;
+    }
+
+private:
+    std::atomic<Task *> _head{nullptr};
+};
+
+/*
+ * Work stealing thread pool for fire and forget tasks.
+ * Task is an intrusive type with a `Task *mNext` member and a
+ * `void operator()(Worker &)`, the scheduler never owns or allocates
+ * tasks, the caller keeps the task alive until it signals completion.
+ * Worker holds the per thread state and is created on each worker thread.
+ *
+ * submit() pushes on a shared lock free list. An idle worker moves the
+ * whole list into its own deque and wakes up a sleeping worker which then
+ * steals from it, so a burst of small tasks is spread with a handful of
+ * atomic operations and no lock. The mutex is only taken to put a worker
+ * to sleep or to wake one up.
+ */
+template <typename Task, typename Worker>
+class VTaskScheduler {
+public:
+    explicit VTaskScheduler(unsigned count, const char *name = "vtask")
+        : _deques(std::max(count, 1u))
+    {
+        for (unsigned n = 0; n != _deques.size(); ++n) {
+            _threads.emplace_back([this, n, name] { run(n, name); });
+        }
+    }
+
+    ~VTaskScheduler() { stop(); }
+
+    void submit(Task *task)
+    {
+        _inject.push(task, task);
+        wake();
+    }
+
+    // finishes the pending tasks and joins the worker threads.
+    void stop()
+    {
+        if (_threads.empty()) return;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop.store(true);
+        }
+        _cv.notify_all();
+        for (auto &e : _threads) e.join();
+        _threads.clear();
+    }
+
+private:
+    using Deque = VWorkDeque<Task>;
+
+    void wake()
+    {
+        _epoch.fetch_add(1, std::memory_order_seq_cst);
+        if (_sleepers.load(std::memory_order_seq_cst)) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _cv.notify_one();
+        }
+    }
+
+    // moves the submitted tasks to the deque of worker i.
+    Task *grab(Deque &own)
+    {
+        Task *task = _inject.takeAll();
+        if (!task) return nullptr;
+
+        Task *next = task->mNext;
+        bool  shared = false;
+        while (next) {
+            Task *cur = next;
+            next = cur->mNext;
+            if (!own.push(cur)) {
+                // deque is full, hand the rest back.
+                Task *last = cur;
+                while (last->mNext) last = last->mNext;
+                _inject.push(cur, last);
+                break;
+            }
+            shared = true;
+        }
+        if (shared) wake();
+        return task;
+    }
+
+    Task *steal(unsigned i)
+    {
+        size_t count = _deques.size();
+        for (size_t n = 1; n < count; ++n) {
+            if (Task *task = _deques[(i + n) % count].steal()) return task;
+        }
+        return nullptr;
+    }
+
+    bool hasWork() const
+    {
+        if (!_inject.empty()) return true;
+        for (const auto &e : _deques)
+            if (!e.empty()) return true;
+        return false;
+    }
+
+    // returns false when the worker should exit.
+    bool idle()
+    {
+        _sleepers.fetch_add(1, std::memory_order_seq_cst);
+        auto epoch = _epoch.load(std::memory_order_seq_cst);
+        if (!hasWork()) {
+            std::unique_lock<std::mutex> lock(_mutex);
+            while (epoch == _epoch.load(std::memory_order_seq_cst) &&
+                   !_stop.load())
+                _cv.wait(lock);
+        }
+        _sleepers.fetch_sub(1, std::memory_order_seq_cst);
+        return !_stop.load() || !_inject.empty();
+    }
+
+    void run(unsigned i, const char *name)
+    {
+#ifdef __linux__
+        std::string threadName = std::string(name) + "-" + std::to_string(i);
+        pthread_setname_np(pthread_self(), threadName.substr(0, 15).c_str());
+#else
+        (void)name;
+#endif
+        Worker worker;
+        Deque &own = _deques[i];
+
+        while (true) {
+            Task *task = own.pop();
+            if (!task) task = grab(own);
+            if (!task) task = steal(i);
+            if (!task) {
+                // a short spin hides the wakeup latency of back to back
+                // submissions.
+                for (int n = 0; n < 64 && !task; ++n) {
+                    std::this_thread::yield();
+                    task = grab(own);
+                    if (!task) task = steal(i);
+                }
+            }
+            if (task) {
+                (*task)(worker);
+                continue;
+            }
+            if (!idle()) break;
+        }
+    }
+
+    std::vector<Deque>       _deques;
+    std::vector<std::thread> _threads;
+    VTaskStack<Task>         _inject;
+    std::atomic<uint32_t>    _epoch{0};
+    std::atomic<uint32_t>    _sleepers{0};
+    std::atomic<bool>        _stop{false};
+    std::mutex               _mutex;
+    std::condition_variable  _cv;
+};
+
+V_END_NAMESPACE
+
+#endif  // VTASKSCHEDULER_H
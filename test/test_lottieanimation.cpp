@@ -1,5 +1,14 @@
 #include <gtest/gtest.h>
+#include "config.h"
 #include "rlottie.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 class AnimationTest : public ::testing::Test {
 public:
@@ -15,9 +24,45 @@ public:
     {
 
     }
+
+    // loads a resource uncached as the animation and as its reference.
+    void load(const std::string &name)
+    {
+        std::string filePath = std::string(DEMO_DIR) + name;
+        animation = rlottie::Animation::loadFromFile(filePath, false);
+        reference = rlottie::Animation::loadFromFile(filePath, false);
+        ASSERT_TRUE(animation != nullptr);
+        ASSERT_TRUE(reference != nullptr);
+    }
+
+    static std::vector<uint32_t> render(rlottie::Animation &animation,
+                                        size_t frame, size_t width = 100,
+                                        size_t height = 100)
+    {
+        std::vector<uint32_t> buffer(width * height);
+        animation.renderSync(frame, rlottie::Surface(buffer.data(), width,
+                                                     height, width * 4));
+        return buffer;
+    }
+
+    // largest difference of a channel between two renders.
+    static int maxDiff(const std::vector<uint32_t> &a,
+                       const std::vector<uint32_t> &b)
+    {
+        int diff = 0;
+        for (size_t i = 0; i < a.size(); i++) {
+            for (int shift = 0; shift < 32; shift += 8) {
+                int ca = (a[i] >> shift) & 0xff;
+                int cb = (b[i] >> shift) & 0xff;
+                diff = std::max(diff, std::abs(ca - cb));
+            }
+        }
+        return diff;
+    }
 public:
     std::unique_ptr<rlottie::Animation> animationInvalid;
     std::unique_ptr<rlottie::Animation> animation;
+    std::unique_ptr<rlottie::Animation> reference;
 };
 
 TEST_F(AnimationTest, loadFromFile_N) {
@@ -32,3 +77,592 @@ TEST_F(AnimationTest, loadFromFile) {
     ASSERT_EQ(width, 500);
     ASSERT_EQ(height, 500);
 }
+
+TEST_F(AnimationTest, binaryRoundTrip) {
+    ASSERT_TRUE(animation != nullptr);
+    std::string binaryPath = "rlottie_test_mask.bin";
+    ASSERT_TRUE(animation->saveBinary(binaryPath));
+
+    auto binary = rlottie::Animation::loadFromBinary(binaryPath, false);
+    ASSERT_TRUE(binary != nullptr);
+    ASSERT_EQ(binary->totalFrame(), animation->totalFrame());
+    ASSERT_EQ(binary->frameRate(), animation->frameRate());
+
+    ASSERT_EQ(render(*animation, 10), render(*binary, 10));
+    std::remove(binaryPath.c_str());
+}
+
+TEST_F(AnimationTest, loadFromBinary_N) {
+    std::string filePath = DEMO_DIR;
+    filePath +="mask.json";
+    ASSERT_FALSE(rlottie::Animation::loadFromBinary(filePath, false));
+    ASSERT_FALSE(rlottie::Animation::loadFromBinary("wrong_file.bin", false));
+}
+
+TEST_F(AnimationTest, loadFromBuffer) {
+    std::string json = "{\"v\":\"5.5.2\",\"fr\":30,\"ip\":0,\"op\":30,"
+                       "\"w\":100,\"h\":100,\"layers\":[]}";
+    auto data = std::make_unique<char[]>(json.size() + 1);
+    memcpy(data.get(), json.c_str(), json.size() + 1);
+    auto buffered = rlottie::Animation::loadFromData(std::move(data), json.size() + 1,
+                                                     "loadFromBuffer", "", false);
+    ASSERT_TRUE(buffered != nullptr);
+    ASSERT_EQ(buffered->frameRate(), 30);
+
+    // buffer without terminator
+    data = std::make_unique<char[]>(json.size());
+    memcpy(data.get(), json.c_str(), json.size());
+    buffered = rlottie::Animation::loadFromData(std::move(data), json.size(),
+                                                "loadFromBuffer", "", false);
+    ASSERT_TRUE(buffered != nullptr);
+}
+
+TEST_F(AnimationTest, modelCacheLru) {
+    std::string dir = DEMO_DIR;
+    rlottie::configureModelCacheSize(0);
+    rlottie::configureModelCacheSize(2);
+
+    auto start = rlottie::modelCacheStats();
+    rlottie::Animation::loadFromFile(dir + "mask.json");
+    rlottie::Animation::loadFromFile(dir + "3d.json");
+    rlottie::Animation::loadFromFile(dir + "mask.json");
+    rlottie::Animation::loadFromFile(dir + "anubis.json");
+    auto stats = rlottie::modelCacheStats();
+    ASSERT_EQ(stats.hits - start.hits, 1);
+    ASSERT_EQ(stats.misses - start.misses, 3);
+    ASSERT_EQ(stats.evictions - start.evictions, 1);
+    ASSERT_EQ(stats.entries, 2);
+    ASSERT_GT(stats.bytes, 0);
+
+    // 3d.json was the least recently used entry.
+    rlottie::Animation::loadFromFile(dir + "mask.json");
+    ASSERT_EQ(rlottie::modelCacheStats().hits - stats.hits, 1);
+
+    rlottie::configureModelCacheBudget(1);
+    ASSERT_EQ(rlottie::modelCacheStats().entries, 0);
+    ASSERT_EQ(rlottie::modelCacheStats().bytes, 0);
+
+    rlottie::configureModelCacheBudget(0);
+    rlottie::configureModelCacheSize(10);
+}
+
+TEST_F(AnimationTest, frameCache) {
+    ASSERT_TRUE(animation != nullptr);
+    animation->setFrameCacheBudget(1024 * 1024);
+
+    std::vector<uint32_t> expected(100 * 100), result(100 * 100);
+    for (size_t i = 0; i < animation->totalFrame(); i++) {
+        animation->renderSync(i, rlottie::Surface(expected.data(), 100, 100, 400));
+    }
+    auto stats = animation->frameCacheStats();
+    ASSERT_EQ(stats.hits, 0);
+    ASSERT_EQ(stats.frames, animation->totalFrame());
+
+    // second loop is served from the cache.
+    std::fill(result.begin(), result.end(), 0xffffffff);
+    animation->renderSync(animation->totalFrame() - 1,
+                          rlottie::Surface(result.data(), 100, 100, 400));
+    ASSERT_EQ(animation->frameCacheStats().hits, 1);
+    ASSERT_EQ(expected, result);
+
+    animation->setValue<rlottie::Property::FillColor>("**", rlottie::Color(1, 0, 0));
+    ASSERT_EQ(animation->frameCacheStats().frames, 0);
+
+    animation->setFrameCacheBudget(0);
+    ASSERT_EQ(animation->frameCacheStats().bytes, 0);
+}
+
+TEST_F(AnimationTest, frameCacheCallback) {
+    load("done.json");
+    animation->setFrameCacheBudget(64 * 1024 * 1024);
+
+    size_t calls = 0;
+    float  red = 1;
+    animation->setValue<rlottie::Property::FillColor>("**",
+        [&calls, &red](const rlottie::FrameInfo &) {
+            calls++;
+            return rlottie::Color(red, 0, 0);
+        });
+    reference->setValue<rlottie::Property::FillColor>("**", rlottie::Color(1, 0, 0));
+
+    const size_t frame = animation->totalFrame() / 2;
+    ASSERT_EQ(render(*reference, frame), render(*animation, frame));
+
+    // the same frame is rendered again with what the callback returns now.
+    size_t first = calls;
+    red = 0;
+    reference->setValue<rlottie::Property::FillColor>("**", rlottie::Color(0, 0, 0));
+    ASSERT_EQ(render(*reference, frame), render(*animation, frame));
+    ASSERT_GT(calls, first);
+
+    auto stats = animation->frameCacheStats();
+    ASSERT_EQ(stats.hits, 0);
+    ASSERT_EQ(stats.frames, 0);
+}
+
+TEST_F(AnimationTest, trimMemory) {
+    ASSERT_TRUE(animation != nullptr);
+    animation->setFrameCacheBudget(1024 * 1024);
+    animation->setValue<rlottie::Property::FillColor>("**", rlottie::Color(1, 0, 0));
+
+    auto expected = render(*animation, 10);
+    auto stats = rlottie::memoryStats();
+    ASSERT_GT(stats.frameCaches, 0);
+    ASSERT_GT(stats.total, 0);
+
+    rlottie::trimMemory(rlottie::TrimLevel::All);
+    stats = rlottie::memoryStats();
+    ASSERT_EQ(stats.models, 0);
+    ASSERT_EQ(stats.surfaces, 0);
+    ASSERT_EQ(stats.rasterCaches, 0);
+    ASSERT_EQ(stats.frameCaches, 0);
+
+    // the render tree is rebuilt with the values set before the trim.
+    ASSERT_EQ(expected, render(*animation, 10));
+    ASSERT_EQ(animation->frameCacheStats().misses, 2);
+}
+
+TEST_F(AnimationTest, memoryBudget) {
+    ASSERT_TRUE(animation != nullptr);
+    std::vector<uint32_t> buffer(100 * 100);
+    rlottie::Surface surface(buffer.data(), 100, 100, 400);
+
+    // rles left once the render tree is dropped.
+    animation->renderSync(0, surface);
+    rlottie::trimMemory(rlottie::TrimLevel::All);
+    size_t dropped = rlottie::memoryStats().rles;
+
+    // every new frame grows the frame cache past the budget, the budget
+    // trims the caches but keeps the render tree.
+    animation->setFrameCacheBudget(1024 * 1024);
+    rlottie::configureMemoryBudget(1);
+    for (size_t i = 0; i < animation->totalFrame(); i++) {
+        animation->renderSync(i, surface);
+        ASSERT_GT(rlottie::memoryStats().rles, dropped);
+    }
+    rlottie::configureMemoryBudget(0);
+}
+
+TEST_F(AnimationTest, renderDamage) {
+    load("mask.json");
+
+    std::vector<uint32_t> result(100 * 100, 0xffffffff);
+    rlottie::Surface surface(result.data(), 100, 100, 400);
+    rlottie::DamageRect damage;
+
+    // first frame repaints the whole surface.
+    animation->renderSync(0, surface, damage);
+    ASSERT_EQ(damage.x, 0);
+    ASSERT_EQ(damage.y, 0);
+    ASSERT_EQ(damage.w, 100);
+    ASSERT_EQ(damage.h, 100);
+
+    // same frame again changes nothing.
+    animation->renderSync(0, surface, damage);
+    ASSERT_EQ(damage.w * damage.h, 0);
+
+    for (size_t i = 1; i < animation->totalFrame(); i++) {
+        animation->renderSync(i, surface, damage);
+        ASSERT_LE(damage.x + damage.w, 100);
+        ASSERT_LE(damage.y + damage.h, 100);
+    }
+    ASSERT_EQ(render(*reference, animation->totalFrame() - 1), result);
+
+    // a partial redraw matches the full render, gradients and raster
+    // cached layers included.
+    for (auto name : {"birth_stone_logo.json", "insta_camera.json"}) {
+        load(name);
+        for (size_t i = 0; i < animation->totalFrame(); i++) {
+            animation->renderSync(i, surface, damage);
+            ASSERT_EQ(render(*reference, i), result) << name << " frame " << i;
+        }
+    }
+}
+
+TEST_F(AnimationTest, clone) {
+    ASSERT_TRUE(animation != nullptr);
+    animation->setValue<rlottie::Property::FillColor>("**", rlottie::Color(1, 0, 0));
+
+    const size_t frames = animation->totalFrame();
+    std::vector<std::vector<uint32_t>> expected(frames), result(frames);
+    for (size_t i = 0; i < frames; i++) expected[i] = render(*animation, i);
+
+    // every clone renders every other frame at the same time.
+    const size_t count = 4;
+    std::vector<std::thread> threads;
+    for (size_t c = 0; c < count; c++) {
+        std::shared_ptr<rlottie::Animation> copy = animation->clone();
+        ASSERT_TRUE(copy != nullptr);
+        threads.emplace_back([copy, c, count, frames, &result]() {
+            for (size_t i = c; i < frames; i += count) {
+                result[i].resize(100 * 100);
+                copy->renderSync(i, rlottie::Surface(result[i].data(), 100, 100, 400));
+            }
+        });
+    }
+    for (auto &t : threads) t.join();
+
+    ASSERT_EQ(expected, result);
+}
+
+TEST_F(AnimationTest, renderThreads) {
+    load("mask.json");
+    animation->setRenderThreads(4);
+
+    for (size_t i = 0; i < animation->totalFrame(); i++) {
+        ASSERT_EQ(render(*reference, i, 400, 400), render(*animation, i, 400, 400));
+    }
+}
+
+TEST_F(AnimationTest, surfaceCacheBudget) {
+    load("a_mountain.json");
+    // no surface fits, every offscreen gets allocated again.
+    animation->setSurfaceCacheBudget(1);
+
+    for (size_t i = 0; i < animation->totalFrame(); i++) {
+        ASSERT_EQ(render(*reference, i, 200, 200), render(*animation, i, 200, 200));
+    }
+}
+
+TEST_F(AnimationTest, dynamicValueUpdate) {
+    load("done.json");
+    reference->setValue<rlottie::Property::FillColor>("**", rlottie::Color(1, 0, 0));
+
+    const size_t frame = animation->totalFrame() / 2;
+    auto expected = render(*reference, frame);
+    ASSERT_NE(expected, render(*animation, frame));
+
+    // a value set after the frame got rendered shows up on the same frame.
+    animation->setValue<rlottie::Property::FillColor>("**", rlottie::Color(1, 0, 0));
+    ASSERT_EQ(expected, render(*animation, frame));
+
+    // a callback is asked for its value on every render.
+    size_t calls = 0;
+    animation->setValue<rlottie::Property::FillColor>("**",
+        [&calls](const rlottie::FrameInfo &) {
+            calls++;
+            return rlottie::Color(1, 0, 0);
+        });
+    render(*animation, frame);
+    size_t first = calls;
+    ASSERT_GT(first, 0);
+    ASSERT_EQ(expected, render(*animation, frame));
+    ASSERT_GT(calls, first);
+}
+
+TEST_F(AnimationTest, offscreenCulling) {
+    load("done.json");
+
+    float offset = 0;
+    animation->setValue<rlottie::Property::TrPosition>("**",
+        [&offset](const rlottie::FrameInfo &) {
+            return rlottie::Point(50 + offset, 50);
+        });
+    reference->setValue<rlottie::Property::TrPosition>("**", rlottie::Point(50, 50));
+
+    const size_t frame = animation->totalFrame() / 2;
+    std::vector<uint32_t> empty(100 * 100, 0);
+    auto expected = render(*reference, frame);
+    ASSERT_EQ(expected, render(*animation, frame));
+    ASSERT_NE(empty, expected);
+
+    // moved out of the surface nothing is drawn.
+    offset = 10000;
+    ASSERT_EQ(empty, render(*animation, frame));
+
+    // and once back it renders like it never left.
+    offset = 0;
+    ASSERT_EQ(expected, render(*animation, frame));
+}
+
+// static layers are drawn from their raster cache, a callback value keeps
+// the reference drawing them fresh. Blending the cached bitmap as a whole
+// rounds a little different from blending the drawables one by one.
+TEST_F(AnimationTest, rasterCache) {
+    load("emoji_wink.json");
+    reference->setValue<rlottie::Property::TrOpacity>("**",
+        [](const rlottie::FrameInfo &) { return 100.0f; });
+
+    for (size_t i = 0; i < animation->totalFrame(); i++) {
+        ASSERT_LE(maxDiff(render(*reference, i), render(*animation, i)), 2)
+            << "frame " << i;
+    }
+    ASSERT_GT(rlottie::memoryStats().rasterCaches, 0);
+
+    // a new value drops the cache, the layers render like a fresh load
+    // with the value set.
+    const size_t frame = animation->totalFrame() / 2;
+    auto before = render(*animation, frame);
+    animation->setValue<rlottie::Property::FillColor>("**",
+                                                      rlottie::Color(0, 0, 1));
+    auto fresh = rlottie::Animation::loadFromFile(
+        std::string(DEMO_DIR) + "emoji_wink.json", false);
+    ASSERT_TRUE(fresh != nullptr);
+    fresh->setValue<rlottie::Property::FillColor>("**", rlottie::Color(0, 0, 1));
+    auto expected = render(*fresh, frame);
+    ASSERT_NE(before, expected);
+    ASSERT_EQ(expected, render(*animation, frame));
+    // and the second render builds it again.
+    ASSERT_LE(maxDiff(expected, render(*animation, frame)), 2);
+
+    // so does a new size.
+    fresh = rlottie::Animation::loadFromFile(
+        std::string(DEMO_DIR) + "emoji_wink.json", false);
+    fresh->setValue<rlottie::Property::FillColor>("**", rlottie::Color(0, 0, 1));
+    ASSERT_EQ(render(*fresh, frame, 150, 150),
+              render(*animation, frame, 150, 150));
+}
+
+// a draw region places the animation inside a bigger surface, the matte
+// buffers cut to the content have to follow the offset. Nothing is drawn
+// outside of the region.
+TEST_F(AnimationTest, drawRegionMatte) {
+    load("insta_camera.json");
+
+    const size_t width = 141, height = 145;
+    for (size_t i = 0; i < animation->totalFrame(); i += 8) {
+        for (auto offset : {std::make_pair(30, 20), std::make_pair(0, 45),
+                            std::make_pair(41, 0)}) {
+            // rendered as often as the animation so both draw the same
+            // layers from their raster caches.
+            auto full = render(*reference, i);
+            size_t ox = offset.first, oy = offset.second;
+            std::vector<uint32_t> buffer(width * height, 0xdeadbeef);
+            rlottie::Surface surface(buffer.data(), width, height, width * 4);
+            surface.setDrawRegion(ox, oy, 100, 100);
+            animation->renderSync(i, surface);
+            for (size_t y = 0; y < height; y++) {
+                for (size_t x = 0; x < width; x++) {
+                    bool inside = x >= ox && x < ox + 100 && y >= oy &&
+                                  y < oy + 100;
+                    ASSERT_EQ(inside ? full[(y - oy) * 100 + x - ox] : 0,
+                              buffer[y * width + x])
+                        << "frame " << i << " pixel " << x << "," << y;
+                }
+            }
+        }
+    }
+}
+
+// a single drawable under a solid alpha matte is drawn with the matte
+// coverage as clip, wrapped in a precomp it goes through the matte
+// buffers instead. Both have to agree up to rounding.
+TEST_F(AnimationTest, rleMatte) {
+    auto transform = [](const std::string &rotation, int position) {
+        auto p = std::to_string(position);
+        return "\"ks\":{\"o\":{\"a\":0,\"k\":100},\"r\":" + rotation +
+               ",\"p\":{\"a\":0,\"k\":[" + p + "," + p + "]},"
+               "\"a\":{\"a\":0,\"k\":[0,0]},\"s\":{\"a\":0,\"k\":[100,100]}}";
+    };
+    const std::string still = "{\"a\":0,\"k\":0}";
+    const std::string turning =
+        "{\"a\":1,\"k\":[{\"t\":0,\"s\":[0],\"e\":[90],"
+        "\"i\":{\"x\":[0.5],\"y\":[0.5]},\"o\":{\"x\":[0.5],\"y\":[0.5]}},"
+        "{\"t\":30}]}";
+    const std::string matte =
+        "{\"ty\":4,\"ind\":1,\"td\":1,\"ip\":0,\"op\":30,\"st\":0," +
+        transform(still, 50) +
+        ",\"shapes\":[{\"ty\":\"el\",\"p\":{\"a\":0,\"k\":[0,0]},"
+        "\"s\":{\"a\":0,\"k\":[70,70]}},{\"ty\":\"fl\","
+        "\"c\":{\"a\":0,\"k\":[1,1,1,1]},\"o\":{\"a\":0,\"k\":60}}]}";
+    const std::string shape =
+        "\"ip\":0,\"op\":30,\"st\":0," + transform(turning, 50) +
+        ",\"shapes\":[{\"ty\":\"rc\",\"p\":{\"a\":0,\"k\":[0,0]},"
+        "\"s\":{\"a\":0,\"k\":[60,60]},\"r\":{\"a\":0,\"k\":0}},"
+        "{\"ty\":\"fl\",\"c\":{\"a\":0,\"k\":[0.9,0.3,0.1,1]},"
+        "\"o\":{\"a\":0,\"k\":100}}]";
+    auto compose = [&](int matteType, bool precomp) {
+        std::string layers = "[" + matte + ",";
+        std::string assets = "[]";
+        if (precomp) {
+            layers += "{\"ty\":0,\"ind\":2,\"tt\":" + std::to_string(matteType) +
+                      ",\"refId\":\"shape\",\"w\":100,\"h\":100,\"ip\":0,"
+                      "\"op\":30,\"st\":0," + transform(still, 0) + "}]";
+            assets = "[{\"id\":\"shape\",\"layers\":[{\"ty\":4,\"ind\":1," +
+                     shape + "}]}]";
+        } else {
+            layers += "{\"ty\":4,\"ind\":2,\"tt\":" +
+                      std::to_string(matteType) + "," + shape + "}]";
+        }
+        return "{\"v\":\"5.5.2\",\"fr\":30,\"ip\":0,\"op\":30,\"w\":100,"
+               "\"h\":100,\"assets\":" + assets + ",\"layers\":" + layers +
+               "}";
+    };
+
+    // 1: alpha, 2: alpha inverted.
+    for (int matteType : {1, 2}) {
+        auto rle = rlottie::Animation::loadFromData(
+            compose(matteType, false), "rleMatte", "", false);
+        auto bitmap = rlottie::Animation::loadFromData(
+            compose(matteType, true), "rleMatteBitmap", "", false);
+        ASSERT_TRUE(rle != nullptr);
+        ASSERT_TRUE(bitmap != nullptr);
+
+        std::vector<uint32_t> empty(100 * 100, 0);
+        for (size_t i = 0; i < rle->totalFrame(); i += 5) {
+            auto fast = render(*rle, i);
+            auto slow = render(*bitmap, i);
+            ASSERT_NE(empty, fast);
+            ASSERT_LE(maxDiff(fast, slow), 6)
+                << "matte " << matteType << " frame " << i;
+        }
+    }
+}
+
+TEST_F(AnimationTest, keyPathHandle) {
+    load("done.json");
+    ASSERT_FALSE(animation->resolveKeyPath("").valid());
+
+    auto fill = animation->resolveKeyPath("**");
+    ASSERT_TRUE(fill.valid());
+
+    const size_t frame = animation->totalFrame() / 2;
+
+    animation->setValue<rlottie::Property::FillColor>(fill, rlottie::Color(0, 0, 1));
+    reference->setValue<rlottie::Property::FillColor>("**", rlottie::Color(0, 0, 1));
+    ASSERT_EQ(render(*reference, frame), render(*animation, frame));
+
+    rlottie::ValueBatch batch;
+    batch.setValue<rlottie::Property::FillColor>(fill, rlottie::Color(0, 1, 0))
+         .setValue<rlottie::Property::FillOpacity>(fill, 50.0f);
+    ASSERT_EQ(batch.size(), 2);
+    animation->setValues(batch);
+    reference->setValue<rlottie::Property::FillColor>("**", rlottie::Color(0, 1, 0));
+    reference->setValue<rlottie::Property::FillOpacity>("**", 50.0f);
+    ASSERT_EQ(render(*reference, frame), render(*animation, frame));
+
+    // the last value of a property in a batch wins, also through an alias.
+    auto alias = animation->resolveKeyPath("**");
+    ASSERT_TRUE(alias.valid());
+    batch.clear();
+    batch.setValue<rlottie::Property::FillColor>(alias, rlottie::Color(1, 1, 0))
+         .setValue<rlottie::Property::FillColor>(fill, rlottie::Color(0, 1, 1));
+    animation->setValues(batch);
+    reference->setValue<rlottie::Property::FillColor>("**", rlottie::Color(0, 1, 1));
+    ASSERT_EQ(render(*reference, frame), render(*animation, frame));
+
+    // handles stay valid for a clone.
+    auto copy = animation->clone();
+    copy->setValue<rlottie::Property::FillColor>(fill, rlottie::Color(1, 0, 0));
+    reference->setValue<rlottie::Property::FillColor>("**", rlottie::Color(1, 0, 0));
+    ASSERT_EQ(render(*reference, frame), render(*copy, frame));
+}
+
+#ifdef LOTTIE_PROFILE_SUPPORT
+// the counters are only collected with the profile option.
+TEST_F(AnimationTest, frameStats) {
+    ASSERT_TRUE(animation != nullptr);
+    render(*animation, 10);
+    auto stats = animation->frameStats();
+    ASSERT_GT(stats.drawables, 0);
+    ASSERT_GT(stats.spans, 0);
+    ASSERT_GT(stats.pixels, 0);
+
+    // every frame has a solid alpha matte over a single drawable.
+    load("bell.json");
+    render(*animation, 10);
+    ASSERT_GT(animation->frameStats().rleMattes, 0);
+
+    // parts of the tractor leave the surface now and then.
+    load("tractor.json");
+    size_t culledLayers = 0, culledDrawables = 0;
+    for (size_t i = 0; i < animation->totalFrame(); i++) {
+        render(*animation, i);
+        culledLayers += animation->frameStats().culledLayers;
+        culledDrawables += animation->frameStats().culledDrawables;
+    }
+    ASSERT_GT(culledLayers, 0);
+    ASSERT_GT(culledDrawables, 0);
+}
+
+// just enough of a json parser to tell a well formed document.
+class JsonChecker {
+public:
+    explicit JsonChecker(const std::string &text) : mText(text) {}
+    bool document() { return value() && (space(), mPos == mText.size()); }
+
+private:
+    void space()
+    {
+        while (mPos < mText.size() && strchr(" \t\r\n", mText[mPos])) mPos++;
+    }
+    bool take(char c)
+    {
+        space();
+        if (mPos < mText.size() && mText[mPos] == c) return ++mPos;
+        return false;
+    }
+    bool string()
+    {
+        if (!take('"')) return false;
+        while (mPos < mText.size() && mText[mPos] != '"') {
+            if (uint8_t(mText[mPos]) < 0x20) return false;
+            if (mText[mPos] == '\\') mPos++;
+            mPos++;
+        }
+        return mPos++ < mText.size();
+    }
+    bool number()
+    {
+        size_t start = mPos;
+        if (mPos < mText.size() && mText[mPos] == '-') mPos++;
+        while (mPos < mText.size() && strchr("0123456789.eE+-", mText[mPos]))
+            mPos++;
+        return mPos > start && isdigit(uint8_t(mText[mPos - 1]));
+    }
+    bool value()
+    {
+        space();
+        if (mPos >= mText.size()) return false;
+        switch (mText[mPos]) {
+        case '{':
+            mPos++;
+            if (take('}')) return true;
+            do {
+                if (!string() || !take(':') || !value()) return false;
+            } while (take(','));
+            return take('}');
+        case '[':
+            mPos++;
+            if (take(']')) return true;
+            do {
+                if (!value()) return false;
+            } while (take(','));
+            return take(']');
+        case '"':
+            return string();
+        default:
+            for (auto word : {"true", "false", "null"}) {
+                if (!mText.compare(mPos, strlen(word), word)) {
+                    mPos += strlen(word);
+                    return true;
+                }
+            }
+            return number();
+        }
+    }
+
+    const std::string &mText;
+    size_t             mPos{0};
+};
+
+TEST_F(AnimationTest, trace) {
+    const std::string path = "rlottie_test_trace.json";
+    ASSERT_TRUE(rlottie::startTrace(path));
+    ASSERT_FALSE(rlottie::startTrace(path));
+
+    animation->setRenderThreads(2);
+    for (size_t i = 0; i < animation->totalFrame(); i++) render(*animation, i);
+    ASSERT_TRUE(rlottie::stopTrace());
+    ASSERT_FALSE(rlottie::stopTrace());
+
+    std::ifstream     file(path);
+    std::stringstream text;
+    text << file.rdbuf();
+    std::remove(path.c_str());
+
+    ASSERT_TRUE(JsonChecker(text.str()).document());
+    ASSERT_NE(text.str().find("\"name\":\"update\""), std::string::npos);
+    ASSERT_NE(text.str().find("\"ph\":\"X\""), std::string::npos);
+}
+#endif
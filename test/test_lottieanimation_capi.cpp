@@ -1,4 +1,6 @@
 #include <gtest/gtest.h>
+#include <vector>
+#include "config.h"
 #include "rlottie_capi.h"
 
 class AnimationCApiTest : public ::testing::Test {
@@ -32,3 +34,40 @@ TEST_F(AnimationCApiTest, loadFromFile) {
     ASSERT_EQ(width, 500);
     ASSERT_EQ(height, 500);
 }
+
+TEST_F(AnimationCApiTest, modelCacheStats) {
+    std::string filePath = DEMO_DIR;
+    filePath += "3d.json";
+    lottie_configure_model_cache_size(0);
+    lottie_configure_model_cache_size(2);
+
+    size_t hits, misses, entries, bytes;
+    lottie_model_cache_stats(&hits, &misses, nullptr, nullptr, nullptr);
+    for (int i = 0; i < 2; i++) {
+        auto anim = lottie_animation_from_file(filePath.c_str());
+        ASSERT_TRUE(anim);
+        lottie_animation_destroy(anim);
+    }
+    size_t newHits, newMisses;
+    lottie_model_cache_stats(&newHits, &newMisses, nullptr, &entries, &bytes);
+    ASSERT_EQ(newHits - hits, 1);
+    ASSERT_EQ(newMisses - misses, 1);
+    ASSERT_EQ(entries, 1);
+    ASSERT_GT(bytes, 0);
+
+    lottie_configure_model_cache_size(10);
+}
+
+#ifdef LOTTIE_PROFILE_SUPPORT
+TEST_F(AnimationCApiTest, frameStats) {
+    ASSERT_TRUE(animation);
+    std::vector<uint32_t> buffer(100 * 100);
+    lottie_animation_render(animation, 10, buffer.data(), 100, 100, 400);
+
+    Lottie_Frame_Stats stats;
+    lottie_animation_get_frame_stats(animation, &stats);
+    ASSERT_GT(stats.drawables, 0);
+    ASSERT_GT(stats.spans, 0);
+    ASSERT_GT(stats.pixels, 0);
+}
+#endif
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "lottiemodel.h"
+
+using namespace rlottie::internal;
+
+using FloatFrames = model::KeyFrames<float, void>;
+
+class KeyFramesTest : public ::testing::Test {
+public:
+    void SetUp()
+    {
+        // a gap between 20 and 30 and a one frame long keyframe.
+        for (auto range : {std::make_pair(0, 10), std::make_pair(10, 20),
+                           std::make_pair(30, 45), std::make_pair(45, 46),
+                           std::make_pair(60, 100)}) {
+            FloatFrames::Frame frame;
+            frame.start_ = float(range.first);
+            frame.end_ = float(range.second);
+            frames.frames_.push_back(frame);
+        }
+    }
+    int linearScan(int frameNo) const
+    {
+        for (size_t i = 0; i < frames.frames_.size(); i++) {
+            const auto &frame = frames.frames_[i];
+            if (frameNo >= frame.start_ && frameNo < frame.end_) return int(i);
+        }
+        return -1;
+    }
+public:
+    FloatFrames frames;
+};
+
+TEST_F(KeyFramesTest, frameIndexForward) {
+    for (int frameNo = -10; frameNo < 110; frameNo++)
+        ASSERT_EQ(linearScan(frameNo), frames.frameIndex(frameNo)) << frameNo;
+}
+
+TEST_F(KeyFramesTest, frameIndexBackward) {
+    for (int frameNo = 110; frameNo >= -10; frameNo--)
+        ASSERT_EQ(linearScan(frameNo), frames.frameIndex(frameNo)) << frameNo;
+}
+
+TEST_F(KeyFramesTest, frameIndexSeek) {
+    std::mt19937                       rng(1234);
+    std::uniform_int_distribution<int> frame(-10, 110);
+    for (int i = 0; i < 1000; i++) {
+        int frameNo = frame(rng);
+        ASSERT_EQ(linearScan(frameNo), frames.frameIndex(frameNo)) << frameNo;
+    }
+    // the boundaries, out of order.
+    for (int frameNo : {100, 0, 99, 20, 19, 30, 46, 45, 60, 59, -1, 10, 9})
+        ASSERT_EQ(linearScan(frameNo), frames.frameIndex(frameNo)) << frameNo;
+}
@@ -0,0 +1,322 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "vdrawhelper.h"
+
+class VDrawHelperTest : public ::testing::Test {
+public:
+    void SetUp()
+    {
+        std::mt19937 rng(1234);
+        src.resize(size);
+        dest.resize(size);
+        for (auto &p : src) p = pixel(rng);
+        for (auto &p : dest) p = pixel(rng);
+
+        uint32_t cpu = vCpuFeatures();
+        if (cpu & CpuFeature::SSE2) features.push_back(CpuFeature::SSE2);
+        if (cpu & CpuFeature::NEON) features.push_back(CpuFeature::NEON);
+        if (cpu & CpuFeature::AVX2) features.push_back(cpu);
+    }
+    // premultiplied pixels with runs of transparent and opaque ones
+    static uint32_t pixel(std::mt19937 &rng)
+    {
+        uint32_t r = rng();
+        switch (r % 4) {
+        case 0:
+            return 0;
+        case 1:
+            return r | 0xff000000;
+        default: {
+            uint32_t a = r >> 24;
+            return (a << 24) | (((r >> 16) & 0xff) * a / 255) << 16 |
+                   (((r >> 8) & 0xff) * a / 255) << 8 | (r & 0xff) * a / 255;
+        }
+        }
+    }
+    // channels may differ by tolerance
+    static void expectNear(const std::vector<uint32_t> &expect,
+                           const std::vector<uint32_t> &result, int tolerance)
+    {
+        for (size_t i = 0; i < expect.size(); i++) {
+            for (int shift = 0; shift < 32; shift += 8) {
+                int e = (expect[i] >> shift) & 0xff;
+                int r = (result[i] >> shift) & 0xff;
+                ASSERT_LE(std::abs(e - r), tolerance) << "pixel " << i;
+            }
+        }
+    }
+    void compare(const RenderFuncTable &simd, BlendMode mode, int tolerance)
+    {
+        for (uint32_t alpha : {0, 1, 127, 128, 254, 255}) {
+            for (int offset = 0; offset < 8; offset++) {
+                for (int length = 0; length < 70; length++) {
+                    std::vector<uint32_t> expect(dest), result(dest);
+                    uint32_t color = src[offset + length];
+
+                    scalar.color(mode)(&expect[offset], length, color, alpha);
+                    simd.color(mode)(&result[offset], length, color, alpha);
+                    expectNear(expect, result, tolerance);
+                    result = expect;
+
+                    scalar.src(mode)(&expect[offset], length,
+                                     &src[7 - offset], alpha);
+                    simd.src(mode)(&result[offset], length, &src[7 - offset],
+                                   alpha);
+                    expectNear(expect, result, tolerance);
+                }
+            }
+        }
+    }
+public:
+    const size_t          size{128};
+    std::vector<uint32_t> src;
+    std::vector<uint32_t> dest;
+    std::vector<uint32_t> features;
+    RenderFuncTable       scalar{0};
+};
+
+TEST_F(VDrawHelperTest, blendFunctions) {
+    for (uint32_t f : features) {
+        SCOPED_TRACE(f);
+        RenderFuncTable simd(f);
+        // the sse2 interpolation rounds differently, avx2 is exact.
+        int tolerance = (f & CpuFeature::AVX2) ? 0 : 1;
+        compare(simd, BlendMode::Src, tolerance);
+        compare(simd, BlendMode::SrcOver, tolerance);
+        compare(simd, BlendMode::DestIn, tolerance);
+        compare(simd, BlendMode::DestOut, tolerance);
+        // the luma of the simd versions is exact.
+        compare(simd, BlendMode::DestInLuma, 0);
+        compare(simd, BlendMode::DestOutLuma, 0);
+    }
+}
+
+TEST_F(VDrawHelperTest, transparentSourceOver) {
+    std::vector<RenderFuncTable> tables{scalar};
+    for (uint32_t f : features) tables.emplace_back(f);
+
+    // a transparent pixel leaves dest as is, whatever the const alpha.
+    std::vector<uint32_t> transparent(size, 0);
+    for (const auto &table : tables) {
+        for (uint32_t alpha : {1, 127, 128, 254, 255}) {
+            std::vector<uint32_t> result(dest);
+            table.src(BlendMode::SrcOver)(result.data(), int(size),
+                                          transparent.data(), alpha);
+            ASSERT_EQ(dest, result) << "alpha " << alpha;
+        }
+    }
+}
+
+// an Alpha8 target keeps the alpha channel an ARGB32 target would get, for
+// every brush and blend mode a matte is drawn with.
+TEST_F(VDrawHelperTest, alpha8) {
+    const int width = 16, height = int(size) / width;
+
+    VBitmap texture(width, height, VBitmap::Format::ARGB32_Premultiplied);
+    for (int y = 0; y < height; y++)
+        memcpy(texture.data() + y * texture.stride(), &src[y * width],
+               width * sizeof(uint32_t));
+
+    VGradientStops stops{{0.0f, VColor(255, 0, 0, 0)},
+                         {0.4f, VColor(0, 255, 0, 130)},
+                         {1.0f, VColor(0, 0, 255, 255)}};
+    VGradient linear(VGradient::Type::Linear);
+    linear.linear = {1, 0, 14, 7};
+    linear.setStops(stops);
+    VGradient radial(VGradient::Type::Radial);
+    radial.radial = {8, 4, 6, 3, 9, 1};
+    radial.setStops(stops);
+    VTexture plain{texture, VMatrix(), 255};
+    VTexture scaled{texture, VMatrix().scale(1.5f, 0.75f), 200};
+
+    const std::vector<VBrush> brushes{VBrush(VColor(20, 40, 60, 180)),
+                                      VBrush(&linear), VBrush(&radial),
+                                      VBrush(&plain), VBrush(&scaled)};
+
+    std::vector<VRle::Span> spans;
+    const uint8_t           coverage[] = {255, 128, 1, 254, 0, 77};
+    for (int y = 0; y < height; y++) {
+        spans.push_back({short(y % 3), short(y), uint16_t(7 - y % 3),
+                         coverage[y % 6]});
+        spans.push_back({short(8 + y % 2), short(y), uint16_t(8 - y % 2),
+                         coverage[(y + 1) % 6]});
+    }
+
+    for (auto mode : {BlendMode::Src, BlendMode::SrcOver, BlendMode::DestIn,
+                      BlendMode::DestOut}) {
+        for (size_t b = 0; b < brushes.size(); b++) {
+            SCOPED_TRACE(b);
+            VBitmap argb(width, height, VBitmap::Format::ARGB32_Premultiplied);
+            VBitmap alpha(width, height, VBitmap::Format::Alpha8);
+            for (int y = 0; y < height; y++) {
+                auto line = reinterpret_cast<uint32_t *>(argb.data() +
+                                                         y * argb.stride());
+                for (int x = 0; x < width; x++) {
+                    line[x] = dest[y * width + x];
+                    alpha.data()[y * alpha.stride() + x] =
+                        uint8_t(vAlpha(line[x]));
+                }
+            }
+
+            for (auto bitmap : {&argb, &alpha}) {
+                VRasterBuffer buffer;
+                buffer.prepare(bitmap);
+                VSpanData data;
+                data.init(&buffer);
+                data.mBlendMode = mode;
+                data.setup(brushes[b]);
+                ASSERT_TRUE(data.mUnclippedBlendFunc);
+                data.mUnclippedBlendFunc(spans.size(), spans.data(), &data);
+            }
+
+            for (int y = 0; y < height; y++) {
+                auto line = reinterpret_cast<uint32_t *>(argb.data() +
+                                                         y * argb.stride());
+                for (int x = 0; x < width; x++) {
+                    ASSERT_EQ(vAlpha(line[x]),
+                              alpha.data()[y * alpha.stride() + x])
+                        << "mode " << int(mode) << " pixel " << x << "," << y;
+                }
+            }
+        }
+    }
+}
+
+// a gradient that only changes along x is fetched once for all the rows,
+// spans more than a row buffer apart are fetched one by one. Both give the
+// same pixels.
+TEST_F(VDrawHelperTest, linearGradientRows) {
+    const int width = 2100, height = 6;
+
+    VGradient gradient(VGradient::Type::Linear);
+    gradient.linear = {13, 0, 1700, 0};
+    gradient.setStops({{0.0f, VColor(255, 0, 0, 255)},
+                       {0.3f, VColor(0, 255, 0, 90)},
+                       {1.0f, VColor(0, 0, 255, 255)}});
+    gradient.mSpread = VGradient::Spread::Reflect;
+    VBrush brush(&gradient);
+
+    std::vector<VRle::Span> spans;
+    for (int y = 0; y < height; y++) {
+        spans.push_back({short(y * 7), short(y), uint16_t(300 + y * 250),
+                         uint8_t(255 - y * 40)});
+    }
+    auto blend = [&](const std::vector<VRle::Span> &list) {
+        VBitmap bitmap(width, height, VBitmap::Format::ARGB32_Premultiplied);
+        memset(bitmap.data(), 0, bitmap.stride() * height);
+        VRasterBuffer buffer;
+        buffer.prepare(&bitmap);
+        VSpanData data;
+        data.init(&buffer);
+        data.setup(brush);
+        data.mUnclippedBlendFunc(list.size(), list.data(), &data);
+        std::vector<uint32_t> pixels(width * height);
+        for (int y = 0; y < height; y++) {
+            memcpy(&pixels[y * width], bitmap.data() + y * bitmap.stride(),
+                   width * sizeof(uint32_t));
+        }
+        return pixels;
+    };
+
+    auto rows = blend(spans);
+    auto far = spans;
+    far.push_back({short(width - 10), short(0), uint16_t(10), uint8_t(255)});
+    auto single = blend(far);
+    for (int x = width - 10; x < width; x++) single[x] = 0;
+    ASSERT_EQ(rows, single);
+
+    // the row starts where the leftmost span starts.
+    std::vector<uint32_t> each(rows.size(), 0);
+    for (const auto &span : spans) {
+        auto one = blend({span});
+        auto offset = span.y * width + span.x;
+        std::copy_n(one.begin() + offset, span.len, each.begin() + offset);
+    }
+    ASSERT_EQ(rows, each);
+}
+
+TEST_F(VDrawHelperTest, memfill) {
+    for (int offset = 0; offset < 8; offset++) {
+        for (int length = 0; length < 70; length++) {
+            std::vector<uint32_t> expect(dest), result(dest);
+            std::fill_n(&expect[offset], length, 0xdeadbeef);
+            memfill32(&result[offset], 0xdeadbeef, length);
+            ASSERT_EQ(expect, result);
+#if defined(VDRAWHELPER_AVX2)
+            if (vCpuFeatures() & CpuFeature::AVX2) {
+                result = dest;
+                memfill32_avx2(&result[offset], 0xdeadbeef, length);
+                ASSERT_EQ(expect, result);
+            }
+#endif
+        }
+    }
+}
+
+TEST_F(VDrawHelperTest, linearGradient) {
+    std::vector<uint32_t> table(VGradient::colorTableSize);
+    for (size_t i = 0; i < table.size(); i++) table[i] = uint32_t(i);
+    VGradientData gradient;
+    gradient.mColorTable = table.data();
+
+    for (auto spread : {VGradient::Spread::Pad, VGradient::Spread::Repeat,
+                        VGradient::Spread::Reflect}) {
+        gradient.mSpread = spread;
+        for (uint32_t f : features) {
+            SCOPED_TRACE(f);
+            RenderFuncTable simd(f);
+            for (int t : {-600000, -1000, 0, 77, 130000, 600000}) {
+                for (int inc : {-3000, -256, -5, 0, 1, 100, 256, 4000}) {
+                    for (int length = 0; length < 40; length++) {
+                        std::vector<uint32_t> expect(dest), result(dest);
+                        scalar.linear()(expect.data(), length, &gradient, t,
+                                        inc);
+                        simd.linear()(result.data(), length, &gradient, t,
+                                      inc);
+                        ASSERT_EQ(expect, result);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_F(VDrawHelperTest, radialGradient) {
+    std::vector<uint32_t> table(VGradient::colorTableSize);
+    for (size_t i = 0; i < table.size(); i++) table[i] = uint32_t(i + 1);
+    VGradientData        gradient;
+    RadialGradientValues values;
+    gradient.mColorTable = table.data();
+    gradient.radial.fradius = 0.1f;
+    values.dr = -0.3f;
+
+    std::mt19937                          rng(1234);
+    std::uniform_real_distribution<float> real(-2, 2);
+    for (auto spread : {VGradient::Spread::Pad, VGradient::Spread::Repeat,
+                        VGradient::Spread::Reflect}) {
+        gradient.mSpread = spread;
+        for (bool extended : {false, true}) {
+            values.extended = extended;
+            for (uint32_t f : features) {
+                SCOPED_TRACE(f);
+                RenderFuncTable simd(f);
+                for (int length = 0; length < 40; length++) {
+                    float det = real(rng), delta_det = real(rng) * 0.1f,
+                          delta_delta_det = real(rng) * 0.01f, b = real(rng),
+                          delta_b = real(rng) * 0.1f;
+                    std::vector<uint32_t> expect(dest), result(dest);
+                    scalar.radial()(expect.data(), length, &gradient, &values,
+                                    det, delta_det, delta_delta_det, b,
+                                    delta_b);
+                    simd.radial()(result.data(), length, &gradient, &values,
+                                  det, delta_det, delta_delta_det, b, delta_b);
+                    ASSERT_EQ(expect, result);
+                }
+            }
+        }
+    }
+}
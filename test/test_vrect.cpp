@@ -56,3 +56,12 @@ TEST_F(VRectTest, construct) {
     ASSERT_TRUE(Empty.empty());
     ASSERT_TRUE(illigal.empty());
 }
+
+TEST_F(VRectTest, unite) {
+    VRect r1{0, 0, 10, 10};
+    VRect r2{20, 5, 10, 10};
+    ASSERT_EQ(r1 | r2, VRect(0, 0, 30, 15));
+    ASSERT_EQ(r1 | Empty, r1);
+    ASSERT_EQ(Empty | r2, r2);
+    ASSERT_TRUE((Empty | Empty).empty());
+}